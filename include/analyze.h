@@ -0,0 +1,47 @@
+#ifndef ANALYZE_H
+#define ANALYZE_H
+
+// Batch analysis: the best turn for every position of a file.
+//
+// Positions are read one per line in the notation of position.h, searched
+// by a pool of threads, and answered one line each, in input order:
+//   bestmove <turn> nodes <n>     the turn as Turn_format() writes it,
+//                                 then " alt <turn>" for each runner-up
+//                                 with multiPV above 1, best first
+//   bestmove none                 the player to move has no legal turn
+//   error <reason> at column <n>  the line is not a position
+//
+// One thread reads and the calling thread writes.  Lines travel through a
+// ring of window slots: a slot is only reused once its result has been
+// written, so memory stays bounded however long the input, and a slow
+// position holds back at most window lines behind it.  Each worker keeps
+// its own Search and Game, and so its own evaluation cache.
+
+#include <stdio.h>
+#include "search.h"
+
+typedef struct AnalyzeOptionsStruct {
+    int threads;          // workers, 1 or more
+    int window;           // positions in flight, at least threads
+    SearchLimits limits;  // for every position
+    const struct BookStruct *book; // for every search, if not NULL
+    int endgameStock;     // each worker solves stocks this small (0 = never)
+    int multiPV;          // turns reported per position, 1 to TURN_MAX_TOP
+} AnalyzeOptions;
+
+typedef struct AnalyzeTotalsStruct {
+    uint64_t positions;   // lines read
+    uint64_t errors;      // lines that were not positions
+    uint64_t nodes;
+    uint64_t elapsedNs;
+    SearchStats stats;    // merged over every search
+} AnalyzeTotals;
+
+// One worker per online CPU, a window of 16 lines per worker, no limits,
+// no book, no endgame solver and one turn per position.
+void AnalyzeOptions_init(AnalyzeOptions *options);
+
+// Returns false if the workers cannot be started.
+bool Analyze_run(FILE *in, FILE *out, const AnalyzeOptions *options, AnalyzeTotals *totals);
+
+#endif // ANALYZE_H
@@ -0,0 +1,84 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+// An arena of search tree nodes, for tree searches that build millions of
+// small nodes per decision (Monte Carlo tree search, or a subtree kept from
+// one move to the next while pondering).
+//
+// Nodes all have one size and are named by 32-bit indices rather than
+// pointers, which halves the links and lets the arena move.  Index 0 is
+// never handed out, so ARENA_NULL can mark a missing link.  Allocation
+// bumps a counter, Arena_reset() takes everything back at once, and
+// nothing is freed one node at a time.
+//
+// A node's children are a block of consecutive nodes, named by the index
+// of the first and their number in the ArenaNode the node type starts
+// with.  That is all Arena_keep() needs to know to move the subtree under
+// a node to the front of the arena after a real move: it copies the
+// subtree breadth first into a second mapping, rewriting the links as it
+// goes, and swaps the two, so what is kept ends up packed and in the order
+// a search visits it.
+//
+// The memory is a mapping of the whole capacity (pages.h), which the
+// kernel only backs as it is touched; with hugePages a tree walk misses
+// the TLB far less often.
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define ARENA_NULL 0
+
+typedef uint32_t ArenaIndex;
+
+typedef struct ArenaNodeStruct {
+    ArenaIndex children;   // first of the block, or ARENA_NULL
+    uint32_t numChildren;
+} ArenaNode;
+
+typedef struct ArenaStruct {
+    uint8_t *base;         // node i is at base + i * nodeSize
+    uint8_t *spare;        // Arena_keep()'s copy, mapped on first use
+    size_t nodeSize;
+    size_t mapSize;
+    uint32_t capacity;     // nodes, ARENA_NULL's included
+    uint32_t used;         // nodes handed out, ARENA_NULL's included
+    uint32_t peak;         // most used since Arena_init()
+    bool hugePages;        // asked for
+    bool hugeMapped;       // got from the reserved pool
+} Arena;
+
+// Room for capacity nodes of nodeSize bytes (a multiple of 4, at least
+// sizeof(ArenaNode)).  Returns false if the memory cannot be mapped.
+bool Arena_init(Arena *arena, size_t nodeSize, uint32_t capacity, bool hugePages);
+void Arena_free(Arena *arena);
+
+// Takes back every node.
+static inline void Arena_reset(Arena *arena) {
+    arena->used = 1;
+}
+
+// A block of count consecutive nodes, uninitialized, or ARENA_NULL if the
+// arena is full.
+static inline ArenaIndex Arena_alloc(Arena *arena, uint32_t count) {
+    if (count > arena->capacity - arena->used) {
+        return ARENA_NULL;
+    }
+    ArenaIndex first = arena->used;
+    arena->used += count;
+    if (arena->used > arena->peak) {
+        arena->peak = arena->used;
+    }
+    return first;
+}
+
+static inline void *Arena_node(const Arena *arena, ArenaIndex i) {
+    return arena->base + (size_t)i * arena->nodeSize;
+}
+
+// Moves the subtree under root to the front of the arena and takes back
+// every other node.  Returns the root's new index, or ARENA_NULL if the
+// copy cannot be mapped (the arena is then unchanged).
+ArenaIndex Arena_keep(Arena *arena, ArenaIndex root);
+
+#endif // ARENA_H
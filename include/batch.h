@@ -0,0 +1,65 @@
+#ifndef BATCH_H
+#define BATCH_H
+
+// A batch of games stored as a structure of arrays, played out together
+// with a simple rollout policy.
+//
+// Each field of the game is its own array indexed by game number: hands
+// per player, table runs and sets, discard pile tops, and so on.  The
+// batch advances every game by one phase at a time (draw, meld, discard,
+// end of turn), with the same straight-line bitboard code for every game,
+// so the loops vectorize and no game's branches stall another's.  Games
+// that are over stay in the arrays and are masked out.
+//
+// The rollout policy: take the top discard if it melds at once, otherwise
+// draw; meld every run of three or more, then every set of three or more,
+// then lay off every card the table accepts; discard the highest-ranked
+// card left, preferring ten-point cards.  A game ends when a player goes
+// out or when the stock runs out; every player then loses the points left
+// in hand.
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "cards.h"
+#include "game.h"
+
+typedef struct BatchStruct {
+    int size;                       // number of games
+    int numPlayers;                 // in every game
+    Cards *hands[MAX_PLAYERS];
+    int32_t *scores[MAX_PLAYERS];
+    Cards *runs;
+    Cards *sets;
+    Cards *discardTop;              // top of the discard pile, 0 if empty
+    int32_t *discardSize;
+    uint8_t *discardPile;           // 52 card indices per game, bottom first
+    uint8_t *deck;                  // 52 card indices per game, drawn in order
+    int32_t *drawn;                 // cards already drawn from deck
+    int32_t *current;               // player to move
+    int32_t *turns;                 // turns played
+    uint8_t *done;                  // 1 once the game is over
+
+    // Scratch arrays for the current player's turn.
+    Cards *hand;
+    Cards *melded;
+    int32_t *points;
+    int32_t *ended;                 // -1 if the game ends with this turn
+} Batch;
+
+// Games of DEFAULT_PLAYERS, or of numPlayers.
+bool Batch_init(Batch *batch, int size);
+bool Batch_initPlayers(Batch *batch, int size, int numPlayers);
+void Batch_free(Batch *batch);
+void Batch_deal(Batch *batch, uint64_t seed);
+// The game must have the batch's number of players.
+void Batch_setGame(Batch *batch, int i, Game *game);
+
+void Batch_phaseDraw(Batch *batch);
+void Batch_phaseMeld(Batch *batch);
+void Batch_phaseDiscard(Batch *batch);
+int Batch_phaseEnd(Batch *batch);
+
+int Batch_step(Batch *batch);
+int64_t Batch_run(Batch *batch, int maxTurns);
+
+#endif // BATCH_H
@@ -0,0 +1,103 @@
+#ifndef BOOK_H
+#define BOOK_H
+
+// An opening book: the first turn of a game, solved ahead of time.
+//
+// The first decision of every deal is the same kind of position: the
+// player to move holds seven cards, the discard pile is a single up-card,
+// the table is empty and no one has scored or been seen to take anything.
+// What the search makes of it depends on nothing else, and renaming the
+// suits of the hand and the up-card renames the answer, so the book keeps
+// one entry per canonical (hand, up-card) pair (Cards_canonicalSuits()).
+//
+// A book file is a 32-byte header followed by 16-byte entries sorted by
+// key:
+//   header   "RUMBOTBK", then the format version, the entry size and the
+//            number of players as little-endian uint16s, the number of
+//            entries as a uint64, then zeros
+//   entry    the key, Cards_pack() of the canonical hand shifted up six
+//            bits above the packed index of the up-card, then the turn:
+//            which of the eight cards (hand and up-card, lowest bit first)
+//            go into runs and into sets, which one is discarded, whether
+//            the up-card is taken, which runs play their ace low, and the
+//            search's evaluation
+// The fields are in the machine's byte order, which must be little endian.
+//
+// There are about 250 million canonical pairs.  BookCursor walks them in
+// key order, so a generator can solve them in blocks and append each block
+// as it is done; a book may also hold any subset of them.  Book_open()
+// maps a file and Book_probe() finds a position by binary search.
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "game.h"
+#include "search.h"
+#include "suits.h"
+
+#define BOOK_VERSION 1
+#define BOOK_HAND 7           // cards in hand at the first turn
+#define BOOK_NO_CARD 0xFF
+
+#define BOOK_TAKE 0x01        // BookEntry.flags: the up-card is taken
+#define BOOK_LOW_ACES 0xF0    // BookEntry.flags: one bit per suit
+
+typedef struct BookEntryStruct {
+    uint64_t key;
+    uint8_t runs;      // bits over the eight cards, lowest card first
+    uint8_t sets;
+    uint8_t discard;   // index among the eight cards, or BOOK_NO_CARD
+    uint8_t flags;
+    int32_t eval;
+} BookEntry;
+
+typedef struct BookHeaderStruct {
+    char magic[8];
+    uint16_t version;
+    uint16_t entrySize;
+    uint16_t numPlayers;
+    uint16_t unused;
+    uint64_t count;
+    uint64_t unused2;
+} BookHeader;
+
+typedef struct BookStruct {
+    void *map;
+    size_t mapSize;
+    int numPlayers;
+    const BookEntry *entries;
+    uint64_t count;
+} Book;
+
+// Every canonical first-turn key, in increasing order.
+typedef struct BookCursorStruct {
+    uint64_t hand;   // packed
+    int up;          // packed index of the next up-card to try
+} BookCursor;
+
+void BookCursor_init(BookCursor *cursor);
+// Returns false once every key has been returned.
+bool BookCursor_next(BookCursor *cursor, uint64_t *key);
+
+// The key of the game's position, and the renaming of suits that leads
+// to it.  Returns false if the game is not at its first turn.
+bool Book_key(Game *game, uint64_t *key, uint8_t perm[NUM_SUITS]);
+
+// Sets up a first-turn position with the key's hand and up-card, the
+// rivals holding the lowest of the other cards, and searches it to the
+// end with search->evaluator.  The game is the search's scratch space.
+void Book_solve(Search *search, Game *game, int numPlayers, uint64_t key, BookEntry *entry);
+
+void BookHeader_init(BookHeader *header, int numPlayers, uint64_t count);
+
+// Returns NULL, or why the file cannot be used.
+const char *Book_open(Book *book, const char *path);
+void Book_close(Book *book);
+
+// Finds the game's position in the book and sets up its turn as
+// Search_run() would have left it in search->best.  Returns false if the
+// game is not at its first turn, has another number of players than the
+// book, or the position is not in the book.
+bool Book_probe(const Book *book, Game *game, Turn *turn);
+
+#endif // BOOK_H
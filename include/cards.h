@@ -24,9 +24,30 @@ static inline bool Card_isLegal(Card i) {
 
 const char *Card_name(Card i);
 
+// Card_parse() reads a card written as value then suit, "a23456789TJQKA"
+// and "CDHS" ("TC", "aS" for an ace played low), by two table lookups and
+// no branches.  The result is the Card, or has CARD_BAD set if either
+// character is wrong, so that the results of a list can be ORed together
+// and checked once.
+#define CARD_BAD 0x80
+
+extern const uint8_t kCardValue[256];
+extern const uint8_t kCardSuit[256];
+
+static inline unsigned Card_parse(char value, char suit) {
+    return kCardValue[(uint8_t)value] | kCardSuit[(uint8_t)suit];
+}
+
 typedef uint64_t Cards;
 
 #define FULL_DECK 0x3FFE3FFE3FFE3FFEULL
+#define HIGH_ACES 0x2000200020002000ULL
+#define LOW_ACES  0x0001000100010001ULL
+
+// Cards_points() counts five for every card in FIVE_POINTS and ten for every
+// card in TEN_POINTS; the high ace is in both, for fifteen.
+#define FIVE_POINTS 0x21FF21FF21FF21FFULL
+#define TEN_POINTS  0x3E003E003E003E00ULL
 
 static inline bool Cards_isLegal(Cards cards) {
     return (cards & ~FULL_DECK) == 0;
@@ -49,8 +70,13 @@ static inline int Cards_size(Cards cards) {
 }
 
 static inline Cards Cards_addLowAces(Cards cards) {
-    const uint64_t kHighAceMask = 0x0001000100010001ULL;
-    return cards | ((cards & kHighAceMask) >> 13);
+    return cards | ((cards & HIGH_ACES) >> 13);
+}
+
+// Replace every low ace with the corresponding high ace.  Melds store aces
+// played low in the low-ace bit, but hands always hold the high-ace bit.
+static inline Cards Cards_toHighAces(Cards cards) {
+    return (cards | ((cards & LOW_ACES) << 13)) & ~LOW_ACES;
 }
 
 static inline Card Cards_toCard(Cards cards) {
@@ -59,11 +85,22 @@ static inline Card Cards_toCard(Cards cards) {
 }
 
 static inline int Cards_points(Cards cards) {
-    uint64_t five = cards & 0x21FF21FF21FF21FFULL;
-    uint64_t ten = cards & 0x3E003E003E003E00ULL;
+    uint64_t five = cards & FIVE_POINTS;
+    uint64_t ten = cards & TEN_POINTS;
     return 5 * (__builtin_popcountll(five) + (__builtin_popcountll(ten) << 1));
 }
 
+// The middle cards of every three in a row of one suit, and of every three
+// of one value (the suits wrap around, so each of four is a middle card).
+// A meld of three or more cards holds at least one of them.
+static inline Cards Cards_runCenters(Cards cards) {
+    return cards & (cards << 1) & (cards >> 1);
+}
+
+static inline Cards Cards_setCenters(Cards cards) {
+    return cards & ((cards << 16) | (cards >> 48)) & ((cards >> 16) | (cards << 48));
+}
+
 // Iterate over the cards in a Cards set:
 //   for (Cards c = Cards_low(cards); c != 0; c = Cards_next(cards, c)) { ... } 
 static inline Cards Cards_low(Cards cards) {
@@ -75,7 +112,15 @@ static inline Cards Cards_next(Cards cards, Cards card) {
     return cards & -cards;
 }
 
+// Cards written with single spaces between them ("8C 9C TC").  Returns
+// false, with *cards unspecified, if a card is malformed or repeated.
+bool Cards_parse(const char *str, Cards *cards);
+// Cards_parse() for string literals: malformed input gives no cards.
 Cards Cards_fromString(const char *str);
+// Writes the cards as one word with no separators ("8C9CTC"), or "-" for
+// none, without a terminating NUL.  Returns the end of what was written,
+// at most 2 * 64 chars.
+char *Cards_write(Cards cards, char *out);
 void Cards_print(Cards cards);
 
 #endif // CARDS_H
\ No newline at end of file
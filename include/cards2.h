@@ -0,0 +1,109 @@
+#ifndef CARDS2_H
+#define CARDS2_H
+
+// A "Cards2" is a multiset of cards from two decks shuffled together, for
+// the two-deck tables: each card is held zero, one or two times.  It is
+// two Cards layers, the cards held at least once and the cards held
+// twice, so two is always within one and every operation is a few word
+// operations on each layer, like the single-deck ones in cards.h.
+//
+// Single-deck play keeps using Cards: nothing on its paths goes through
+// this type, so it costs them nothing.  Nothing plays two decks yet
+// either: dealing, Play and the search are single-deck only, and this is
+// the card type they would be built on.
+
+#include "cards.h"
+
+typedef struct Cards2Struct {
+    Cards one;   // held at least once
+    Cards two;   // held twice
+} Cards2;
+
+static inline bool Cards2_isLegal(Cards2 cards) {
+    return Cards_isLegal(cards.one) && (cards.two & ~cards.one) == 0;
+}
+
+static inline bool Cards2_equal(Cards2 a, Cards2 b) {
+    return a.one == b.one && a.two == b.two;
+}
+
+// How many times the card is held: 0, 1 or 2.
+static inline int Cards2_count(Cards2 cards, Card card) {
+    return (int)((cards.one >> card) & 1) + (int)((cards.two >> card) & 1);
+}
+
+// Whether every card of c is held at least once.
+static inline bool Cards2_has(Cards2 cards, Cards c) {
+    return Cards_has(cards.one, c);
+}
+
+// Adds one copy of each card of c; none may be held twice already.
+static inline void Cards2_add(Cards2 *cards, Cards c) {
+    assert((cards->two & c) == 0);
+    cards->two |= cards->one & c;
+    cards->one |= c;
+}
+
+// Removes one copy of each card of c; each must be held.
+static inline void Cards2_remove(Cards2 *cards, Cards c) {
+    assert(Cards_has(cards->one, c));
+    cards->one &= ~(c & ~cards->two);
+    cards->two &= ~c;
+}
+
+// The sum of two multisets; no card may end up held more than twice.
+static inline Cards2 Cards2_union(Cards2 a, Cards2 b) {
+    assert(((a.two & b.one) | (a.one & b.two)) == 0);
+    Cards2 sum = { a.one | b.one, a.two | b.two | (a.one & b.one) };
+    return sum;
+}
+
+static inline int Cards2_size(Cards2 cards) {
+    return Cards_size(cards.one) + Cards_size(cards.two);
+}
+
+static inline int Cards2_points(Cards2 cards) {
+    return Cards_points(cards.one) + Cards_points(cards.two);
+}
+
+// The centers (cards.h) of the melds that can be laid down, in one, and in
+// two, the centers of those that can be laid down beside a second meld of
+// the same values, out of the second copies.
+//
+// Two runs that share a value are on the same three cards, or overlap by
+// two or by one, as 5-6-7 and 6-7-8 in 5 6 6 7 7 8: both their centers are
+// in two.  Runs further apart share no card, and are found in one.
+static inline Cards2 Cards2_runCenters(Cards2 cards) {
+    Cards one = cards.one, two = cards.two;
+    Cards same = Cards_runCenters(two);
+    Cards byTwo = (one << 1) & two & (two >> 1) & (one >> 2);
+    Cards byOne = (one << 1) & one & (two >> 1) & (one >> 2) & (one >> 3);
+    Cards2 centers = { Cards_runCenters(one), same | byTwo | (byTwo << 1) | byOne | (byOne << 2) };
+    return centers;
+}
+
+// Whether each value is held in all four suits, of each 16-bit lane.
+static inline Cards Cards2_lanesAll(Cards c) {
+    return c & (c >> 16) & (c >> 32) & (c >> 48) & 0xFFFF;
+}
+
+static inline Cards Cards2_lanesTwo(Cards c) {
+    Cards s0 = c & 0xFFFF, s1 = (c >> 16) & 0xFFFF, s2 = (c >> 32) & 0xFFFF, s3 = c >> 48;
+    return ((s0 | s1) & (s2 | s3)) | (s0 & s1) | (s2 & s3);
+}
+
+static inline Cards Cards2_lanesThree(Cards c) {
+    Cards s0 = c & 0xFFFF, s1 = (c >> 16) & 0xFFFF, s2 = (c >> 32) & 0xFFFF, s3 = c >> 48;
+    return (s0 & s1 & (s2 | s3)) | (s2 & s3 & (s0 | s1));
+}
+
+// A set holds no suit twice, so two sets of one value take six of its
+// eight cards: all four once and two of them twice, or three twice.
+static inline Cards2 Cards2_setCenters(Cards2 cards) {
+    Cards values = (Cards2_lanesAll(cards.one) & Cards2_lanesTwo(cards.two)) | Cards2_lanesThree(cards.two);
+    Cards one = Cards_setCenters(cards.one);
+    Cards2 centers = { one, one & (values * 0x0001000100010001ULL) };
+    return centers;
+}
+
+#endif // CARDS2_H
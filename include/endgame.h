@@ -0,0 +1,80 @@
+#ifndef ENDGAME_H
+#define ENDGAME_H
+
+// Exact endgame search.  Once the stock is down to a few cards, the rest
+// of the hand is a small game tree: every turn of every player is tried
+// (plan.h) until the hand ends, and the score the player to move can be
+// sure of is exact rather than Eval_evaluate()'s estimate.
+//
+// The search sees everything: the rivals' hands and the order of the
+// stock.  Use it where those are known, or to analyze.  The hand ends as
+// in self-play (train.c): when a player goes out, or when the stock is
+// empty at the start of a turn; each player then loses the points left in
+// hand.
+//
+// The rivals are taken to play against the player to move (the paranoid
+// rule), which makes the tree a two-sided one: the value of a position is
+// the most points the player can be sure to gain from there to the end of
+// the hand, and alpha-beta bounds cut the turns that cannot change it.
+// Values are stored relative to the position, scores left out, in a
+// direct-mapped transposition table along with the best turn's index,
+// which is tried first when the position comes round again.  Turns that
+// meld the most points are tried next: they lead to short hands.
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include "game.h"
+#include "plan.h"
+#include "turn.h"
+
+#define ENDGAME_DEFAULT_STOCK 3
+#define ENDGAME_DEFAULT_BITS 20
+#define ENDGAME_MAX_DEPTH 64    // turns
+
+typedef enum {
+    BOUND_EXACT,
+    BOUND_LOWER,   // the value is at least this
+    BOUND_UPPER,   // the value is at most this
+} Bound;
+
+typedef struct EndgameEntryStruct {
+    uint64_t key;
+    int16_t value;
+    uint8_t bound;
+    uint8_t unused;
+    uint16_t move;    // index of the best turn in its PlanList
+    uint16_t unused2;
+} EndgameEntry;
+
+typedef struct EndgameStruct {
+    int maxStock;       // solve when the stock holds this many cards or fewer
+    uint64_t maxNodes;  // give up after this many positions (0 = no limit)
+    uint64_t deadline;  // or at this CLOCK_MONOTONIC time in ns (0 = none)
+    atomic_bool *stop;  // or once this is set, if not NULL
+    int bits;           // the table has 1 << bits entries
+    EndgameEntry *table;
+    PlanList lists[ENDGAME_MAX_DEPTH];
+    uint64_t nodes;     // positions searched by the last solve
+    uint64_t probes;
+    uint64_t hits;
+    uint64_t cutoffs;
+    bool aborted;
+} Endgame;
+
+// Returns false if out of memory.
+bool Endgame_init(Endgame *endgame, int maxStock, int bits);
+void Endgame_free(Endgame *endgame);
+void Endgame_clear(Endgame *endgame);
+
+// Whether the game is small enough to solve: a stock of 1 to maxStock.
+bool Endgame_applies(const Endgame *endgame, Game *game);
+
+// Solves the game for the player to move.  Returns false if the search
+// gave up (a limit above, or a hand longer than ENDGAME_MAX_DEPTH turns);
+// otherwise sets *gain to the points the player can be sure to gain by the
+// end of the hand, and turn to a turn that gains them, as Search_run()
+// would leave it in search->best, its eval the final score.
+bool Endgame_solve(Endgame *endgame, Game *game, int *gain, Turn *turn);
+
+#endif // ENDGAME_H
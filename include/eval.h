@@ -0,0 +1,51 @@
+#ifndef EVAL_H
+#define EVAL_H
+
+#include "game.h"
+
+#define EVAL_POINTS_PER_OUT 1
+
+// Static evaluation of a position from the point of view of the current
+// player.  Points already melded count in full, points still in hand count
+// half, and going out earns 7 points per card left in the rivals' hands
+// (averaged over the rivals).  Each live out of the hand (a card that
+// would complete a meld with two cards of it, see potential.h) is worth
+// EVAL_POINTS_PER_OUT.
+//
+// A discard that would give the next player a meld (see Play_danger) costs
+// its own points, which that player would score.  Only what is public is
+// used: the table, the discard pile and the cards the next player was seen
+// to take.
+
+int Eval_evaluate(Game *game);
+
+// The cards the current player should not discard.
+Cards Eval_danger(Game *game);
+
+typedef struct DiscardStruct {
+    Cards card;
+    int eval;
+} Discard;
+
+// Evaluates every discard from the current player's hand in one pass,
+// each with the value Eval_evaluate() would give after Player_discard().
+// Writes the best k into top, best first and ties broken by the lower
+// card, and returns how many were written: k, or fewer if the hand holds
+// fewer cards.
+int Eval_discards(Game *game, Discard *top, int k);
+
+// An evaluation the search can be given in place of the one above, e.g. a
+// learned model (see model.h).  discards() has the contract of
+// Eval_discards(); data belongs to the implementation.
+typedef struct EvaluatorStruct Evaluator;
+struct EvaluatorStruct {
+    const char *name;
+    int (*evaluate)(const Evaluator *evaluator, Game *game);
+    int (*discards)(const Evaluator *evaluator, Game *game, Discard *top, int k);
+    const void *data;
+};
+
+// Eval_evaluate() and Eval_discards() as an Evaluator.
+extern const Evaluator Eval_handTuned;
+
+#endif // EVAL_H
@@ -0,0 +1,123 @@
+#ifndef EVALCACHE_H
+#define EVALCACHE_H
+
+// A cache of discard evaluations, in front of the evaluator's discards().
+//
+// A turn search reaches the same position after its melds many times: a
+// run can be melded as 3-4-5 then extended with 6, or as 4-5-6 then
+// extended with 3, and the same hand is left.  Each thread has its own
+// direct-mapped table of 1 << EvalCache_bits() entries, so probes take no
+// lock; an entry is overwritten by any later store to its slot.
+//
+// The key is a 64-bit hash of everything the evaluation reads, built by
+// the search (see EvalCache_key()), and the hand is stored alongside it as
+// a check.  The hash includes EvalCache_version(): call EvalCache_invalidate()
+// after changing the parameters of an evaluator that may be in use (a
+// model's weights, say) and every entry cached before becomes a miss.
+// Hits and probes are counted in SearchStats.
+//
+// The cache is off by default.  Over the first dozen turns of 300 seeded
+// games, 2.5% of the probes hit, and the hand-tuned evaluation of a whole
+// hand costs little more than a probe that misses.  It pays for costlier
+// evaluators, and for searching a position again (after pondering, say),
+// which needs the search to run on the same thread: a protocol Engine
+// keeps one search thread for that reason (protocol.h).
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include "cards.h"
+#include "eval.h"
+
+#define EVALCACHE_DEFAULT_BITS 0
+#define EVALCACHE_MAX_BITS 24
+
+typedef struct EvalCacheEntryStruct {
+    uint64_t key;
+    Cards hand;
+    Cards card;
+    int32_t eval;
+    int32_t unused;
+} EvalCacheEntry;
+
+typedef struct EvalCacheStruct {
+    int bits;          // the table has 1 << bits entries
+    EvalCacheEntry entries[];
+} EvalCache;
+
+extern atomic_int EvalCache_runBits;
+extern atomic_uint EvalCache_runVersion;
+extern _Thread_local EvalCache *EvalCache_table;
+
+// Sets the size of every thread's table, which is reallocated at its next
+// probe: 1 << bits entries, up to EVALCACHE_MAX_BITS.  0 turns caching off.
+void EvalCache_setBits(int bits);
+void EvalCache_invalidate(void);
+
+// Allocates (or reallocates) the calling thread's table at the current
+// size.  Returns NULL if caching is off or memory runs out.
+EvalCache *EvalCache_newTable(void);
+
+static inline int EvalCache_bits(void) {
+    return atomic_load_explicit(&EvalCache_runBits, memory_order_relaxed);
+}
+
+static inline unsigned EvalCache_version(void) {
+    return atomic_load_explicit(&EvalCache_runVersion, memory_order_relaxed);
+}
+
+static inline uint64_t EvalCache_mix(uint64_t h, uint64_t x) {
+    x *= 0xFF51AFD7ED558CCDULL;
+    x ^= x >> 33;
+    h = (h ^ x) * 0xC4CEB9FE1A85EC53ULL;
+    return h ^ (h >> 29);
+}
+
+// The key of a discard node: the parts that change within a search, mixed
+// into a seed that covers the rest (see Search_start()).
+static inline uint64_t EvalCache_key(uint64_t seed, Cards hand, Cards runs, Cards sets,
+                                     Cards discarded, int score) {
+    uint64_t h = EvalCache_mix(seed, hand);
+    h = EvalCache_mix(h, runs);
+    h = EvalCache_mix(h, sets);
+    h = EvalCache_mix(h, discarded);
+    return EvalCache_mix(h, (uint64_t)(uint32_t)score);
+}
+
+static inline EvalCacheEntry *EvalCache_slot(uint64_t key) {
+    EvalCache *table = EvalCache_table;
+    int bits = EvalCache_bits();
+    if (!table || table->bits != bits) {
+        if (bits == 0) {
+            return NULL;
+        }
+        table = EvalCache_newTable();
+        if (!table) {
+            return NULL;
+        }
+    }
+    return &table->entries[key >> (64 - table->bits)];
+}
+
+// Returns true, and the cached best discard, if the key is in the table.
+static inline bool EvalCache_probe(uint64_t key, Cards hand, Discard *best) {
+    EvalCacheEntry *entry = EvalCache_slot(key);
+    if (!entry || entry->key != key || entry->hand != hand) {
+        return false;
+    }
+    best->card = entry->card;
+    best->eval = entry->eval;
+    return true;
+}
+
+static inline void EvalCache_store(uint64_t key, Cards hand, const Discard *best) {
+    EvalCacheEntry *entry = EvalCache_slot(key);
+    if (entry) {
+        entry->key = key;
+        entry->hand = hand;
+        entry->card = best->card;
+        entry->eval = best->eval;
+    }
+}
+
+#endif // EVALCACHE_H
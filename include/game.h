@@ -6,14 +6,56 @@
 #include "pile.h"
 #include "table.h"
 
-#define NUM_PLAYERS 3
+// The number of players is set when a game is cleared or dealt.
+#define MIN_PLAYERS 2
+#define MAX_PLAYERS 6
+#define DEFAULT_PLAYERS 3
+#define JOURNAL_SIZE 256
+
+// Scores are at most MAX_SCORE either way, so that the values built on
+// them (a score plus the points of a hand or an evaluation) fit the 16-bit
+// values of a transposition table (ttable.h).
+#define MAX_SCORE 10000
 
 typedef struct GameStruct Game;
 
+// Every change the Player functions and Game_nextTurn() make is recorded
+// in the game's journal, so that it can be unmade.  An entry is the delta
+// itself: which player, what kind of move, and the cards it moved; the
+// score changes by the points of a meld, and the rest follows from the
+// piles.  Game_unmake() takes back the last entry and Game_unmakeTo() every
+// entry after a mark from Game_mark(), in O(entries).
+//
+// Setting up a position by filling in the fields leaves the journal alone;
+// Game_clear() and Game_commit() empty it, after which nothing before can
+// be unmade.  Game_init() and Game_play() commit what they did.
+typedef enum {
+    MOVE_DRAW,       // a card from the stock
+    MOVE_TAKE,       // the top card of the discard pile
+    MOVE_RUN,        // a run melded or a card laid off on one
+    MOVE_SET,        // a set melded or a card laid off on one
+    MOVE_DISCARD,
+    MOVE_NEXT_TURN,  // the turn passed on from player
+} MoveType;
+
+typedef struct MoveStruct {
+    Cards cards;
+    uint8_t type;
+    uint8_t player;
+    uint8_t known;   // MOVE_TAKE: the card was not known before
+    uint8_t unused;
+} Move;
+
+typedef struct JournalStruct {
+    int size;
+    Move moves[JOURNAL_SIZE];
+} Journal;
+
 typedef struct PlayerStruct {
     Game *game;
     int id;
     Cards hand;
+    Cards known;     // cards the rivals saw this player take; some may be gone
     int score;
     Turn turn;
 } Player;
@@ -21,26 +63,49 @@ typedef struct PlayerStruct {
 struct GameStruct {
     int numPlayers;
     int currentPlayer;
-    Player players[NUM_PLAYERS];
+    Player players[MAX_PLAYERS];
     Pile drawPile;
     Pile discardPile;
     Table table;
-    Cards discarded;
+    Cards discarded; // the cards of discardPile, kept by the Player functions
+    Journal journal;
 };
 
+// An empty position for DEFAULT_PLAYERS, or for numPlayers (MIN_PLAYERS
+// to MAX_PLAYERS).
+void Game_clear(Game *game);
+void Game_clearPlayers(Game *game, int numPlayers);
+// Copies a game; the players of the copy belong to it.
+void Game_copy(Game *to, const Game *from);
 void Game_init(Game *game);
+void Game_initSeeded(Game *game, uint64_t seed);
+// Game_initSeeded() for numPlayers: seven cards each, then the up-card.
+void Game_deal(Game *game, int numPlayers, uint64_t seed);
+const char *Game_validate(Game *game);
 Player *Game_player(Game *game, int num);
 Player *Game_currentPlayer(Game *game);
+void Game_play(Game *game, const Turn *turn);
+// Game_play() without the commit, so that it can be unmade: takes that
+// many cards from the discard pile, or draws if none, then melds, discards
+// and passes the turn on.
+void Game_make(Game *game, int taken, Cards runs, Cards sets, Cards discard);
 void Game_nextTurn(Game *game);
 void Game_print(Game *game);
 
+static inline int Game_mark(Game *game) {
+    return game->journal.size;
+}
+
+void Game_unmake(Game *game);
+void Game_unmakeTo(Game *game, int mark);
+void Game_commit(Game *game);
+
 void Player_init(Player *player, Game *game, int id);
 Cards Player_draw(Player *player);
-void Player_undoDraw(Player *player, Cards card);
 void Player_take(Player *player);
-void Player_undoTakes(Player *player);
+void Player_playRun(Player *player, Cards meld);
+void Player_playSet(Player *player, Cards meld);
 void Player_discard(Player *player, Cards card);
-void Player_undoDiscard(Player *player);
 void Player_print(Player *player);
 
 #endif // GAME_H
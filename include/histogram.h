@@ -0,0 +1,92 @@
+#ifndef HISTOGRAM_H
+#define HISTOGRAM_H
+
+// Log-bucketed (HDR-style) histograms of 64-bit values.
+//
+// Values below 16 get a bucket each; above that, every power of two is
+// split into HISTOGRAM_SUB_BUCKETS equal buckets, so any recorded value is
+// known to within 1/8 of itself.  All 496 buckets are preallocated, and
+// recording is a handful of instructions with no locks.
+//
+// A histogram has a single writer: the thread that owns it.  Its counters
+// are atomics written with relaxed stores, so any other thread may read,
+// merge or print it at any time without stopping the writer.  To combine
+// the histograms of several threads, merge them into a scratch histogram.
+
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#define HISTOGRAM_SUB_BITS 3
+#define HISTOGRAM_SUB_BUCKETS (1 << HISTOGRAM_SUB_BITS)
+#define HISTOGRAM_BUCKETS ((64 - HISTOGRAM_SUB_BITS + 1) * HISTOGRAM_SUB_BUCKETS)
+
+typedef struct HistogramStruct {
+    _Atomic uint64_t count;
+    _Atomic uint64_t sum;
+    _Atomic uint64_t min;
+    _Atomic uint64_t max;
+    _Atomic uint64_t buckets[HISTOGRAM_BUCKETS];
+} Histogram;
+
+void Histogram_init(Histogram *h);
+void Histogram_merge(Histogram *total, const Histogram *h);
+uint64_t Histogram_count(const Histogram *h);
+uint64_t Histogram_percentile(const Histogram *h, double percent);
+void Histogram_print(const Histogram *h, const char *name, FILE *out);
+void Histogram_printJson(const Histogram *h, const char *name, FILE *out);
+
+uint64_t Histogram_bucketLow(int index);
+uint64_t Histogram_bucketHigh(int index);
+
+static inline int Histogram_bucket(uint64_t value) {
+    if (value < 2 * HISTOGRAM_SUB_BUCKETS) {
+        return (int)value;
+    }
+    int shift = 63 - __builtin_clzll(value) - HISTOGRAM_SUB_BITS;
+    return (shift + 1) * HISTOGRAM_SUB_BUCKETS + (int)(value >> shift) - HISTOGRAM_SUB_BUCKETS;
+}
+
+// Only the owning thread may record.
+static inline void Histogram_record(Histogram *h, uint64_t value) {
+    _Atomic uint64_t *bucket = &h->buckets[Histogram_bucket(value)];
+    uint64_t count = atomic_load_explicit(&h->count, memory_order_relaxed);
+    atomic_store_explicit(bucket, atomic_load_explicit(bucket, memory_order_relaxed) + 1, memory_order_relaxed);
+    atomic_store_explicit(&h->sum, atomic_load_explicit(&h->sum, memory_order_relaxed) + value, memory_order_relaxed);
+    if (count == 0 || value < atomic_load_explicit(&h->min, memory_order_relaxed)) {
+        atomic_store_explicit(&h->min, value, memory_order_relaxed);
+    }
+    if (value > atomic_load_explicit(&h->max, memory_order_relaxed)) {
+        atomic_store_explicit(&h->max, value, memory_order_relaxed);
+    }
+    atomic_store_explicit(&h->count, count + 1, memory_order_release);
+}
+
+// The histograms kept for every engine decision (one search).  Sets owned
+// by different threads can be registered in one process-wide list so that
+// they can be dumped together.
+
+typedef enum {
+    DECISION_TIME_NS,        // wall time of the whole search
+    DECISION_NODES,          // leaves evaluated
+    DECISION_FIRST_MOVE_NS,  // time until the search had a legal turn
+    DECISION_COUNT
+} DecisionMetric;
+
+typedef struct DecisionHistogramsStruct {
+    Histogram metrics[DECISION_COUNT];
+    struct DecisionHistogramsStruct *next;  // registry link
+} DecisionHistograms;
+
+extern const char *kDecisionMetricName[DECISION_COUNT];
+
+void DecisionHistograms_init(DecisionHistograms *h);
+void DecisionHistograms_merge(DecisionHistograms *total, const DecisionHistograms *h);
+void DecisionHistograms_print(const DecisionHistograms *h, FILE *out);
+void DecisionHistograms_printJson(const DecisionHistograms *h, FILE *out);
+
+void DecisionHistograms_register(DecisionHistograms *h);
+void DecisionHistograms_unregister(DecisionHistograms *h);
+void DecisionHistograms_mergeRegistered(DecisionHistograms *total);
+
+#endif // HISTOGRAM_H
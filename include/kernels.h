@@ -0,0 +1,41 @@
+#ifndef KERNELS_H
+#define KERNELS_H
+
+// Array versions of the Cards and Play functions, for code that works on
+// many hands at once (the batch simulator, discard scoring).  Each computes
+// exactly what calling the scalar function on every element would.
+//
+// There are scalar, AVX2 and AVX-512 (VPOPCNTQ) implementations.  The best
+// one the CPU supports is chosen on first use; Kernels_use() overrides the
+// choice, e.g. to compare implementations in tests and benchmarks.
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "cards.h"
+
+typedef enum {
+    KERNELS_SCALAR,
+    KERNELS_AVX2,     // 4 bitboards per instruction
+    KERNELS_AVX512,   // 8 bitboards per instruction, needs BW and VPOPCNTDQ
+    KERNELS_COUNT
+} KernelsLevel;
+
+bool Kernels_supported(KernelsLevel level);
+KernelsLevel Kernels_best(void);
+KernelsLevel Kernels_level(void);
+void Kernels_use(KernelsLevel level);
+const char *Kernels_name(KernelsLevel level);
+
+void Cards_sizeArray(const Cards *cards, int32_t *sizes, int n);
+void Cards_pointsArray(const Cards *cards, int32_t *points, int n);
+
+// Play_find() for n hands, each against its own table, into four arrays.
+void Play_findArray(const Cards *hands, const Cards *runs, const Cards *sets,
+                    Cards *runCenters, Cards *runExtensions,
+                    Cards *setCenters, Cards *setExtensions, int n);
+
+// The dot product of a vector of 0s and 1s, packed 64 to a word, with
+// 64 * words int8 weights: the sum of the weights whose bits are set.
+int32_t Kernels_dot(const uint64_t *bits, const int8_t *weights, int words);
+
+#endif // KERNELS_H
@@ -0,0 +1,86 @@
+#ifndef LOOKAHEAD_H
+#define LOOKAHEAD_H
+
+// Multi-turn search: the turn of the player to move and the turns of the
+// players after it, to a fixed number of turns.  Every turn of every
+// player is tried (plan.h); at the horizon each player's position is
+// scored by the evaluator as if it were that player's turn, and a hand
+// that ends inside the horizon is scored as it ends, each player losing
+// the points left in hand.  Like the endgame solver (endgame.h), it reads
+// the rivals' hands and the order of the stock.
+//
+// The values are backed up by one of two rules:
+//   max-n      each player picks the turn best for itself, by its own
+//              value; every player's value is carried up the tree
+//   paranoid   the rivals pick the turns worst for the player to move at
+//              the root, as if in league against it, so only its value is
+//              carried and alpha-beta bounds cut the turns that cannot
+//              change it
+// Max-n is the more faithful model of rivals who play for themselves, but
+// it cannot prune: from mid-game positions of three-player self-play, 4
+// turns took it up to about 160 ms here, when paranoid searched 6 turns in
+// at most about 50 ms.
+//
+// The search deepens one turn at a time up to maxDepth and keeps the turn
+// of the deepest search it completed, so a deadline or a node limit stops
+// it with an answer from the last completed depth.  Each depth starts
+// from the best turns the previous one left in a transposition table of
+// cache-line buckets (ttable.h); entries keep the depth they were searched
+// to and, in paranoid mode, whether the value is exact or a bound.  They
+// hold one value with paranoid, 8 to a bucket, and one per player with
+// max-n.  The bucket of a position is prefetched as soon as its turn is
+// made, before the search below it gets to the probe.
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include "eval.h"
+#include "game.h"
+#include "plan.h"
+#include "ttable.h"
+#include "turn.h"
+
+#define LOOKAHEAD_DEFAULT_BITS 16    // 4 MB of buckets
+#define LOOKAHEAD_MAX_DEPTH 12     // turns
+
+typedef enum {
+    BACKUP_MAXN,
+    BACKUP_PARANOID,
+} Backup;
+
+typedef struct LookaheadStruct {
+    Backup backup;
+    int maxDepth;       // turns, the root player's own included
+    const Evaluator *evaluator; // scores the horizon
+    uint64_t maxNodes;  // give up after this many positions (0 = no limit)
+    uint64_t deadline;  // or at this CLOCK_MONOTONIC time in ns (0 = none)
+    atomic_bool *stop;  // or once this is set, if not NULL
+    TTable table;       // paranoid: values[0] is the root player's
+    PlanList lists[LOOKAHEAD_MAX_DEPTH];
+    int depth;          // turns the last search completed
+    uint64_t nodes;     // positions searched by the last search
+    uint64_t leaves;    // positions scored by the evaluator
+    uint64_t probes;
+    uint64_t hits;
+    uint64_t cutoffs;
+    bool aborted;
+} Lookahead;
+
+// A table of 1 << bits buckets, on huge pages if asked.  Returns false if
+// out of memory.  The evaluator is Eval_handTuned.
+bool Lookahead_init(Lookahead *lookahead, Backup backup, int maxDepth, int bits, bool hugePages);
+void Lookahead_free(Lookahead *lookahead);
+void Lookahead_clear(Lookahead *lookahead);
+
+// "maxn" or "paranoid"; Backup_parse() returns false for anything else.
+const char *Backup_name(Backup backup);
+bool Backup_parse(const char *name, Backup *backup);
+
+// Searches the game for the player to move.  Returns false if not even a
+// search one turn deep completed, or the stock is empty; otherwise sets
+// values (for every player with max-n, for the player to move only with
+// paranoid) and turn to the turn chosen, as Search_run() would leave it in
+// search->best, its eval the value for the player to move.
+bool Lookahead_search(Lookahead *lookahead, Game *game, int values[MAX_PLAYERS], Turn *turn);
+
+#endif // LOOKAHEAD_H
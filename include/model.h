@@ -0,0 +1,60 @@
+#ifndef MODEL_H
+#define MODEL_H
+
+// A learned evaluation: a linear model with int8 weights over 256 binary
+// features of the position, fitted by bin/train on self-play games.
+//
+// The features are four 64-bit planes in the card layout, from the point
+// of view of the player who just moved:
+//   0  the player's hand
+//   1  the cards on the table (aces high)
+//   2  the discard pile below its top card
+//   3  the cards the next player was seen to take and still holds
+// The unused slots of plane 3 (values 14 and 15 of each suit) say whether
+// the player went out and, if so, how many cards the rivals hold: slot 14
+// is set on going out, and the other seven, in order, when the rivals hold
+// at least 2, 4, ..., 14 cards.
+//
+// The evaluation is the player's score plus the model's estimate of the
+// points still to come:
+//   score + ((bias + sum of the weights of the set features) * scale) >> 8
+// The sum is an int8 dot product (Kernels_dot).
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include "eval.h"
+#include "game.h"
+
+#define MODEL_WORDS 4
+#define MODEL_INPUTS (64 * MODEL_WORDS)
+#define MODEL_SCALE_BITS 8
+#define MODEL_WENT_OUT 14   // slot in plane 3
+
+typedef struct ModelStruct {
+    _Alignas(64) int8_t weights[MODEL_INPUTS];
+    int32_t bias;
+    int32_t scale;
+} Model;
+
+// A model with no weights: it evaluates every position as the score.
+void Model_init(Model *model);
+
+// The features of the position for the given player, who has finished
+// their turn: the top of the discard pile is their discard.
+void Model_features(Game *game, int player, uint64_t features[MODEL_WORDS]);
+
+int Model_evaluate(const Model *model, Game *game);
+int Model_discards(const Model *model, Game *game, Discard *top, int k);
+
+// An Evaluator backed by the model, which must outlive it.
+void Model_evaluator(const Model *model, Evaluator *evaluator);
+
+// Text format: "rumbot-model 1", "bias <n>", "scale <n>", then the 256
+// weights.  Model_load() returns false, leaving the model unchanged, if
+// the file is not a valid model.  Loading invalidates the evaluation cache,
+// as the model may be in use.
+bool Model_load(Model *model, FILE *in);
+void Model_save(const Model *model, FILE *out);
+
+#endif // MODEL_H
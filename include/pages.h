@@ -0,0 +1,21 @@
+#ifndef PAGES_H
+#define PAGES_H
+
+// Large zeroed memory straight from the kernel, for tables and arenas that
+// are walked at random and so miss the TLB on most accesses.  With
+// hugePages, Pages_map() asks for 2 MB pages: from the reserved pool
+// (MAP_HUGETLB) if there is one, and else by madvise(MADV_HUGEPAGE) for
+// transparent huge pages.  The kernel backs the pages as they are touched.
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#define PAGES_HUGE ((size_t)2 << 20)
+
+// Returns NULL if the memory cannot be mapped.  With hugePages, size
+// must be a multiple of PAGES_HUGE; *huge is set if the pages came from
+// the reserved pool.
+void *Pages_map(size_t size, bool hugePages, bool *huge);
+void Pages_unmap(void *pages, size_t size);
+
+#endif // PAGES_H
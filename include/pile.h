@@ -4,6 +4,7 @@
 #include <assert.h>
 #include <stdbool.h>
 #include "cards.h"
+#include "random.h"
 
 typedef struct {
     Cards cards[52];
@@ -28,8 +29,18 @@ static inline void Pile_init(Pile *pile) {
     pile->size = 0;
 }
 
+// All the cards of the pile as one Cards.
+static inline Cards Pile_cards(Pile *pile) {
+    Cards cards = 0;
+    for (int i = 0; i < pile->size; ++i) {
+        cards |= pile->cards[i];
+    }
+    return cards;
+}
+
 void Pile_fullDeck(Pile *pile);
 void Pile_shuffle(Pile *pile);
+void Pile_shuffleRandom(Pile *pile, Random *random);
 void Pile_print(Pile *pile);
 
 #endif // PILE_H
\ No newline at end of file
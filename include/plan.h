@@ -0,0 +1,66 @@
+#ifndef PLAN_H
+#define PLAN_H
+
+// Every turn the player to move can play, as searches that look past the
+// end of the turn need them: the card on top of the stock is taken to be
+// known, as it is to a perfect-information search.
+//
+// A plan is what Game_make() needs to play a turn: how many cards are
+// taken from the discard pile (0 for a draw), the melds and the discard.
+// The melds are tried as the turn search tries them (search.c), each
+// option rejected for the rest of its branch once it has been tried, and
+// every card left in hand is a possible discard; a hand melded away goes
+// out without one.  A turn that takes from the discard pile must meld the
+// deepest card taken.
+
+#include <stdbool.h>
+#include "game.h"
+
+typedef struct PlanStruct {
+    Cards runs;      // as Turn.meld.runs
+    Cards sets;
+    Cards discard;   // 0 when going out
+    int taken;       // cards taken from the discard pile, 0 for a draw
+    int points;      // what the melds score
+} Plan;
+
+typedef struct PlanListStruct {
+    Plan *plans;
+    int size;
+    int capacity;
+} PlanList;
+
+void PlanList_init(PlanList *list);
+void PlanList_free(PlanList *list);
+
+// Replaces the list with every turn of the player to move.  The game is
+// left as it was found.  Returns false if out of memory.
+bool PlanList_generate(PlanList *list, Game *game);
+
+#define PLAN_JOURNAL_RESERVE 80   // entries a plan needs besides its takes, at most
+
+// Whether the journal may be too full for one more plan.
+static inline bool Plan_journalFull(Game *game) {
+    int free = JOURNAL_SIZE - PLAN_JOURNAL_RESERVE - Game_mark(game);
+    return free < 0 || Pile_size(&game->discardPile) > free;
+}
+
+// A hash of everything the turns from here depend on: the hands, the
+// table, both piles in order and the player to move, and of salt, for
+// whatever else a search's values depend on.  Scores and known cards are
+// left out.  Never 0.
+uint64_t Plan_positionKey(Game *game, uint64_t salt);
+
+// Orders the plans by the points they meld, most first: they lead to
+// short hands, and so to small trees.
+void PlanList_sort(PlanList *list);
+
+static inline void Plan_make(Game *game, const Plan *plan) {
+    Game_make(game, plan->taken, plan->runs, plan->sets, plan->discard);
+}
+
+// The plan as the turn Search_run() would leave in search->best, for the
+// game before it is played.
+void Plan_toTurn(const Plan *plan, Game *game, Turn *turn);
+
+#endif // PLAN_H
@@ -12,42 +12,108 @@ typedef struct PlayStruct {
     Cards setExtensions;
 } Play;
 
-void Play_init(Play *play) {
+static inline void Play_init(Play *play) {
     play->runCenters = 0;
     play->runExtensions = 0;
     play->setCenters = 0;
     play->setExtensions = 0;
 }
 
-void Play_find(Game *game, Play *play) {
-    Cards hand = Game_currentPlayer(game)->hand;
-    Table *table = &(game->table);
-
+static inline void Play_findHand(Play *play, Cards hand, Cards runs, Cards sets) {
     // Add a low ace for every high ace
     Cards lowHand = Cards_addLowAces(hand);
-    play->runCenters = hand & (hand << 1) & (hand >> 1);
-    play->setCenters = (hand & ((hand << 16) | (hand >> 48)) & ((hand >> 16) | (hand << 48)));
-    play->runExtensions = ((table->runs << 1) | (table->runs >> 1)) & lowHand;
-    play->setExtensions = ((table->sets << 16) | (table->sets >> 16)) & lowHand;
+    play->runCenters = Cards_runCenters(hand);
+    play->setCenters = Cards_setCenters(hand);
+    play->runExtensions = ((runs << 1) | (runs >> 1)) & lowHand;
+    play->setExtensions = ((sets << 16) | (sets >> 16)) & lowHand;
+}
+
+// The cards that would give a player meld options if they were discarded:
+// cards that lay off on the table, and cards that complete a run or set
+// with two cards of pool (what the player is known to hold, and the
+// discard pile, which they may take along).  Same shifts as Play_findHand.
+static inline Cards Play_danger(Cards pool, Cards runs, Cards sets) {
+    Cards low = Cards_addLowAces(pool);
+    Cards below = low << 1, above = low >> 1;
+    Cards runDanger = (below & above) | (above & (low >> 2)) | (below & (low << 2));
+    Cards runExtensions = (runs << 1) | (runs >> 1);
+
+    Cards left = (pool << 16) | (pool >> 48);
+    Cards right = (pool >> 16) | (pool << 48);
+    Cards across = (pool << 32) | (pool >> 32);
+    Cards setDanger = (left & right) | (left & across) | (right & across);
+    Cards setExtensions = (sets << 16) | (sets >> 16);
+
+    Cards table = Cards_toHighAces(runs) | sets;
+    return (Cards_toHighAces(runDanger | runExtensions) | setDanger | setExtensions) & FULL_DECK & ~table;
+}
+
+static inline void Play_find(Game *game, Play *play) {
+    Table *table = &(game->table);
+    Play_findHand(play, Game_currentPlayer(game)->hand, table->runs, table->sets);
+}
+
+// Incremental maintenance.  Every option is a few shifts of the hand and
+// the table, and shifts distribute over the set operations, so an option
+// word can follow a change to the hand or the table without looking at
+// the rest: removing cards from the hand clears the options they took
+// part in, and adding melds to the table ORs in the extensions they make.
+// The results equal Play_findHand() on the new hand and table.  There is
+// no undo: callers keep the four words from before the change.
+
+// After removing cards (aces high) from the hand.
+static inline void Play_removeCards(Play *play, Cards removed) {
+    Cards low = Cards_addLowAces(removed);
+    play->runCenters &= ~(removed | (removed << 1) | (removed >> 1));
+    play->setCenters &= ~(removed | (removed << 16) | (removed >> 48) | (removed >> 16) | (removed << 48));
+    play->runExtensions &= ~low;
+    play->setExtensions &= ~low;
+}
+
+// After adding cards to the hand, which now holds them.  The centers are
+// found again: that is no more work than finding the ones added.
+static inline void Play_addCards(Play *play, Cards hand, Cards added, Cards runs, Cards sets) {
+    Cards low = Cards_addLowAces(added);
+    play->runCenters = Cards_runCenters(hand);
+    play->setCenters = Cards_setCenters(hand);
+    play->runExtensions |= ((runs << 1) | (runs >> 1)) & low;
+    play->setExtensions |= ((sets << 16) | (sets >> 16)) & low;
+}
+
+// After Player_playRun(meld), with the hand as it is left.
+static inline void Play_meldRun(Play *play, Cards hand, Cards meld) {
+    Play_removeCards(play, Cards_toHighAces(meld));
+    play->runExtensions |= ((meld << 1) | (meld >> 1)) & Cards_addLowAces(hand);
+}
+
+// After Player_playSet(meld), with the hand as it is left.
+static inline void Play_meldSet(Play *play, Cards hand, Cards meld) {
+    Play_removeCards(play, meld);
+    play->setExtensions |= ((meld << 16) | (meld >> 16)) & Cards_addLowAces(hand);
+}
+
+static inline bool Play_equal(const Play *a, const Play *b) {
+    return a->runCenters == b->runCenters && a->runExtensions == b->runExtensions &&
+           a->setCenters == b->setCenters && a->setExtensions == b->setExtensions;
 }
 
-void Play_exclude(Play *play, Play *rejected) {
+static inline void Play_exclude(Play *play, Play *rejected) {
     play->runCenters &= ~rejected->runCenters;
     play->runExtensions &= ~rejected->runExtensions;
     play->setCenters &= ~rejected->setCenters;
     play->setExtensions &= ~rejected->setExtensions;
 }
 
-bool Play_none(Play *play) {
+static inline bool Play_none(Play *play) {
     return (play->runCenters == 0 && play->runExtensions == 0 &&
             play->setCenters == 0 && play->setExtensions == 0);
 }
 
-Cards Play_runCenterToMeld(Cards center) {
+static inline Cards Play_runCenterToMeld(Cards center) {
     return center | (center << 1) | (center >> 1);
 }
 
-Cards Play_setCenterToMeld(Cards center) {
+static inline Cards Play_setCenterToMeld(Cards center) {
     return center |(center << 16) | (center >> 16) | (center >> 48) | (center << 48);
 }
 
@@ -0,0 +1,40 @@
+#ifndef POSITION_H
+#define POSITION_H
+
+// A one-line notation for a whole position, for files of positions to
+// analyze and for the protocol's "position" command:
+//
+//   <hands> <drawpile> <discardpile> <runs> <sets> <scores> <tomove> [<known>]
+//
+// e.g. "8C9CTC2H2D2S4C/3D4D7H8HJSQSKD/5S6S9DTD3HAH6C 7D KS - - 0/0/0 0"
+//
+// Card lists are written as in the protocol: two characters per card with
+// no separators, or "-" for none, piles from the bottom up.  Hands, scores
+// and the optional known cards (see Player.known) have one entry per
+// player, separated by "/"; the number of hands is the number of players,
+// MIN_PLAYERS to MAX_PLAYERS.
+// Fields are separated by spaces or tabs.
+//
+// The parser reads each card with Card_parse() and checks a whole list at
+// once, then checks the position with Game_validate().  It reports the
+// first error rather than stopping the program.
+
+#include "game.h"
+
+#define POSITION_MAX 512   // longest notation, with its terminating NUL
+
+// Reads a card list word up to the first space, tab, '/', newline or NUL.
+// Returns a pointer past it, or NULL if a card is malformed or repeated
+// (then *cards and pile are unspecified).  pile may be NULL.
+const char *Position_parseCards(const char *s, Cards *cards, Pile *pile);
+
+// Sets up the game from the notation, which may end with a newline.
+// Returns NULL, or a short description of the first error, with *column
+// (if not NULL) set to where it was found; the game is then unspecified.
+const char *Position_parse(Game *game, const char *line, int *column);
+
+// Writes the notation of the game into buf, POSITION_MAX chars, and
+// returns its length.  The known cards are written only if there are any.
+int Position_format(Game *game, char *buf);
+
+#endif // POSITION_H
@@ -0,0 +1,62 @@
+#ifndef POTENTIAL_H
+#define POTENTIAL_H
+
+// Meld potential: how close the cards in a hand are to forming melds.
+//
+// An "out" is a card that would complete a meld with two cards of the
+// hand: the missing card of a gapped pair (5H 7H), either end of an
+// adjacent pair (5H 6H), or a missing suit of a pair of one value.  Outs
+// that are dead (melded, buried in the discard pile, or known to be in a
+// rival's hand) are not counted.  The potential is the number of live
+// outs, for runs and sets separately.
+//
+// Runs are looked up per suit, in a table indexed by the suit's cards from
+// two to ace; sets per value, in a table indexed by the suits holding the
+// value in the hand and among the dead cards.  The tables are built at
+// startup.
+
+#include <stdint.h>
+#include "cards.h"
+#include "suits.h"
+
+// The run outs of one suit, indexed by the suit's bits for two to high ace;
+// the result uses the same 14-bit layout as Cards_suit(), aces high.
+extern uint16_t Potential_runOuts[1 << 13];
+
+// The number of live set outs of one value, indexed by (hand | dead << 4),
+// each a 4-bit set of suits.
+extern uint8_t Potential_setOuts[1 << 8];
+
+static inline unsigned Potential_suitRuns(Cards hand, Cards dead, int suit) {
+    unsigned outs = Potential_runOuts[(hand >> (16 * suit + 1)) & 0x1FFF];
+    return outs & ~Cards_suit(dead, suit);
+}
+
+static inline int Potential_runs(Cards hand, Cards dead) {
+    int outs = 0;
+    for (int suit = 0; suit < NUM_SUITS; ++suit) {
+        outs += __builtin_popcount(Potential_suitRuns(hand, dead, suit));
+    }
+    return outs;
+}
+
+// hand and dead as returned by Cards_transpose().
+static inline int Potential_valueSets(uint64_t hand, uint64_t dead, int value) {
+    return Potential_setOuts[((hand >> (4 * value)) & 0xF) | (((dead >> (4 * value)) & 0xF) << 4)];
+}
+
+static inline int Potential_sets(uint64_t hand, uint64_t dead) {
+    int outs = 0;
+    for (int value = 1; value < 14; ++value) {
+        outs += Potential_valueSets(hand, dead, value);
+    }
+    return outs;
+}
+
+// Hands hold high aces only; dead may hold either, as runs on the table do.
+static inline int Potential_outs(Cards hand, Cards dead) {
+    dead = Cards_toHighAces(dead);
+    return Potential_runs(hand, dead) + Potential_sets(Cards_transpose(hand), Cards_transpose(dead));
+}
+
+#endif // POTENTIAL_H
@@ -0,0 +1,156 @@
+#ifndef PROTOCOL_H
+#define PROTOCOL_H
+
+// The RumBot engine protocol, spoken by bin/rumd over stdin/stdout or over
+// a Unix socket.  It is a line protocol in the spirit of UCI: the client
+// sends one command per line, and the engine answers with zero or more
+// lines.  Words are separated by single or repeated spaces.
+//
+// Cards are written as two characters, value then suit, with values
+// "A23456789TJQK" and suits "CDHS"; "a" is an ace played low in a run.  A
+// list of cards is written as one word with no separators ("8C9CTC"), or
+// as "-" for the empty list.  Piles are listed from the bottom up, so the
+// last card of a discard pile is the one on top.  Players are numbered
+// from 0.
+//
+// Session commands:
+//   rumbot                 -> "id name RumBot", then "rumbotok"
+//   isready                -> "readyok"
+//   quit                   -> closes the session, stopping any search
+//   trace <level>          set the run-time trace level for the whole
+//                          process (see include/trace.h).  Records made by
+//                          a search are printed as "trace ..." lines just
+//                          before its result; from level 2 (info) on, its
+//                          start, its end and what answered it
+//   cache <bits>           give every search thread an evaluation cache of
+//                          2^bits entries (see include/evalcache.h); 0
+//                          turns it off.  Every search of an Engine runs
+//                          on its one thread, so the cache lasts from one
+//                          go to the next, and from one session to the next
+//   multipv <k>            report the best k distinct turns of each search,
+//                          1 to 8, 1 at the start; see "go"
+//   endgame <stock>        solve positions exactly once the stock holds
+//                          <stock> cards or fewer (see include/endgame.h),
+//                          reading every hand and the order of the stock;
+//                          0 turns it off, as it is at the start
+//   lookahead <turns> [maxn|paranoid]
+//                          search that many turns ahead, the turns of the
+//                          players after this one included, backing the
+//                          values up by the rule given, paranoid if none
+//                          (see include/lookahead.h).  It too reads every
+//                          hand and the stock.  go's limits still apply:
+//                          the answer is from the deepest search that
+//                          completed.  0 turns it off, as it is at the start
+//
+// The end of the input also closes the session, but only after a running
+// search has finished and printed its result.
+//
+// Position commands (refused with "error busy" while a search is running):
+//   newgame                deal a random game; player 0 is to move
+//   clear                  empty hands, piles, table and scores
+//   players <n>            clear for n players, 2 to 6; the count stays
+//                          for newgame and clear, and is 3 at the start,
+//                          while "position" takes it from its hands
+//   hand <p> <cards>       set the hand of player p
+//   score <p> <points>     set the score of player p, -10000 to 10000
+//   known <p> <cards>      set the cards player p was seen to take from
+//                          the discard pile and may still hold
+//   drawpile <cards>       set the stock, bottom first
+//   discardpile <cards>    set the discard pile, bottom first
+//   runs <cards>           set the runs on the table
+//   sets <cards>           set the sets on the table
+//   tomove <p>             set the player to move
+//   position <notation>    set the whole position from its one-line
+//                          notation (include/position.h); on an error the
+//                          position is unchanged and the engine answers
+//                          "error <reason> at column <n>"
+//   show                   prints the position as the commands above that
+//                          would rebuild it, "players" first, then as
+//                          "position <notation>", followed by "end"
+//
+// Search commands:
+//   go [nodes <n>] [movetime <ms>] [infinite] [ponder]
+//                          search the turn of the player to move in the
+//                          background.  Without limits the search runs to
+//                          completion.  When it finishes the engine prints
+//                              info nodes <n> time <ms>
+//                              bestmove <start> runs <cards> sets <cards>
+//                                       discard <card or -> eval <n>
+//                          where <start> is "draw" or "take <k>".  If the
+//                          player has no legal turn, "bestmove none".
+//                          With multipv above 1, the bestmove line is
+//                          preceded by the turns found, best first:
+//                              info multipv <i> <start> runs ... eval <n>
+//                          With "ponder" the result is held back until
+//                          "ponderhit" or "stop".
+//   stop                   end the running search early; its best move so
+//                          far is printed
+//   ponderhit              the pondered position is the real one; the
+//                          result is printed as soon as the search is done
+//   stats                  totals over every search of the session:
+//                              stats nodes <n> chance <n> take <n> meld <n>
+//                                    discard <n> solver <n> prunes <n>
+//                                    branching <x> cache <hits>/<probes>
+//                          where solver counts the positions of the endgame
+//                          solver and the lookahead
+//                              stats cycles find <calls>@<cycles per call>
+//                                    eval <calls>@<c> movegen <calls>@<c>
+//   histogram [json]       latency histograms over every search made by
+//                          the process: decision_ns, decision_nodes and
+//                          first_move_ns, one line each:
+//                              histogram <name> count <n> mean <n> min <n>
+//                                        p50 <n> p90 <n> p99 <n> p999 <n>
+//                                        max <n>
+//                          or with "json", one JSON object on one line
+//                          that also lists the non-empty buckets.
+//
+// Any malformed command is answered with "error <reason>" and ignored.
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include "game.h"
+#include "search.h"
+
+// What sessions search with: a Search, the thread that runs its searches
+// and the endgame and lookahead tables.  The caller owns it and serves one
+// session at a time with it, so all of it, and the thread's evaluation
+// cache, carries over from one session to the next.
+typedef struct EngineStruct {
+    Search *search;       // owned by the caller
+    struct EndgameStruct *endgame; // made by the first "endgame", if any
+    struct LookaheadStruct *lookahead; // made by the first "lookahead", if any
+    pthread_mutex_t lock; // guards the fields below
+    pthread_cond_t wake;  // a search to run, or the engine is destroyed
+    pthread_t thread;     // runs every search, started by the first go
+    struct SessionStruct *job; // the session whose search is to run
+    bool started;         // the thread exists
+    bool quit;            // the thread should exit
+} Engine;
+
+void Engine_init(Engine *engine, Search *search);
+void Engine_destroy(Engine *engine);
+
+typedef struct SessionStruct {
+    FILE *in;
+    FILE *out;
+    Engine *engine;
+    Search *search;       // the engine's
+    Game game;
+    SearchStats stats;    // merged from every search of the session
+    pthread_mutex_t lock; // guards out and the flags below
+    pthread_cond_t done;  // the search has finished
+    bool searching;       // a search was started and not yet collected
+    bool running;         // the search has not finished
+    bool pondering;       // hold the result back until ponderhit or stop
+    bool pending;         // finished while pondering; result not printed
+} Session;
+
+// Starts a session with the engine's search settings (multipv, endgame,
+// lookahead) back at their defaults.
+void Session_init(Session *session, Engine *engine, FILE *in, FILE *out);
+void Session_destroy(Session *session);
+bool Session_command(Session *session, char *line);
+void Session_run(Session *session);
+
+#endif // PROTOCOL_H
@@ -0,0 +1,30 @@
+#ifndef RANDOM_H
+#define RANDOM_H
+
+// A small, fast, seedable random number generator (splitmix64), for code
+// that must be able to replay exactly what it did.  Pile_shuffle() is the
+// choice when reproducibility does not matter.
+
+#include <stdint.h>
+
+typedef struct RandomStruct {
+    uint64_t state;
+} Random;
+
+static inline void Random_seed(Random *random, uint64_t seed) {
+    random->state = seed;
+}
+
+static inline uint64_t Random_next(Random *random) {
+    uint64_t z = (random->state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+// Returns a number from 0 to n - 1.
+static inline uint32_t Random_uniform(Random *random, uint32_t n) {
+    return (uint32_t)(((Random_next(random) >> 32) * n) >> 32);
+}
+
+#endif // RANDOM_H
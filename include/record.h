@@ -0,0 +1,114 @@
+#ifndef RECORD_H
+#define RECORD_H
+
+// Binary game records, for logging self-play at volume and replaying it
+// without parsing text.
+//
+// A record file is a 32-byte file header followed by 32-byte records:
+//   header   "RUMBOTGR", then the format version and the record size as
+//            little-endian uint32s, then zeros
+//   game     starts a game: the seed of its deal (Game_initSeeded()), the
+//            number of players and the search's node limit
+//   turn     one turn of the game last started, as Game_play() played it:
+//            the mover, how many cards were taken from the discard pile (0
+//            for a draw), the card drawn, the melds, the discard and the
+//            search's evaluation
+// A game ends where the next one starts or at the end of the file.  The
+// fields are written in the machine's byte order, which must be little
+// endian; the reader refuses anything else.
+//
+// RecordWriter buffers records and writes them in blocks.  RecordReader
+// maps a file into memory and hands out its records in place.
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include "game.h"
+#include "turn.h"
+
+#define RECORD_VERSION 1
+#define RECORD_BUFFER 2048   // records per write
+#define RECORD_NO_CARD 0xFF
+
+typedef enum {
+    RECORD_HEADER,
+    RECORD_GAME,
+    RECORD_TURN,
+} RecordKind;
+
+typedef struct RecordStruct {
+    uint8_t kind;
+    uint8_t player;    // game: number of players; turn: the mover
+    uint8_t taken;     // turn: cards taken from the discard pile
+    uint8_t drawn;     // turn: the Card drawn, or RECORD_NO_CARD
+    uint8_t discard;   // turn: the Card discarded, or RECORD_NO_CARD
+    uint8_t unused[3];
+    union {
+        struct {
+            char magic[8];
+            uint32_t version;
+            uint32_t recordSize;
+            uint64_t unused;
+        } header;
+        struct {
+            uint64_t seed;
+            uint64_t nodes;    // the search's node limit, 0 if none
+            uint64_t unused;
+        } game;
+        struct {
+            Cards runs;
+            Cards sets;
+            int32_t eval;
+            int32_t unused;
+        } turn;
+    };
+} Record;
+
+_Static_assert(sizeof(Record) == 32, "records are 32 bytes");
+
+typedef struct RecordWriterStruct {
+    FILE *out;
+    int used;            // records in the buffer
+    uint64_t games;
+    uint64_t turns;
+    bool failed;         // a write failed; later writes are dropped
+    Record buffer[RECORD_BUFFER];
+} RecordWriter;
+
+// Writes the file header.  The writer does not own out.
+void RecordWriter_init(RecordWriter *writer, FILE *out);
+void RecordWriter_game(RecordWriter *writer, uint64_t seed, int numPlayers, uint64_t nodes);
+// The mover's Player.turn after Game_play().
+void RecordWriter_turn(RecordWriter *writer, int player, const Turn *turn);
+// Writes out the buffer.  Returns false if any write has failed.
+bool RecordWriter_flush(RecordWriter *writer);
+
+typedef struct RecordGameStruct {
+    const Record *start;   // the game record
+    const Record *turns;
+    int numTurns;
+} RecordGame;
+
+typedef struct RecordReaderStruct {
+    void *map;
+    size_t mapSize;
+    const Record *records;
+    size_t count;          // records after the file header
+    size_t next;
+} RecordReader;
+
+// Maps the file.  Returns NULL, or a short description of why the file
+// cannot be read, in which case there is nothing to close.
+const char *RecordReader_open(RecordReader *reader, const char *path);
+// Steps to the next game.  Returns false at the end of the file.  Turns
+// before the first game are skipped.
+bool RecordReader_nextGame(RecordReader *reader, RecordGame *game);
+void RecordReader_close(RecordReader *reader);
+
+// Deals the game and plays its turns.  Returns NULL, or a short description
+// of the first turn that cannot be played, with the game left as it was
+// before that turn.
+const char *Record_replay(const RecordGame *record, Game *game);
+
+#endif // RECORD_H
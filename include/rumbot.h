@@ -0,0 +1,116 @@
+#ifndef RUMBOT_H
+#define RUMBOT_H
+
+// librumbot: the RumBot engine as an embeddable C library.
+//
+// An engine context (Rumbot) owns a position and everything the search
+// keeps warm between calls.  Contexts share no state, so any number of
+// them may be used at once from different threads; a single context must
+// not be used from two threads at the same time, except that Rumbot_stop()
+// may be called while another thread is inside Rumbot_search().  Nothing
+// in this library writes to stdout or stderr.
+//
+// Cards use the engine's bitboard layout: bit (16 * suit + value), with
+// suits 0-3 = clubs, diamonds, hearts, spades and values 0 = ace played
+// low, 1-12 = two to king, 13 = ace.  Hands and piles always use the high
+// ace; only runs on the table use the low-ace bit.  Piles are listed as
+// card indices (the bit numbers above) from the bottom up.
+//
+// Functions that can fail return RUMBOT_OK or a negative RUMBOT_E* code.
+// This header is the whole of the stable interface; RUMBOT_API_VERSION
+// changes whenever it changes incompatibly.
+
+#include <stdint.h>
+
+#define RUMBOT_API_VERSION 5
+
+#define RUMBOT_MAX_PLAYERS 6
+
+#define RUMBOT_OK 0
+#define RUMBOT_EINVAL (-1)   // malformed or inconsistent argument
+#define RUMBOT_ENOMOVE (-2)  // the player to move has no legal turn
+
+#if defined(__GNUC__)
+#define RUMBOT_API __attribute__((visibility("default")))
+#else
+#define RUMBOT_API
+#endif
+
+typedef struct RumbotStruct Rumbot;
+
+typedef struct RumbotPositionStruct {
+    int numPlayers;                      // 2 to RUMBOT_MAX_PLAYERS
+    int toMove;
+    uint64_t hands[RUMBOT_MAX_PLAYERS];
+    int scores[RUMBOT_MAX_PLAYERS];      // -10000 to 10000
+    uint8_t drawPile[52];
+    int drawPileSize;
+    uint8_t discardPile[52];
+    int discardPileSize;
+    uint64_t runs;
+    uint64_t sets;
+    uint64_t known[RUMBOT_MAX_PLAYERS];  // cards each player was seen to take
+} RumbotPosition;
+
+typedef struct RumbotLimitsStruct {
+    uint64_t nodes;   // 0 = no limit
+    int timeMs;       // 0 = no limit
+} RumbotLimits;
+
+typedef struct RumbotResultStruct {
+    int take;         // cards taken from the discard pile; 0 = draw
+    uint64_t runs;    // cards melded into runs (new runs and lay-offs)
+    uint64_t sets;    // cards melded into sets (new sets and lay-offs)
+    uint64_t discard; // card discarded, 0 when going out
+    int eval;
+} RumbotResult;
+
+#define RUMBOT_PHASE_CHANCE 0   // turns begun by drawing from the stock
+#define RUMBOT_PHASE_TAKE 1     // turns begun by taking from the discard pile
+#define RUMBOT_PHASE_MELD 2     // meld nodes
+#define RUMBOT_PHASE_DISCARD 3  // leaves: discards and going out
+#define RUMBOT_NUM_PHASES 4
+
+#define RUMBOT_TIMER_FIND 0     // meld option update for the meld just played
+#define RUMBOT_TIMER_EVAL 1     // static evaluation of all discards from a hand
+#define RUMBOT_TIMER_MOVEGEN 2  // all option generation at a meld node
+#define RUMBOT_NUM_TIMERS 3
+
+// Totals over every search made with a context.
+typedef struct RumbotStatsStruct {
+    uint64_t searches;   // completed calls to Rumbot_search
+    uint64_t nodes;      // leaves evaluated, all searches
+    uint64_t elapsedNs;  // time spent searching, all searches
+    uint64_t lastNodes;  // leaves evaluated by the last search
+    uint64_t lastNs;     // time spent by the last search
+    uint64_t phaseNodes[RUMBOT_NUM_PHASES];
+    uint64_t prunes;
+    uint64_t cacheProbes;
+    uint64_t cacheHits;
+    double branching;    // average options per expanded meld node
+    uint64_t timerCalls[RUMBOT_NUM_TIMERS];
+    double cyclesPerCall[RUMBOT_NUM_TIMERS];
+} RumbotStats;
+
+#define RUMBOT_FORMAT_TEXT 0
+#define RUMBOT_FORMAT_JSON 1
+
+RUMBOT_API int Rumbot_apiVersion(void);
+
+RUMBOT_API Rumbot *Rumbot_create(void);
+RUMBOT_API void Rumbot_destroy(Rumbot *rb);
+
+RUMBOT_API int Rumbot_loadPosition(Rumbot *rb, const RumbotPosition *position);
+RUMBOT_API int Rumbot_search(Rumbot *rb, const RumbotLimits *limits, RumbotResult *result);
+RUMBOT_API void Rumbot_stop(Rumbot *rb);
+RUMBOT_API void Rumbot_stats(const Rumbot *rb, RumbotStats *stats);
+
+// Writes the latency histograms of every search made with the context
+// (decision time, nodes per decision, time to first legal turn) into buf as
+// text or JSON, in the format of the daemon's "histogram" command.  Like
+// snprintf, returns the length of the full report, which was truncated if
+// that is not less than size.  May be called from any thread, even while a
+// search is running.
+RUMBOT_API int Rumbot_histograms(const Rumbot *rb, int format, char *buf, int size);
+
+#endif // RUMBOT_H
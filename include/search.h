@@ -0,0 +1,86 @@
+#ifndef SEARCH_H
+#define SEARCH_H
+
+// Single-turn search for the current player.  Every way to begin the turn
+// (draw from the stock, or take one or more cards off the discard pile),
+// every combination of melds, and every discard is tried, and the turn with
+// the highest evaluation is kept in search->best.  The evaluation is
+// Eval_evaluate() unless search->evaluator is set to another.
+//
+// The card drawn from the stock is not known when the turn is planned, so
+// the draw option is searched with the hand as it stands.  Its melds and
+// discard are a plan that can only improve once the card is seen.  A turn
+// that takes from the discard pile must meld the deepest card taken.
+//
+// A search is prepared with Search_start() and executed with Search_run().
+// The two are separate so that Search_run() can be handed to another thread
+// while the starting thread keeps the right to call Search_stop().  A Search
+// may be reused for any number of positions.
+//
+// Discard evaluations go through the thread's EvalCache (evalcache.h).  The
+// evaluator is fixed by Search_start(); set search->evaluator before it.
+//
+// With search->multiPV above 1, search->top keeps that many of the best
+// distinct turns, from the same pass: each discard node offers its best
+// multiPV discards rather than its best one, and only those that beat the
+// worst turn kept cost more than a comparison.  The evaluation cache holds
+// one discard per node, so it is not used then.  search->best is the first
+// of them.  The answers below that come without a turn search keep only
+// their one turn.
+//
+// A first turn found in search->book is answered from the book without a
+// search, with no nodes.  The book must have been solved with the same
+// evaluator.  A position search->endgame applies to is solved exactly,
+// with every hand and the stock in view, and search->nodes counts the
+// positions it searched; if the solve runs out of time or nodes, the turn
+// search follows.  Otherwise, with search->lookahead set, the turns of the
+// players after this one are searched too (lookahead.h), with the same
+// evaluator, deadline and node limit; the turn search follows only if not
+// even one turn was searched in time.
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include "eval.h"
+#include "game.h"
+#include "histogram.h"
+#include "stats.h"
+#include "turn.h"
+
+typedef struct SearchLimitsStruct {
+    uint64_t nodes;   // stop after this many leaves (0 = no limit)
+    int timeMs;       // stop after this many milliseconds (0 = no limit)
+} SearchLimits;
+
+typedef struct SearchStruct {
+    Game *game;
+    const Evaluator *evaluator; // Eval_handTuned after Search_init()
+    SearchLimits limits;
+    atomic_bool stop;
+    uint64_t deadline;  // CLOCK_MONOTONIC nanoseconds, 0 if none
+    uint64_t nodes;     // leaves evaluated by the last run
+    uint64_t startNs;
+    uint64_t elapsedNs; // wall time of the last run
+    uint64_t firstMoveNs; // time until the last run found a legal turn
+    SearchStats stats;  // counters for the last run
+    DecisionHistograms *histograms; // every run is recorded here, if not NULL
+    uint64_t cacheSeed; // what EvalCache_key() does not cover, see Search_start()
+    const struct BookStruct *book; // answers first turns, if not NULL (book.h)
+    struct EndgameStruct *endgame; // solves small stocks, if not NULL (endgame.h)
+    struct LookaheadStruct *lookahead; // searches several turns, if not NULL (lookahead.h)
+    int multiPV;        // turns kept in top, 1 after Search_init()
+    TopTurns top;       // the best multiPV distinct turns of the last run
+    Turn best;
+} Search;
+
+void SearchLimits_init(SearchLimits *limits);
+
+void Search_init(Search *search);
+void Search_start(Search *search, Game *game, const SearchLimits *limits);
+int Search_run(Search *search);
+void Search_stop(Search *search);
+bool Search_stopped(Search *search);
+
+uint64_t Search_nowNs(void);
+
+#endif // SEARCH_H
@@ -0,0 +1,109 @@
+#ifndef STATS_H
+#define STATS_H
+
+// Search statistics: nodes per phase, pruning, branching, and cycle timers
+// around the search's inner functions.
+//
+// Every Search owns a SearchStats that only its own thread writes, so the
+// counters are plain integers.  Search_start() clears them; callers that
+// want totals across searches or threads merge them with
+// SearchStats_merge() once a search is over.
+//
+// Counting is compiled in unless STATS is 0 ("make STATS=0").  Timers read
+// the cycle counter on only one call in STATS_SAMPLE_PERIOD, chosen from a
+// count the caller already keeps (leaves for the evaluator, meld nodes for
+// move generation), so that timing adds no counter of its own to the hot
+// path.  The reported cycles per call are averaged over the sampled calls.
+
+#include <stdint.h>
+#include <stdio.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#else
+#include <time.h>
+#endif
+
+#ifndef STATS
+#define STATS 1
+#endif
+
+#define STATS_SAMPLE_PERIOD 256  // a power of two
+
+typedef enum {
+    PHASE_CHANCE,   // a turn begun by drawing an unseen card from the stock
+    PHASE_TAKE,     // a turn begun by taking from the discard pile
+    PHASE_MELD,     // a meld node: options generated, each tried
+    PHASE_DISCARD,  // a leaf: a discard (or going out) evaluated
+    PHASE_COUNT
+} SearchPhase;
+
+typedef enum {
+    TIMER_FIND,     // meld option update: Play_meldRun, Play_meldSet
+    TIMER_EVAL,     // Eval_evaluate, Eval_discards
+    TIMER_MOVEGEN,  // all option generation at a meld node, the update included
+    TIMER_COUNT
+} StatsTimer;
+
+typedef struct SearchStatsStruct {
+    uint64_t nodes[PHASE_COUNT];
+    uint64_t expanded;       // meld nodes that generated at least one option
+    uint64_t children;       // options generated at those nodes
+    uint64_t prunes;         // branches cut: illegal takes and stopped loops
+    uint64_t solver;         // positions searched by the endgame solver and
+                             // the lookahead, in place of the phases
+    uint64_t cacheProbes;
+    uint64_t cacheHits;
+    uint64_t calls[TIMER_COUNT];  // find and movegen filled in at the end
+    uint64_t sampled[TIMER_COUNT];
+    uint64_t cycles[TIMER_COUNT]; // over the sampled calls only
+} SearchStats;
+
+extern const char *kPhaseName[PHASE_COUNT];
+extern const char *kTimerName[TIMER_COUNT];
+
+void SearchStats_init(SearchStats *stats);
+void SearchStats_merge(SearchStats *total, const SearchStats *stats);
+uint64_t SearchStats_nodes(const SearchStats *stats);
+double SearchStats_branching(const SearchStats *stats);
+double SearchStats_cyclesPerCall(const SearchStats *stats, StatsTimer timer);
+void SearchStats_print(const SearchStats *stats, FILE *out);
+
+static inline uint64_t Stats_cycles(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+#endif
+}
+
+// Starts a timer if count is a sampled call.  Returns 0 if not sampled.
+static inline uint64_t Stats_timerBegin(uint64_t count) {
+    if ((count & (STATS_SAMPLE_PERIOD - 1)) != 0) {
+        return 0;
+    }
+    return Stats_cycles();
+}
+
+static inline void Stats_timerEnd(SearchStats *stats, StatsTimer timer, uint64_t start) {
+    if (start != 0) {
+        stats->cycles[timer] += Stats_cycles() - start;
+        stats->sampled[timer]++;
+    }
+}
+
+#if STATS
+#define STATS_ADD(stats, field, n) ((stats)->field += (n))
+#define STATS_TIMER_BEGIN(timer, count) uint64_t statsStart##timer = Stats_timerBegin(count)
+#define STATS_TIMER_END(stats, timer) Stats_timerEnd((stats), (timer), statsStart##timer)
+#else
+#define STATS_ADD(stats, field, n) ((void)0)
+#define STATS_TIMER_BEGIN(timer, count) ((void)0)
+#define STATS_TIMER_END(stats, timer) ((void)0)
+#endif
+
+#define STATS_COUNT(stats, field) STATS_ADD(stats, field, 1)
+
+#endif // STATS_H
@@ -0,0 +1,70 @@
+#ifndef SUITS_H
+#define SUITS_H
+
+// Gathering and scattering the suit fields of a Cards.
+//
+// Each suit of a Cards is a 14-bit field (low ace to high ace) at bit
+// 16 * suit, so one suit comes out with a shift and a mask, and the two
+// aces trade places with a shift (Cards_addLowAces, Cards_toHighAces).
+// What needs real gather/scatter is moving cards across suits: packing the
+// 52 cards of a deck into 52 dense bits, and turning a hand on its side so
+// the suits holding each value sit together.  Those use the BMI2
+// instructions PEXT and PDEP when the CPU has fast ones, chosen once at
+// startup, and portable shifts and masks otherwise.
+//
+// Canonicalization renames suits so that positions that differ only by
+// suit names compare equal, e.g. as keys of the run and set tables or of
+// an opening book.
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "cards.h"
+
+#define NUM_SUITS 4
+#define SUIT_MASK 0x3FFFULL   // the 14 bits of one suit, low ace to high ace
+
+static inline unsigned Cards_suit(Cards cards, int suit) {
+    return (unsigned)((cards >> (16 * suit)) & SUIT_MASK);
+}
+
+static inline Cards Cards_fromSuit(unsigned field, int suit) {
+    return ((Cards)field & SUIT_MASK) << (16 * suit);
+}
+
+// The 4-bit set of suits in which cards holds the given value.
+static inline unsigned Cards_valueSuits(Cards cards, int value) {
+    Cards v = (cards >> value) & LOW_ACES;
+    return (unsigned)((v | (v >> 15) | (v >> 30) | (v >> 45)) & 0xF);
+}
+
+static inline Cards Cards_fromValueSuits(unsigned suits, int value) {
+    Cards s = suits & 0xF;
+    return ((s | (s << 15) | (s << 30) | (s << 45)) & LOW_ACES) << value;
+}
+
+// Whether the gathers below use PEXT and PDEP.
+bool Suits_bmi2(void);
+// Switches between PEXT/PDEP and the portable code, for tests and
+// benchmarks; asking for BMI2 on a CPU without it changes nothing.
+void Suits_useBmi2(bool use);
+
+// The 52 cards of a deck (two to high ace; low aces are ignored) as dense
+// bits: bit (13 * suit + value - 1).  Cards_unpack() is the inverse.
+uint64_t Cards_pack(Cards cards);
+Cards Cards_unpack(uint64_t packed);
+
+// The cards by value: bit (4 * value + suit), so each nibble is the
+// Cards_valueSuits() of one value.  Cards_untranspose() is the inverse.
+uint64_t Cards_transpose(Cards cards);
+Cards Cards_untranspose(uint64_t transposed);
+
+// Moves every card of suit s to suit perm[s]; perm must be a permutation.
+Cards Cards_permuteSuits(Cards cards, const uint8_t perm[NUM_SUITS]);
+
+// Finds the renaming of suits that puts the given n (at most 4) Cards in
+// canonical form: suits ordered by their fields in cards[0], ties broken by
+// cards[1], and so on, highest first.  Suits that tie throughout keep their
+// relative order.  Apply with Cards_permuteSuits().
+void Cards_canonicalSuits(const Cards *cards, int n, uint8_t perm[NUM_SUITS]);
+
+#endif // SUITS_H
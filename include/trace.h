@@ -0,0 +1,97 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+// Tracing for the engine's hot paths.
+//
+//   TRACE(TRACE_LEAF, TRACE_EV_LEAF, eval, hand, runs, sets, discard);
+//
+// A trace point is compiled in only if its level is at most TRACE_LEVEL
+// (set at build time, "make TRACE_LEVEL=4"); above that it compiles to
+// nothing, arguments included.  A compiled-in trace point records only if
+// its level is also at most the run-time level set with Trace_setLevel(),
+// which starts at TRACE_OFF.
+//
+// A search records its start and end, and what answered it if not the turn
+// search, at TRACE_INFO, which is built in by default; each leaf it
+// evaluates at TRACE_LEAF.
+//
+// Recording never formats or writes anything.  It copies a fixed-size
+// record into a ring buffer owned by the calling thread, overwriting the
+// oldest record when the ring is full.  Trace_flush() formats and empties
+// the calling thread's ring; call it once the hot path is over, e.g. after
+// a search.
+
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#define TRACE_OFF   0
+#define TRACE_ERROR 1
+#define TRACE_INFO  2
+#define TRACE_DEBUG 3
+#define TRACE_LEAF  4
+
+#ifndef TRACE_LEVEL
+#define TRACE_LEVEL TRACE_INFO
+#endif
+
+#define TRACE_RING_SIZE 4096  // records per thread, a power of two
+
+typedef enum {
+    TRACE_EV_SEARCH_START,  // hand, draw pile size, discard pile size
+    TRACE_EV_SEARCH_END,    // nodes, elapsed ns, best eval
+    TRACE_EV_LEAF,          // hand, runs, sets, discard (eval in value)
+    TRACE_EV_ANSWER,        // a literal naming what answered (eval in value)
+    TRACE_EV_MESSAGE,       // args[0] is a const char * to a literal
+    TRACE_EV_COUNT
+} TraceEvent;
+
+typedef struct TraceRecordStruct {
+    uint8_t level;
+    uint8_t event;
+    int32_t value;
+    uint64_t args[4];
+} TraceRecord;
+
+typedef struct TraceRingStruct {
+    uint64_t head;     // records ever written; head % TRACE_RING_SIZE is next
+    uint64_t flushed;  // value of head at the last flush
+    TraceRecord records[TRACE_RING_SIZE];
+} TraceRing;
+
+extern atomic_int Trace_runLevel;
+extern _Thread_local TraceRing *Trace_ring;
+
+TraceRing *Trace_newRing(void);
+void Trace_setLevel(int level);
+void Trace_flush(FILE *out);
+
+static inline int Trace_level(void) {
+    return atomic_load_explicit(&Trace_runLevel, memory_order_relaxed);
+}
+
+static inline void Trace_record(int level, int event, int32_t value,
+                                uint64_t a0, uint64_t a1, uint64_t a2, uint64_t a3) {
+    TraceRing *ring = Trace_ring ? Trace_ring : Trace_newRing();
+    if (!ring) {
+        return;
+    }
+    TraceRecord *r = &ring->records[ring->head++ & (TRACE_RING_SIZE - 1)];
+    r->level = (uint8_t)level;
+    r->event = (uint8_t)event;
+    r->value = value;
+    r->args[0] = a0;
+    r->args[1] = a1;
+    r->args[2] = a2;
+    r->args[3] = a3;
+}
+
+#define TRACE(level, event, value, a0, a1, a2, a3)                              \
+    do {                                                                        \
+        if ((level) <= TRACE_LEVEL && (level) <= Trace_level()) {               \
+            Trace_record((level), (event), (value), (uint64_t)(a0),             \
+                         (uint64_t)(a1), (uint64_t)(a2), (uint64_t)(a3));       \
+        }                                                                       \
+    } while (0)
+
+#endif // TRACE_H
@@ -0,0 +1,94 @@
+#ifndef TTABLE_H
+#define TTABLE_H
+
+// A transposition table of 64-byte buckets, one cache line each, so a
+// probe costs at most one miss to memory however many entries it checks.
+//
+// The low bits of a position's 64-bit key pick the bucket and its top 16
+// bits are the tag an entry is checked against.  An entry is the tag, the
+// index of the best turn, the depth searched, the search it was last
+// stored by (its age) with a Bound (endgame.h), then one 16-bit value per
+// player the entries were set up for: 8 bytes with one value, 8 entries to
+// a bucket; 12 bytes with three, 5 to a bucket.
+//
+// A store goes to the entry with the same tag, else an empty one, else
+// the one that is worth least: shallow and old.  Each search started with
+// TTable_newSearch() ages every entry by one, without touching them.
+//
+// With hugePages the buckets are on huge pages (pages.h).  Probes that do
+// not hit the cache are mostly TLB misses as well as memory misses on a
+// table of megabytes, and a 2 MB page covers 32768 buckets where a 4 kB
+// one covers 64.
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define TTABLE_BUCKET 64           // bytes
+#define TTABLE_MAX_VALUES 6
+#define TTABLE_AGE_WEIGHT 4        // depth a search's worth of age costs
+
+typedef struct TTEntryStruct {
+    uint16_t tag;
+    uint16_t move;       // index of the best turn in its PlanList
+    uint8_t depth;       // 0 for an empty entry
+    uint8_t ageBound;    // age << 2 | bound
+    int16_t values[];    // TTable.numValues of them
+} TTEntry;
+
+typedef struct TTableStruct {
+    uint8_t *buckets;
+    size_t size;         // bytes
+    int bits;            // 1 << bits buckets
+    int numValues;
+    int stride;          // bytes per entry
+    int perBucket;       // entries per bucket
+    uint8_t age;         // of the current search, 6 bits
+    bool hugePages;      // asked for
+    bool hugeMapped;     // got from the reserved pool
+} TTable;
+
+// 1 << bits buckets, empty, with entries for one value.  Returns false if
+// out of memory.
+bool TTable_init(TTable *table, int bits, bool hugePages);
+void TTable_free(TTable *table);
+void TTable_clear(TTable *table);
+
+// Sets up the entries for numValues values (1 to TTABLE_MAX_VALUES),
+// emptying the table if that changes their size.
+void TTable_setValues(TTable *table, int numValues);
+
+static inline void TTable_newSearch(TTable *table) {
+    table->age = (table->age + 1) & 63;
+}
+
+static inline uint8_t *TTable_bucket(const TTable *table, uint64_t key) {
+    return table->buckets + ((key & ((1ULL << table->bits) - 1)) * TTABLE_BUCKET);
+}
+
+// Starts loading the key's bucket; call it as soon as the key is known.
+static inline void TTable_prefetch(const TTable *table, uint64_t key) {
+    __builtin_prefetch(TTable_bucket(table, key));
+}
+
+static inline int TTEntry_bound(const TTEntry *entry) {
+    return entry->ageBound & 3;
+}
+
+// Returns the key's entry and sets *found, or the entry a store of the
+// key should replace.
+TTEntry *TTable_probe(TTable *table, uint64_t key, bool *found);
+
+// Stores into an entry TTable_probe() returned for the key.
+static inline void TTable_store(TTable *table, TTEntry *entry, uint64_t key, int move, int depth,
+                                int bound, const int *values) {
+    entry->tag = (uint16_t)(key >> 48);
+    entry->move = (uint16_t)move;
+    entry->depth = (uint8_t)depth;
+    entry->ageBound = (uint8_t)(table->age << 2 | bound);
+    for (int i = 0; i < table->numValues; ++i) {
+        entry->values[i] = (int16_t)values[i];
+    }
+}
+
+#endif // TTABLE_H
@@ -1,6 +1,8 @@
 #ifndef TURN_H
 #define TURN_H
 
+#include <stdbool.h>
+#include <stdint.h>
 #include "cards.h"
 #include "pile.h"
 #include "table.h"
@@ -17,4 +19,51 @@ void Turn_init(Turn *play);
 int Turn_max(Turn *best, Turn *scratch);
 void Turn_print(Turn *play);
 
+#define TURN_MAX_TOP 8
+
+// A turn as TopTurns keeps it: the cards taken are the top taken cards of
+// the discard pile it was planned on.
+typedef struct TopTurnStruct {
+    Cards runs;
+    Cards sets;
+    Cards draw;
+    Cards discard;
+    int taken;
+    int eval;
+    uint64_t order;   // when it was offered
+} TopTurn;
+
+// The k best distinct turns offered, for reporting alternatives to the
+// best one.  They are kept in a min-heap on eval, so a turn no better than
+// the worst of a full heap is turned away with one comparison.  Turns that
+// start the same way and meld and discard the same cards are the same
+// turn, kept once.  Among equal evaluations the turn offered first ranks
+// first, as with Turn_max().
+typedef struct TopTurnsStruct {
+    int k;
+    int size;
+    uint64_t offered;              // turns admitted
+    uint8_t heap[TURN_MAX_TOP];    // slots, the worst turn's first
+    TopTurn turns[TURN_MAX_TOP];   // by slot
+} TopTurns;
+
+// k is clamped to 1..TURN_MAX_TOP.
+void TopTurns_init(TopTurns *top, int k);
+void TopTurns_add(TopTurns *top, const Turn *turn);
+
+static inline bool TopTurns_admits(const TopTurns *top, int eval) {
+    return top->size < top->k || eval > top->turns[top->heap[0]].eval;
+}
+
+// Writes the turns into out, best first, as planned on the discard pile,
+// and returns how many.
+int TopTurns_sorted(const TopTurns *top, const Pile *discardPile, Turn *out);
+
+#define TURN_FORMAT_MAX 512
+
+// Writes the turn as the protocol's bestmove does, without the word
+// "bestmove": "draw" or "take <k>", then "runs <cards> sets <cards>
+// discard <card or -> eval <n>".  buf holds TURN_FORMAT_MAX chars.
+int Turn_format(const Turn *turn, char *buf);
+
 #endif // TURN_H
\ No newline at end of file
@@ -0,0 +1,260 @@
+#include <limits.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "analyze.h"
+#include "endgame.h"
+#include "position.h"
+
+#define RESULT_MAX ((TURN_FORMAT_MAX + 8) * TURN_MAX_TOP + 64)
+
+typedef enum {
+    SLOT_FREE,    // the reader may fill it
+    SLOT_READY,   // holds a line for a worker
+    SLOT_BUSY,    // a worker is searching it
+    SLOT_DONE,    // holds a result for the writer
+} SlotState;
+
+typedef struct SlotStruct {
+    SlotState state;
+    bool tooLong;
+    char line[POSITION_MAX];
+    char result[RESULT_MAX];
+} Slot;
+
+typedef struct PoolStruct {
+    FILE *in;
+    const AnalyzeOptions *options;
+    Slot *slots;
+    uint64_t read;    // lines read; line n is in slot n % window
+    uint64_t taken;   // lines handed to workers
+    bool eof;
+    pthread_mutex_t lock;
+    pthread_cond_t slotFree;
+    pthread_cond_t lineReady;
+    pthread_cond_t resultDone;
+} Pool;
+
+typedef struct WorkerStruct {
+    Pool *pool;
+    pthread_t thread;
+    Search search;
+    Game game;
+    Endgame endgame;
+    SearchStats stats;
+    uint64_t nodes;
+} Worker;
+
+void AnalyzeOptions_init(AnalyzeOptions *options) {
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    options->threads = cpus > 0 ? (int)cpus : 1;
+    options->window = 16 * options->threads;
+    SearchLimits_init(&options->limits);
+    options->book = NULL;
+    options->endgameStock = 0;
+    options->multiPV = 1;
+}
+
+static void analyze(Worker *worker, Slot *slot) {
+    int column;
+    if (slot->tooLong) {
+        snprintf(slot->result, RESULT_MAX, "error line too long at column %d", POSITION_MAX - 1);
+        return;
+    }
+    const char *error = Position_parse(&worker->game, slot->line, &column);
+    if (error) {
+        snprintf(slot->result, RESULT_MAX, "error %s at column %d", error, column);
+        return;
+    }
+    Search *search = &worker->search;
+    Search_start(search, &worker->game, &worker->pool->options->limits);
+    Search_run(search);
+    SearchStats_merge(&worker->stats, &search->stats);
+    worker->nodes += search->nodes;
+    if (search->best.eval == INT_MIN) {
+        snprintf(slot->result, RESULT_MAX, "bestmove none");
+        return;
+    }
+    char turn[TURN_FORMAT_MAX];
+    Turn_format(&search->best, turn);
+    int length = snprintf(slot->result, RESULT_MAX, "bestmove %s nodes %llu", turn,
+                          (unsigned long long)search->nodes);
+    if (search->multiPV > 1) {
+        Turn top[TURN_MAX_TOP];
+        int n = TopTurns_sorted(&search->top, &worker->game.discardPile, top);
+        for (int i = 1; i < n; ++i) {
+            Turn_format(&top[i], turn);
+            length += snprintf(slot->result + length, RESULT_MAX - length, " alt %s", turn);
+        }
+    }
+}
+
+static void *workerThread(void *arg) {
+    Worker *worker = arg;
+    Pool *pool = worker->pool;
+    int window = pool->options->window;
+    pthread_mutex_lock(&pool->lock);
+    while (true) {
+        while (pool->taken == pool->read && !pool->eof) {
+            pthread_cond_wait(&pool->lineReady, &pool->lock);
+        }
+        if (pool->taken == pool->read) {
+            break;
+        }
+        Slot *slot = &pool->slots[pool->taken++ % window];
+        slot->state = SLOT_BUSY;
+        pthread_mutex_unlock(&pool->lock);
+
+        analyze(worker, slot);
+
+        pthread_mutex_lock(&pool->lock);
+        slot->state = SLOT_DONE;
+        pthread_cond_signal(&pool->resultDone);
+    }
+    pthread_mutex_unlock(&pool->lock);
+    return NULL;
+}
+
+static void *readerThread(void *arg) {
+    Pool *pool = arg;
+    int window = pool->options->window;
+    char *line = NULL;
+    size_t capacity = 0;
+    ssize_t length;
+    while ((length = getline(&line, &capacity, pool->in)) >= 0) {
+        pthread_mutex_lock(&pool->lock);
+        Slot *slot = &pool->slots[pool->read % window];
+        while (slot->state != SLOT_FREE) {
+            pthread_cond_wait(&pool->slotFree, &pool->lock);
+        }
+        pthread_mutex_unlock(&pool->lock);
+
+        // No one else touches a free slot.
+        slot->tooLong = length >= POSITION_MAX;
+        if (!slot->tooLong) {
+            memcpy(slot->line, line, (size_t)length + 1);
+        }
+
+        pthread_mutex_lock(&pool->lock);
+        slot->state = SLOT_READY;
+        pool->read++;
+        pthread_cond_signal(&pool->lineReady);
+        pthread_mutex_unlock(&pool->lock);
+    }
+    free(line);
+    pthread_mutex_lock(&pool->lock);
+    pool->eof = true;
+    pthread_cond_broadcast(&pool->lineReady);
+    pthread_cond_signal(&pool->resultDone);
+    pthread_mutex_unlock(&pool->lock);
+    return NULL;
+}
+
+// The calling thread writes the results in order.
+static void writeResults(Pool *pool, FILE *out, AnalyzeTotals *totals) {
+    int window = pool->options->window;
+    for (uint64_t n = 0;; ++n) {
+        Slot *slot = &pool->slots[n % window];
+        pthread_mutex_lock(&pool->lock);
+        while (slot->state != SLOT_DONE && !(pool->eof && n == pool->read)) {
+            pthread_cond_wait(&pool->resultDone, &pool->lock);
+        }
+        bool done = slot->state == SLOT_DONE;
+        pthread_mutex_unlock(&pool->lock);
+        if (!done) {
+            break;
+        }
+
+        fputs(slot->result, out);
+        fputc('\n', out);
+        totals->positions++;
+        totals->errors += strncmp(slot->result, "error", 5) == 0;
+
+        pthread_mutex_lock(&pool->lock);
+        slot->state = SLOT_FREE;
+        pthread_cond_signal(&pool->slotFree);
+        pthread_mutex_unlock(&pool->lock);
+    }
+    fflush(out);
+}
+
+bool Analyze_run(FILE *in, FILE *out, const AnalyzeOptions *options, AnalyzeTotals *totals) {
+    AnalyzeOptions opts = *options;
+    if (opts.threads < 1) {
+        opts.threads = 1;
+    }
+    if (opts.window < opts.threads) {
+        opts.window = opts.threads;
+    }
+    memset(totals, 0, sizeof(*totals));
+    SearchStats_init(&totals->stats);
+
+    Pool pool = { .in = in, .options = &opts, .read = 0, .taken = 0, .eof = false };
+    pool.slots = calloc(opts.window, sizeof(Slot));
+    Worker *workers = calloc(opts.threads, sizeof(Worker));
+    if (!pool.slots || !workers) {
+        free(pool.slots);
+        free(workers);
+        return false;
+    }
+    pthread_mutex_init(&pool.lock, NULL);
+    pthread_cond_init(&pool.slotFree, NULL);
+    pthread_cond_init(&pool.lineReady, NULL);
+    pthread_cond_init(&pool.resultDone, NULL);
+
+    uint64_t start = Search_nowNs();
+    int started = 0;
+    bool ok = true;
+    for (; started < opts.threads; ++started) {
+        Worker *worker = &workers[started];
+        worker->pool = &pool;
+        Search_init(&worker->search);
+        worker->search.book = opts.book;
+        worker->search.multiPV = opts.multiPV;
+        SearchStats_init(&worker->stats);
+        if (opts.endgameStock > 0) {
+            if (!Endgame_init(&worker->endgame, opts.endgameStock, ENDGAME_DEFAULT_BITS)) {
+                Endgame_free(&worker->endgame);
+                ok = false;
+                break;
+            }
+            worker->search.endgame = &worker->endgame;
+        }
+        if (pthread_create(&worker->thread, NULL, workerThread, worker) != 0) {
+            ok = false;
+            break;
+        }
+    }
+    pthread_t reader;
+    if (ok && started > 0 && pthread_create(&reader, NULL, readerThread, &pool) == 0) {
+        writeResults(&pool, out, totals);
+        pthread_join(reader, NULL);
+    } else {
+        // Let the workers that did start see the end of an empty input.
+        ok = false;
+        pthread_mutex_lock(&pool.lock);
+        pool.eof = true;
+        pthread_cond_broadcast(&pool.lineReady);
+        pthread_mutex_unlock(&pool.lock);
+    }
+    for (int i = 0; i < started; ++i) {
+        pthread_join(workers[i].thread, NULL);
+        SearchStats_merge(&totals->stats, &workers[i].stats);
+        totals->nodes += workers[i].nodes;
+    }
+    for (int i = 0; i < opts.threads; ++i) {
+        if (workers[i].search.endgame) {
+            Endgame_free(&workers[i].endgame);
+        }
+    }
+    totals->elapsedNs = Search_nowNs() - start;
+
+    pthread_mutex_destroy(&pool.lock);
+    pthread_cond_destroy(&pool.slotFree);
+    pthread_cond_destroy(&pool.lineReady);
+    pthread_cond_destroy(&pool.resultDone);
+    free(pool.slots);
+    free(workers);
+    return ok;
+}
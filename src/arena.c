@@ -0,0 +1,59 @@
+#include <string.h>
+#include "arena.h"
+#include "pages.h"
+
+bool Arena_init(Arena *arena, size_t nodeSize, uint32_t capacity, bool hugePages) {
+    memset(arena, 0, sizeof(*arena));
+    if (nodeSize < sizeof(ArenaNode) || nodeSize % 4 != 0 || capacity < 2) {
+        return false;
+    }
+    arena->nodeSize = nodeSize;
+    arena->capacity = capacity;
+    arena->hugePages = hugePages;
+    size_t size = nodeSize * capacity;
+    if (hugePages) {
+        size = (size + PAGES_HUGE - 1) & ~(PAGES_HUGE - 1);
+    }
+    arena->mapSize = size;
+    arena->base = Pages_map(size, hugePages, &arena->hugeMapped);
+    Arena_reset(arena);
+    arena->peak = arena->used;
+    return arena->base != NULL;
+}
+
+void Arena_free(Arena *arena) {
+    Pages_unmap(arena->base, arena->mapSize);
+    Pages_unmap(arena->spare, arena->mapSize);
+    arena->base = NULL;
+    arena->spare = NULL;
+}
+
+// Cheney's copying walk: the nodes copied but not yet scanned form the
+// queue, so the copy is breadth first and needs no stack.
+ArenaIndex Arena_keep(Arena *arena, ArenaIndex root) {
+    if (!arena->spare) {
+        bool huge;
+        arena->spare = Pages_map(arena->mapSize, arena->hugePages, &huge);
+        if (!arena->spare) {
+            return ARENA_NULL;
+        }
+    }
+    size_t size = arena->nodeSize;
+    uint8_t *from = arena->base, *to = arena->spare;
+    memcpy(to + size, from + (size_t)root * size, size);
+    ArenaIndex next = 2;
+    for (ArenaIndex scan = 1; scan < next; ++scan) {
+        ArenaNode *node = (ArenaNode *)(to + (size_t)scan * size);
+        if (node->numChildren == 0) {
+            node->children = ARENA_NULL;
+            continue;
+        }
+        memcpy(to + (size_t)next * size, from + (size_t)node->children * size, (size_t)node->numChildren * size);
+        node->children = next;
+        next += node->numChildren;
+    }
+    arena->base = to;
+    arena->spare = from;
+    arena->used = next;
+    return 1;
+}
@@ -0,0 +1,311 @@
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+#include "batch.h"
+#include "kernels.h"
+#include "random.h"
+
+#define RANK_MASK 0x3FFFULL
+#define EVERY_SUIT 0x0001000100010001ULL
+#define TEN_POINT_MASK 0x3E003E003E003E00ULL
+
+static void *allocArray(int size, size_t elementSize) {
+    size_t bytes = ((size_t)size * elementSize + 63) & ~(size_t)63;
+    void *p = aligned_alloc(64, bytes ? bytes : 64);
+    if (p) {
+        memset(p, 0, bytes);
+    }
+    return p;
+}
+
+bool Batch_init(Batch *batch, int size) {
+    return Batch_initPlayers(batch, size, DEFAULT_PLAYERS);
+}
+
+bool Batch_initPlayers(Batch *batch, int size, int numPlayers) {
+    memset(batch, 0, sizeof(Batch));
+    batch->size = size;
+    batch->numPlayers = numPlayers;
+    bool ok = true;
+    for (int p = 0; p < numPlayers; ++p) {
+        ok &= (batch->hands[p] = allocArray(size, sizeof(Cards))) != NULL;
+        ok &= (batch->scores[p] = allocArray(size, sizeof(int32_t))) != NULL;
+    }
+    ok &= (batch->runs = allocArray(size, sizeof(Cards))) != NULL;
+    ok &= (batch->sets = allocArray(size, sizeof(Cards))) != NULL;
+    ok &= (batch->discardTop = allocArray(size, sizeof(Cards))) != NULL;
+    ok &= (batch->discardSize = allocArray(size, sizeof(int32_t))) != NULL;
+    ok &= (batch->discardPile = allocArray(size, 52)) != NULL;
+    ok &= (batch->deck = allocArray(size, 52)) != NULL;
+    ok &= (batch->drawn = allocArray(size, sizeof(int32_t))) != NULL;
+    ok &= (batch->current = allocArray(size, sizeof(int32_t))) != NULL;
+    ok &= (batch->turns = allocArray(size, sizeof(int32_t))) != NULL;
+    ok &= (batch->done = allocArray(size, 1)) != NULL;
+    ok &= (batch->hand = allocArray(size, sizeof(Cards))) != NULL;
+    ok &= (batch->melded = allocArray(size, sizeof(Cards))) != NULL;
+    ok &= (batch->points = allocArray(size, sizeof(int32_t))) != NULL;
+    ok &= (batch->ended = allocArray(size, sizeof(int32_t))) != NULL;
+    if (!ok) {
+        Batch_free(batch);
+    }
+    return ok;
+}
+
+void Batch_free(Batch *batch) {
+    for (int p = 0; p < batch->numPlayers; ++p) {
+        free(batch->hands[p]);
+        free(batch->scores[p]);
+    }
+    free(batch->runs);
+    free(batch->sets);
+    free(batch->discardTop);
+    free(batch->discardSize);
+    free(batch->discardPile);
+    free(batch->deck);
+    free(batch->drawn);
+    free(batch->current);
+    free(batch->turns);
+    free(batch->done);
+    free(batch->hand);
+    free(batch->melded);
+    free(batch->points);
+    free(batch->ended);
+    memset(batch, 0, sizeof(Batch));
+}
+
+static void startGame(Batch *batch, int i) {
+    for (int p = 0; p < batch->numPlayers; ++p) {
+        batch->hands[p][i] = 0;
+        batch->scores[p][i] = 0;
+    }
+    batch->runs[i] = 0;
+    batch->sets[i] = 0;
+    batch->discardTop[i] = 0;
+    batch->discardSize[i] = 0;
+    batch->drawn[i] = 0;
+    batch->current[i] = 0;
+    batch->turns[i] = 0;
+    batch->done[i] = 0;
+    batch->ended[i] = 0;
+}
+
+// Deals a fresh shuffled game into every slot.  Game i is shuffled with a
+// generator seeded from seed and i, so any game can be dealt again alone.
+void Batch_deal(Batch *batch, uint64_t seed) {
+    for (int i = 0; i < batch->size; ++i) {
+        uint8_t *deck = &batch->deck[i * 52];
+        int n = 0;
+        for (Cards c = Cards_low(FULL_DECK); c != 0; c = Cards_next(FULL_DECK, c)) {
+            deck[n++] = Cards_toCard(c);
+        }
+        Random random;
+        Random_seed(&random, seed ^ ((uint64_t)i * 0xD1B54A32D192ED03ULL));
+        for (int j = 51; j > 0; --j) {
+            int k = Random_uniform(&random, j + 1);
+            uint8_t t = deck[j];
+            deck[j] = deck[k];
+            deck[k] = t;
+        }
+
+        startGame(batch, i);
+        for (int p = 0; p < batch->numPlayers; ++p) {
+            for (int j = 0; j < 7; ++j) {
+                batch->hands[p][i] |= 1ULL << deck[batch->drawn[i]++];
+            }
+        }
+        uint8_t up = deck[batch->drawn[i]++];
+        batch->discardPile[i * 52] = up;
+        batch->discardSize[i] = 1;
+        batch->discardTop[i] = 1ULL << up;
+    }
+}
+
+// Copies a position into slot i.  The stock is drawn in the order the
+// game's draw pile would be.
+void Batch_setGame(Batch *batch, int i, Game *game) {
+    assert(game->numPlayers == batch->numPlayers);
+    startGame(batch, i);
+    for (int p = 0; p < batch->numPlayers; ++p) {
+        batch->hands[p][i] = game->players[p].hand;
+        batch->scores[p][i] = game->players[p].score;
+    }
+    batch->runs[i] = game->table.runs;
+    batch->sets[i] = game->table.sets;
+
+    int stock = Pile_size(&game->drawPile);
+    batch->drawn[i] = 52 - stock;
+    for (int j = 0; j < stock; ++j) {
+        batch->deck[i * 52 + 52 - stock + j] = Cards_toCard(game->drawPile.cards[stock - 1 - j]);
+    }
+    int discards = Pile_size(&game->discardPile);
+    for (int j = 0; j < discards; ++j) {
+        batch->discardPile[i * 52 + j] = Cards_toCard(game->discardPile.cards[j]);
+    }
+    batch->discardSize[i] = discards;
+    batch->discardTop[i] = discards ? game->discardPile.cards[discards - 1] : 0;
+    batch->current[i] = game->currentPlayer;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//    Rollout policy kernels
+//
+
+// The cards of hand that the rollout policy melds against the given table,
+// and the table that results.
+static inline Cards policyMeld(Cards hand, Cards *runs, Cards *sets) {
+    // Every run of three or more cards.
+    Cards centers = Cards_runCenters(hand);
+    Cards run = centers | (centers << 1) | (centers >> 1);
+
+    // Every rank held in three or more suits, among the cards left.
+    Cards rest = hand & ~run;
+    Cards a = rest & RANK_MASK, b = (rest >> 16) & RANK_MASK;
+    Cards c = (rest >> 32) & RANK_MASK, d = (rest >> 48) & RANK_MASK;
+    Cards ranks = (a & b & (c | d)) | (c & d & (a | b));
+    Cards set = rest & (ranks * EVERY_SUIT);
+
+    // Lay off what the table (now including the new melds) accepts.  Three
+    // rounds extend a run by up to three cards at each end.
+    Cards allRuns = *runs | run;
+    Cards allSets = *sets | set;
+    Cards left = rest & ~set;
+    for (int i = 0; i < 3; ++i) {
+        Cards extension = ((allRuns << 1) | (allRuns >> 1)) & left;
+        allRuns |= extension;
+        left &= ~extension;
+    }
+    Cards setRanks = (allSets | (allSets >> 16) | (allSets >> 32) | (allSets >> 48)) & RANK_MASK;
+    Cards setExtension = left & (setRanks * EVERY_SUIT);
+    allSets |= setExtension;
+    left &= ~setExtension;
+
+    *runs = allRuns;
+    *sets = allSets;
+    return hand & ~left;
+}
+
+static inline Cards selectPlayer(Batch *batch, int i, int32_t current) {
+    Cards hand = 0;
+    for (int p = 0; p < batch->numPlayers; ++p) {
+        hand |= batch->hands[p][i] & -(Cards)(current == p);
+    }
+    return hand;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//    Phases
+//
+
+// Take the top discard if the policy would meld it, else draw.  A game
+// whose stock is empty when it must draw is over.
+void Batch_phaseDraw(Batch *batch) {
+    for (int i = 0; i < batch->size; ++i) {
+        Cards hand = selectPlayer(batch, i, batch->current[i]);
+        Cards top = batch->discardTop[i];
+        Cards runs = batch->runs[i], sets = batch->sets[i];
+        bool take = top != 0 && (policyMeld(hand | top, &runs, &sets) & top) != 0;
+        bool active = !batch->done[i];
+
+        if (active && take) {
+            int size = --batch->discardSize[i];
+            batch->discardTop[i] = size ? 1ULL << batch->discardPile[i * 52 + size - 1] : 0;
+            hand |= top;
+        } else if (active && batch->drawn[i] < 52) {
+            hand |= 1ULL << batch->deck[i * 52 + batch->drawn[i]++];
+        } else if (active) {
+            batch->ended[i] = -1;
+        }
+        batch->hand[i] = hand;
+    }
+}
+
+void Batch_phaseMeld(Batch *batch) {
+    int n = batch->size;
+    for (int i = 0; i < n; ++i) {
+        Cards active = -(Cards)(batch->done[i] == 0 && batch->ended[i] == 0);
+        Cards runs = batch->runs[i], sets = batch->sets[i];
+        Cards melded = policyMeld(batch->hand[i], &runs, &sets) & active;
+        batch->runs[i] = (runs & active) | (batch->runs[i] & ~active);
+        batch->sets[i] = (sets & active) | (batch->sets[i] & ~active);
+        batch->hand[i] &= ~melded;
+        batch->melded[i] = melded;
+    }
+
+    Cards_pointsArray(batch->melded, batch->points, n);
+    for (int p = 0; p < batch->numPlayers; ++p) {
+        int32_t *scores = batch->scores[p];
+        for (int i = 0; i < n; ++i) {
+            scores[i] += batch->points[i] & -(int32_t)(batch->current[i] == p);
+        }
+    }
+}
+
+void Batch_phaseDiscard(Batch *batch) {
+    for (int i = 0; i < batch->size; ++i) {
+        Cards hand = batch->hand[i];
+        Cards high = hand & TEN_POINT_MASK;
+        Cards pick = high ? high : hand;
+        if (pick == 0 || batch->done[i] || batch->ended[i]) {
+            continue;
+        }
+        Card card = 63 - __builtin_clzll(pick);
+        batch->hand[i] = hand & ~(1ULL << card);
+        batch->discardPile[i * 52 + batch->discardSize[i]++] = card;
+        batch->discardTop[i] = 1ULL << card;
+    }
+}
+
+// Stores the hand back, ends games in which the player went out or could
+// not draw, passes the turn on, and scores the games that just ended.
+// Returns the number of games still running.
+int Batch_phaseEnd(Batch *batch) {
+    int n = batch->size;
+    int running = 0;
+    for (int i = 0; i < n; ++i) {
+        int32_t current = batch->current[i];
+        for (int p = 0; p < batch->numPlayers; ++p) {
+            Cards mine = -(Cards)(current == p);
+            batch->hands[p][i] = (batch->hand[i] & mine) | (batch->hands[p][i] & ~mine);
+        }
+        if (!batch->done[i]) {
+            batch->turns[i]++;
+            batch->current[i] = (current + 1) % batch->numPlayers;
+            batch->ended[i] |= -(int32_t)(batch->hand[i] == 0);
+        }
+        running += !batch->done[i] && !batch->ended[i];
+    }
+
+    for (int p = 0; p < batch->numPlayers; ++p) {
+        Cards_pointsArray(batch->hands[p], batch->points, n);
+        int32_t *scores = batch->scores[p];
+        for (int i = 0; i < n; ++i) {
+            scores[i] -= batch->points[i] & batch->ended[i];
+        }
+    }
+    for (int i = 0; i < n; ++i) {
+        batch->done[i] |= batch->ended[i] != 0;
+        batch->ended[i] = 0;
+    }
+    return running;
+}
+
+int Batch_step(Batch *batch) {
+    Batch_phaseDraw(batch);
+    Batch_phaseMeld(batch);
+    Batch_phaseDiscard(batch);
+    return Batch_phaseEnd(batch);
+}
+
+// Steps until every game is over or maxTurns rounds have been played.
+// Returns the number of turns played, over all games.
+int64_t Batch_run(Batch *batch, int maxTurns) {
+    for (int t = 0; t < maxTurns && Batch_step(batch) > 0; ++t) {
+    }
+    int64_t turns = 0;
+    for (int i = 0; i < batch->size; ++i) {
+        turns += batch->turns[i];
+    }
+    return turns;
+}
@@ -0,0 +1,265 @@
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "book.h"
+
+static const char kMagic[8] = {'R', 'U', 'M', 'B', 'O', 'T', 'B', 'K'};
+
+#define PACKED_DECK ((1ULL << 52) - 1)
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//    Keys
+//
+
+// The next larger packed hand with as many cards.
+static uint64_t nextHand(uint64_t hand) {
+    uint64_t low = hand & -hand;
+    uint64_t ripple = hand + low;
+    return (((ripple ^ hand) >> 2) / low) | ripple;
+}
+
+// Canonical hands have their suit fields in decreasing order; a quick
+// test before the full one.
+static bool suitsDecrease(uint64_t hand) {
+    unsigned last = (unsigned)(hand & 0x1FFF);
+    for (int suit = 1; suit < NUM_SUITS; ++suit) {
+        unsigned field = (unsigned)(hand >> (13 * suit)) & 0x1FFF;
+        if (field > last) {
+            return false;
+        }
+        last = field;
+    }
+    return true;
+}
+
+static bool isIdentity(const uint8_t perm[NUM_SUITS]) {
+    for (int suit = 0; suit < NUM_SUITS; ++suit) {
+        if (perm[suit] != suit) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void BookCursor_init(BookCursor *cursor) {
+    cursor->hand = (1ULL << BOOK_HAND) - 1;
+    cursor->up = 0;
+}
+
+// A pair is canonical when the renaming that finds its canonical form
+// leaves it as it is.
+bool BookCursor_next(BookCursor *cursor, uint64_t *key) {
+    for (; cursor->hand <= PACKED_DECK; cursor->hand = nextHand(cursor->hand), cursor->up = 0) {
+        if (!suitsDecrease(cursor->hand)) {
+            continue;
+        }
+        Cards hand = Cards_unpack(cursor->hand);
+        while (cursor->up < 52) {
+            int up = cursor->up++;
+            if ((cursor->hand >> up) & 1) {
+                continue;
+            }
+            Cards pair[2] = { hand, Cards_unpack(1ULL << up) };
+            uint8_t perm[NUM_SUITS];
+            Cards_canonicalSuits(pair, 2, perm);
+            if (isIdentity(perm)) {
+                *key = cursor->hand << 6 | (uint64_t)up;
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+bool Book_key(Game *game, uint64_t *key, uint8_t perm[NUM_SUITS]) {
+    if (Pile_size(&game->discardPile) != 1 || game->table.runs != 0 || game->table.sets != 0 ||
+        Pile_size(&game->drawPile) != 52 - BOOK_HAND * game->numPlayers - 1) {
+        return false;
+    }
+    for (int p = 0; p < game->numPlayers; ++p) {
+        Player *player = &game->players[p];
+        if (Cards_size(player->hand) != BOOK_HAND || player->known != 0 || player->score != 0) {
+            return false;
+        }
+    }
+    Cards pair[2] = { Game_currentPlayer(game)->hand, game->discardPile.cards[0] };
+    Cards_canonicalSuits(pair, 2, perm);
+    uint64_t hand = Cards_pack(Cards_permuteSuits(pair[0], perm));
+    uint64_t up = Cards_pack(Cards_permuteSuits(pair[1], perm));
+    *key = hand << 6 | (uint64_t)__builtin_ctzll(up);
+    return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//    Entries
+//
+
+static inline int indexOf(Cards cards, Cards card) {
+    return Cards_size(cards & (card - 1));
+}
+
+static uint8_t toMask(Cards cards, Cards subset) {
+    unsigned mask = 0;
+    for (Cards card = Cards_low(subset); card != 0; card = Cards_next(subset, card)) {
+        mask |= 1u << indexOf(cards, card);
+    }
+    return (uint8_t)mask;
+}
+
+static Cards fromMask(Cards cards, unsigned mask) {
+    Cards subset = 0;
+    for (int i = 0; cards != 0; ++i, cards &= cards - 1) {
+        if (mask & (1u << i)) {
+            subset |= Cards_low(cards);
+        }
+    }
+    return subset;
+}
+
+void Book_solve(Search *search, Game *game, int numPlayers, uint64_t key, BookEntry *entry) {
+    Cards hand = Cards_unpack(key >> 6);
+    Cards up = Cards_unpack(1ULL << (key & 63));
+    Game_clearPlayers(game, numPlayers);
+    game->players[0].hand = hand;
+    Pile_push(&game->discardPile, up);
+    Cards rest = Cards_unpack(PACKED_DECK) & ~hand & ~up;
+    for (int p = 1; p < numPlayers; ++p) {
+        for (int i = 0; i < BOOK_HAND; ++i) {
+            Cards card = Cards_low(rest);
+            game->players[p].hand |= card;
+            rest &= ~card;
+        }
+    }
+    for (Cards card = Cards_low(rest); card != 0; card = Cards_next(rest, card)) {
+        Pile_push(&game->drawPile, card);
+    }
+
+    SearchLimits limits;
+    SearchLimits_init(&limits);
+    const Book *book = search->book;
+    search->book = NULL;
+    Search_start(search, game, &limits);
+    Search_run(search);
+    search->book = book;
+
+    Turn *best = &search->best;
+    Cards cards = hand | up;
+    entry->key = key;
+    entry->runs = toMask(cards, Cards_toHighAces(best->meld.runs));
+    entry->sets = toMask(cards, best->meld.sets);
+    entry->discard = best->discard != 0 ? (uint8_t)indexOf(cards, best->discard) : BOOK_NO_CARD;
+    entry->flags = (uint8_t)((best->taken.size > 0 ? BOOK_TAKE : 0) |
+                             Cards_valueSuits(best->meld.runs, 0) << 4);
+    entry->eval = best->eval;
+}
+
+void BookHeader_init(BookHeader *header, int numPlayers, uint64_t count) {
+    memset(header, 0, sizeof(*header));
+    memcpy(header->magic, kMagic, sizeof(kMagic));
+    header->version = BOOK_VERSION;
+    header->entrySize = sizeof(BookEntry);
+    header->numPlayers = (uint16_t)numPlayers;
+    header->count = count;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//    Lookup
+//
+
+const char *Book_open(Book *book, const char *path) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return "cannot open file";
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < (off_t)sizeof(BookHeader)) {
+        close(fd);
+        return "not a book file";
+    }
+    void *map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        return "cannot map file";
+    }
+    const BookHeader *header = map;
+    size_t entries = ((size_t)st.st_size - sizeof(BookHeader)) / sizeof(BookEntry);
+    const char *error = NULL;
+    if (memcmp(header->magic, kMagic, sizeof(kMagic)) != 0) {
+        error = "not a book file";
+    } else if (header->version != BOOK_VERSION || header->entrySize != sizeof(BookEntry)) {
+        error = "unsupported book version";
+    } else if (header->count > entries) {
+        error = "book file cut short";
+    }
+    if (error) {
+        munmap(map, (size_t)st.st_size);
+        return error;
+    }
+    // Lookups touch a handful of pages each, far apart.
+    madvise(map, (size_t)st.st_size, MADV_RANDOM);
+
+    book->map = map;
+    book->mapSize = (size_t)st.st_size;
+    book->numPlayers = header->numPlayers;
+    book->entries = (const BookEntry *)(header + 1);
+    book->count = header->count;
+    return NULL;
+}
+
+void Book_close(Book *book) {
+    munmap(book->map, book->mapSize);
+    book->map = NULL;
+    book->entries = NULL;
+    book->count = 0;
+}
+
+static const BookEntry *find(const Book *book, uint64_t key) {
+    uint64_t low = 0, high = book->count;
+    while (low < high) {
+        uint64_t middle = low + (high - low) / 2;
+        if (book->entries[middle].key < key) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return low < book->count && book->entries[low].key == key ? &book->entries[low] : NULL;
+}
+
+bool Book_probe(const Book *book, Game *game, Turn *turn) {
+    uint64_t key;
+    uint8_t perm[NUM_SUITS], inverse[NUM_SUITS];
+    if (game->numPlayers != book->numPlayers || !Book_key(game, &key, perm)) {
+        return false;
+    }
+    const BookEntry *entry = find(book, key);
+    if (!entry) {
+        return false;
+    }
+
+    // The entry is for the canonical suits; rename them back.
+    for (int suit = 0; suit < NUM_SUITS; ++suit) {
+        inverse[perm[suit]] = (uint8_t)suit;
+    }
+    Cards cards = Cards_unpack(key >> 6) | Cards_unpack(1ULL << (key & 63));
+    unsigned lowAces = entry->flags >> 4;
+    Cards runs = fromMask(cards, entry->runs);
+    runs = (runs & ~Cards_fromValueSuits(lowAces, 13)) | Cards_fromValueSuits(lowAces, 0);
+
+    Turn_init(turn);
+    if (entry->flags & BOOK_TAKE) {
+        Pile_push(&turn->taken, game->discardPile.cards[0]);
+    }
+    turn->meld.runs = Cards_permuteSuits(runs, inverse);
+    turn->meld.sets = Cards_permuteSuits(fromMask(cards, entry->sets), inverse);
+    if (entry->discard != BOOK_NO_CARD) {
+        turn->discard = Cards_permuteSuits(fromMask(cards, 1u << entry->discard), inverse);
+    }
+    turn->eval = entry->eval;
+    return true;
+}
@@ -1,4 +1,3 @@
-#include <assert.h>
 #include <stdbool.h>
 #include <stdint.h>
 #include <stdio.h>
@@ -20,33 +19,71 @@ const char *Card_name(Card i) {
     }
 }
 
-Cards Cards_fromString(const char *str) {
-    const char *values = "a23456789TJQKA";
-    const char *suits = "CDHS";
-    Cards cards = 0;
+#define BAD CARD_BAD
+#define BAD16 BAD, BAD, BAD, BAD, BAD, BAD, BAD, BAD, BAD, BAD, BAD, BAD, BAD, BAD, BAD, BAD
+#define BAD64 BAD16, BAD16, BAD16, BAD16
 
-    if (!*str) {
-        return cards;
-    }
+const uint8_t kCardValue[256] = {
+    BAD16, BAD16, BAD16,
+    // '0' to '?'
+    BAD, BAD, 1, 2, 3, 4, 5, 6, 7, 8, BAD, BAD, BAD, BAD, BAD, BAD,
+    // '@' to 'O'
+    BAD, 13, BAD, BAD, BAD, BAD, BAD, BAD, BAD, BAD, 10, 12, BAD, BAD, BAD, BAD,
+    // 'P' to '_'
+    BAD, 11, BAD, BAD, 9, BAD, BAD, BAD, BAD, BAD, BAD, BAD, BAD, BAD, BAD, BAD,
+    // '`' to 'o'
+    BAD, 0, BAD, BAD, BAD, BAD, BAD, BAD, BAD, BAD, BAD, BAD, BAD, BAD, BAD, BAD,
+    BAD16, BAD64, BAD64,
+};
 
-    while (true) {
-        assert(*str);
-        assert(strchr(values, *str));
-        assert(*(str+1));
-        assert(strchr(suits, *(str + 1)));
+const uint8_t kCardSuit[256] = {
+    BAD64,
+    // '@' to 'O'
+    BAD, BAD, BAD, 0x00, 0x10, BAD, BAD, BAD, 0x20, BAD, BAD, BAD, BAD, BAD, BAD, BAD,
+    // 'P' to '_'
+    BAD, BAD, BAD, 0x30, BAD, BAD, BAD, BAD, BAD, BAD, BAD, BAD, BAD, BAD, BAD, BAD,
+    BAD16, BAD16, BAD64, BAD64,
+};
 
-        int value = strchr(values, *(str++)) - values;
-        int suit = strchr(suits, *(str++)) - suits;
+bool Cards_parse(const char *str, Cards *cards) {
+    unsigned bad = 0;
+    Cards seen = 0, repeated = 0;
+    if (*str == '\0') {
+        *cards = 0;
+        return true;
+    }
+    for (;; str += 3) {
+        if (str[0] == '\0' || str[1] == '\0') {
+            return false;
+        }
+        unsigned card = Card_parse(str[0], str[1]);
+        bad |= card;
+        Cards bit = 1ULL << (card & 63);
+        repeated |= seen & bit;
+        seen |= bit;
+        if (str[2] != ' ') {
+            break;
+        }
+    }
+    *cards = seen;
+    return str[2] == '\0' && !(bad & CARD_BAD) && repeated == 0;
+}
 
-        cards |= (1ULL << (value + (suit << 4)));
+Cards Cards_fromString(const char *str) {
+    Cards cards;
+    return Cards_parse(str, &cards) ? cards : 0;
+}
 
-        if (!*str) {
-            return cards;
-        } else {
-            assert(*str == ' ');
-            str++;
-        }
+char *Cards_write(Cards cards, char *out) {
+    if (cards == 0) {
+        *out++ = '-';
+    }
+    for (Cards c = Cards_low(cards); c != 0; c = Cards_next(cards, c)) {
+        const char *name = kCardName[Cards_toCard(c)];
+        *out++ = name[0];
+        *out++ = name[1];
     }
+    return out;
 }
 
 void Cards_print(Cards cards) {
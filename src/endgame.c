@@ -0,0 +1,170 @@
+#include <stdlib.h>
+#include <string.h>
+#include "endgame.h"
+#include "search.h"
+
+#define INFINITE 30000
+
+bool Endgame_init(Endgame *endgame, int maxStock, int bits) {
+    endgame->maxStock = maxStock;
+    endgame->maxNodes = 0;
+    endgame->deadline = 0;
+    endgame->stop = NULL;
+    endgame->bits = bits;
+    endgame->table = calloc((size_t)1 << bits, sizeof(EndgameEntry));
+    for (int i = 0; i < ENDGAME_MAX_DEPTH; ++i) {
+        PlanList_init(&endgame->lists[i]);
+    }
+    endgame->nodes = 0;
+    endgame->probes = 0;
+    endgame->hits = 0;
+    endgame->cutoffs = 0;
+    endgame->aborted = false;
+    return endgame->table != NULL;
+}
+
+void Endgame_free(Endgame *endgame) {
+    free(endgame->table);
+    endgame->table = NULL;
+    for (int i = 0; i < ENDGAME_MAX_DEPTH; ++i) {
+        PlanList_free(&endgame->lists[i]);
+    }
+}
+
+void Endgame_clear(Endgame *endgame) {
+    memset(endgame->table, 0, sizeof(EndgameEntry) << endgame->bits);
+}
+
+bool Endgame_applies(const Endgame *endgame, Game *game) {
+    int stock = Pile_size(&game->drawPile);
+    return stock > 0 && stock <= endgame->maxStock;
+}
+
+static bool outOfTime(Endgame *endgame, Game *game, int depth) {
+    if ((endgame->maxNodes != 0 && endgame->nodes > endgame->maxNodes) ||
+        depth == ENDGAME_MAX_DEPTH || Plan_journalFull(game)) {
+        return true;
+    }
+    if ((endgame->nodes & 1023) == 0) {
+        return (endgame->stop && atomic_load_explicit(endgame->stop, memory_order_relaxed)) ||
+               (endgame->deadline != 0 && Search_nowNs() >= endgame->deadline);
+    }
+    return false;
+}
+
+// Fail-soft alpha-beta for the root player's gain.  The root player
+// maximizes it and the others minimize it.
+static int solve(Endgame *endgame, Game *game, int depth, int alpha, int beta, int root, int *move) {
+    Player *rootPlayer = &game->players[root];
+    endgame->nodes++;
+    if (outOfTime(endgame, game, depth)) {
+        endgame->aborted = true;
+        return 0;
+    }
+    if (Pile_size(&game->drawPile) == 0) {
+        return -Cards_points(rootPlayer->hand);
+    }
+
+    uint64_t key = Plan_positionKey(game, (uint64_t)root);
+    EndgameEntry *entry = &endgame->table[key & ((1ULL << endgame->bits) - 1)];
+    int hint = -1;
+    endgame->probes++;
+    if (entry->key == key) {
+        endgame->hits++;
+        hint = entry->move;
+        if (entry->bound == BOUND_EXACT ||
+            (entry->bound == BOUND_LOWER && entry->value >= beta) ||
+            (entry->bound == BOUND_UPPER && entry->value <= alpha)) {
+            *move = hint;
+            return entry->value;
+        }
+    }
+
+    PlanList *list = &endgame->lists[depth];
+    if (!PlanList_generate(list, game)) {
+        endgame->aborted = true;
+        return 0;
+    }
+    if (list->size == 0) {
+        return -Cards_points(rootPlayer->hand);
+    }
+    PlanList_sort(list);
+    if (hint >= list->size) {
+        hint = -1;
+    }
+
+    int mover = game->currentPlayer;
+    bool maximizing = mover == root;
+    int best = maximizing ? -INFINITE : INFINITE;
+    int bestMove = 0;
+    int a = alpha, b = beta;
+    int mark = Game_mark(game);
+    for (int n = hint >= 0 ? -1 : 0; n < list->size; ++n) {
+        int i = n < 0 ? hint : n;
+        if (n >= 0 && i == hint) {
+            continue;
+        }
+        const Plan *plan = &list->plans[i];
+        int gain = maximizing ? plan->points : 0;
+        int value, childMove;
+        Plan_make(game, plan);
+        if (game->players[mover].hand == 0) {
+            value = -Cards_points(rootPlayer->hand);
+        } else {
+            value = solve(endgame, game, depth + 1, a - gain, b - gain, root, &childMove);
+        }
+        value += gain;
+        Game_unmakeTo(game, mark);
+        if (endgame->aborted) {
+            return 0;
+        }
+
+        if (maximizing ? value > best : value < best) {
+            best = value;
+            bestMove = i;
+        }
+        if (maximizing && best > a) {
+            a = best;
+        } else if (!maximizing && best < b) {
+            b = best;
+        }
+        if (a >= b) {
+            endgame->cutoffs++;
+            break;
+        }
+    }
+
+    entry->key = key;
+    entry->value = (int16_t)best;
+    entry->bound = best <= alpha ? BOUND_UPPER : best >= beta ? BOUND_LOWER : BOUND_EXACT;
+    entry->move = (uint16_t)bestMove;
+    *move = bestMove;
+    return best;
+}
+
+bool Endgame_solve(Endgame *endgame, Game *game, int *gain, Turn *turn) {
+    endgame->nodes = 0;
+    endgame->probes = 0;
+    endgame->hits = 0;
+    endgame->cutoffs = 0;
+    endgame->aborted = false;
+
+    int move = 0;
+    int value = solve(endgame, game, 0, -INFINITE, INFINITE, game->currentPlayer, &move);
+    if (endgame->aborted || Pile_size(&game->drawPile) == 0) {
+        return false;
+    }
+    // A hit at the root leaves the list as it was at an earlier solve.
+    PlanList *list = &endgame->lists[0];
+    if (!PlanList_generate(list, game) || list->size == 0) {
+        return false;
+    }
+    PlanList_sort(list);
+    if (move >= list->size) {
+        return false;
+    }
+    Plan_toTurn(&list->plans[move], game, turn);
+    turn->eval = Game_currentPlayer(game)->score + value;
+    *gain = value;
+    return true;
+}
@@ -0,0 +1,106 @@
+#include <stddef.h>
+#include "eval.h"
+#include "play.h"
+#include "potential.h"
+
+static int goingOut(Game *game, Player *player) {
+    int pointsFromRivals = 0;
+    for (int p = 0; p < game->numPlayers; ++p) {
+        if (p != player->id) {
+            pointsFromRivals += Cards_size(game->players[p].hand);
+        }
+    }
+    pointsFromRivals *= 7;
+    return pointsFromRivals / (game->numPlayers - 1);
+}
+
+Cards Eval_danger(Game *game) {
+    Player *next = &game->players[(game->currentPlayer + 1) % game->numPlayers];
+    Cards pool = (next->known & next->hand) | game->discarded;
+    return Play_danger(pool, game->table.runs, game->table.sets);
+}
+
+// Cards no one can meld from: on the table, under the top of the discard
+// pile, or known to be held by a rival.
+static Cards deadCards(Game *game, Player *player, Cards buried) {
+    Cards dead = Cards_toHighAces(game->table.runs) | game->table.sets | buried;
+    for (int p = 0; p < game->numPlayers; ++p) {
+        if (p != player->id) {
+            dead |= game->players[p].known & game->players[p].hand;
+        }
+    }
+    return dead;
+}
+
+int Eval_evaluate(Game *game) {
+    Player *player = Game_currentPlayer(game);
+    int pointsInHand = Cards_points(player->hand);
+    int pointsFromRivals = player->hand == 0 ? goingOut(game, player) : 0;
+    int danger = 0;
+    if (player->hand != 0 && (player->turn.discard & Eval_danger(game)) != 0) {
+        danger = Cards_points(player->turn.discard);
+    }
+    int size = Pile_size(&game->discardPile);
+    Cards buried = game->discarded & ~(size > 0 ? game->discardPile.cards[size - 1] : 0);
+    int outs = Potential_outs(player->hand, deadCards(game, player, buried));
+    return player->score + pointsInHand / 2 + EVAL_POINTS_PER_OUT * outs + pointsFromRivals - danger;
+}
+
+// Each discard is scored from the hand's meld potential before the discard,
+// corrected for the one suit and the one value that lose the card, so the
+// tables are read a few times per card and the game is never changed.  The
+// whole discard pile counts as buried: the discard goes on top of it.
+int Eval_discards(Game *game, Discard *top, int k) {
+    Player *player = Game_currentPlayer(game);
+    Cards hand = player->hand;
+    int pointsInHand = Cards_points(hand);
+    int pointsFromRivals = Cards_size(hand) == 1 ? goingOut(game, player) : 0;
+    Cards danger = Cards_size(hand) > 1 ? Eval_danger(game) : 0;
+
+    Cards dead = deadCards(game, player, game->discarded);
+    uint64_t handByValue = Cards_transpose(hand), deadByValue = Cards_transpose(dead);
+    int suitOuts[NUM_SUITS], outs = Potential_sets(handByValue, deadByValue);
+    for (int suit = 0; suit < NUM_SUITS; ++suit) {
+        suitOuts[suit] = __builtin_popcount(Potential_suitRuns(hand, dead, suit));
+        outs += suitOuts[suit];
+    }
+
+    int written = 0;
+    for (Cards c = Cards_low(hand); c != 0; c = Cards_next(hand, c)) {
+        Card card = Cards_toCard(c);
+        int suit = card >> 4, value = card & 15;
+        int left = outs - suitOuts[suit] + __builtin_popcount(Potential_suitRuns(hand & ~c, dead, suit)) -
+                   Potential_valueSets(handByValue, deadByValue, value) +
+                   Potential_valueSets(handByValue & ~(1ULL << (4 * value + suit)), deadByValue, value);
+        int points = Cards_points(c);
+        int eval = player->score + (pointsInHand - points) / 2 + EVAL_POINTS_PER_OUT * left +
+                   pointsFromRivals - ((c & danger) ? points : 0);
+
+        // Insert into the sorted top k; equal evaluations keep card order.
+        int i = written < k ? written++ : k;
+        for (; i > 0 && top[i - 1].eval < eval; --i) {
+            if (i < k) {
+                top[i] = top[i - 1];
+            }
+        }
+        if (i < k) {
+            top[i].card = c;
+            top[i].eval = eval;
+        }
+    }
+    return written;
+}
+
+static int handTunedEvaluate(const Evaluator *evaluator, Game *game) {
+    (void)evaluator;
+    return Eval_evaluate(game);
+}
+
+static int handTunedDiscards(const Evaluator *evaluator, Game *game, Discard *top, int k) {
+    (void)evaluator;
+    return Eval_discards(game, top, k);
+}
+
+const Evaluator Eval_handTuned = {
+    "handtuned", handTunedEvaluate, handTunedDiscards, NULL
+};
@@ -0,0 +1,53 @@
+#include <pthread.h>
+#include <stdlib.h>
+#include "evalcache.h"
+
+atomic_int EvalCache_runBits = EVALCACHE_DEFAULT_BITS;
+atomic_uint EvalCache_runVersion = 0;
+_Thread_local EvalCache *EvalCache_table = NULL;
+
+static pthread_key_t tableKey;
+static pthread_once_t tableKeyOnce = PTHREAD_ONCE_INIT;
+
+static void freeTable(void *table) {
+    free(table);
+}
+
+static void createTableKey(void) {
+    pthread_key_create(&tableKey, freeTable);
+}
+
+// The table is freed when the thread exits.  Empty slots have the hand 0,
+// which no probe asks for.
+EvalCache *EvalCache_newTable(void) {
+    pthread_once(&tableKeyOnce, createTableKey);
+    free(EvalCache_table);
+    EvalCache_table = NULL;
+    pthread_setspecific(tableKey, NULL);
+
+    int bits = EvalCache_bits();
+    if (bits <= 0) {
+        return NULL;
+    }
+    EvalCache *table = calloc(1, sizeof(EvalCache) + (sizeof(EvalCacheEntry) << bits));
+    if (!table) {
+        return NULL;
+    }
+    table->bits = bits;
+    pthread_setspecific(tableKey, table);
+    EvalCache_table = table;
+    return table;
+}
+
+void EvalCache_setBits(int bits) {
+    if (bits < 0) {
+        bits = 0;
+    } else if (bits > EVALCACHE_MAX_BITS) {
+        bits = EVALCACHE_MAX_BITS;
+    }
+    atomic_store_explicit(&EvalCache_runBits, bits, memory_order_relaxed);
+}
+
+void EvalCache_invalidate(void) {
+    atomic_fetch_add_explicit(&EvalCache_runVersion, 1, memory_order_relaxed);
+}
@@ -2,21 +2,59 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include "game.h"
+#include "random.h"
 
-void Game_init(Game *game) {
-    game->numPlayers = NUM_PLAYERS;
+void Game_clear(Game *game) {
+    Game_clearPlayers(game, DEFAULT_PLAYERS);
+}
+
+void Game_clearPlayers(Game *game, int numPlayers) {
+    assert(numPlayers >= MIN_PLAYERS && numPlayers <= MAX_PLAYERS);
+    game->numPlayers = numPlayers;
     game->currentPlayer = 0;
     for (int i = 0; i < game->numPlayers; ++i) {
         Player_init(&game->players[i], game, i);
     }
-    Pile_fullDeck(&game->drawPile);
+    Pile_init(&game->drawPile);
     Pile_init(&game->discardPile);
     Table_init(&game->table);
     game->discarded = 0;
+    game->journal.size = 0;
+}
+
+void Game_copy(Game *to, const Game *from) {
+    *to = *from;
+    for (int i = 0; i < MAX_PLAYERS; ++i) {
+        to->players[i].game = to;
+    }
+}
+
+static void deal(Game *game);
+
+void Game_init(Game *game) {
+    Game_clear(game);
+    Pile_fullDeck(&game->drawPile);
 
     // Shuffle the draw pile
     Pile_shuffle(&game->drawPile);
+    deal(game);
+}
+
+// The same deal for the same seed, for replays and self-play.
+void Game_initSeeded(Game *game, uint64_t seed) {
+    Game_deal(game, DEFAULT_PLAYERS, seed);
+}
 
+void Game_deal(Game *game, int numPlayers, uint64_t seed) {
+    Random random;
+    Random_seed(&random, seed);
+    Game_clearPlayers(game, numPlayers);
+    Pile_fullDeck(&game->drawPile);
+    Pile_shuffleRandom(&game->drawPile, &random);
+    deal(game);
+}
+
+static void deal(Game *game) {
     // Deal 7 cards to each player
     for (int i = 0; i < game->numPlayers; ++i) {
         Player *player = Game_player(game, i);
@@ -31,6 +69,56 @@ void Game_init(Game *game) {
 
     // Clear the play for the first player
     Turn_init(&firstPlayer->turn);
+    Game_commit(game);
+}
+
+// Checks that every card is legal and in at most one place.  Returns NULL
+// if so, or a short description of the first problem found.
+const char *Game_validate(Game *game) {
+    Cards zones[MAX_PLAYERS + 4];
+    int numZones = 0;
+
+    for (int i = 0; i < game->numPlayers; ++i) {
+        zones[numZones++] = game->players[i].hand;
+        if (!Cards_isLegal(game->players[i].known)) {
+            return "illegal card";
+        }
+        if (game->players[i].score < -MAX_SCORE || game->players[i].score > MAX_SCORE) {
+            return "score out of range";
+        }
+    }
+    zones[numZones++] = Cards_toHighAces(game->table.runs);
+    zones[numZones++] = game->table.sets;
+    Cards draw = 0, discard = 0;
+    for (int i = 0; i < Pile_size(&game->drawPile); ++i) {
+        if (draw & game->drawPile.cards[i]) {
+            return "card in two places";
+        }
+        draw |= game->drawPile.cards[i];
+    }
+    for (int i = 0; i < Pile_size(&game->discardPile); ++i) {
+        if (discard & game->discardPile.cards[i]) {
+            return "card in two places";
+        }
+        discard |= game->discardPile.cards[i];
+    }
+    zones[numZones++] = draw;
+    zones[numZones++] = discard;
+
+    Cards seen = 0;
+    for (int i = 0; i < numZones; ++i) {
+        if (!Cards_isLegal(zones[i])) {
+            return "illegal card";
+        }
+        if (seen & zones[i]) {
+            return "card in two places";
+        }
+        seen |= zones[i];
+    }
+    if (game->currentPlayer < 0 || game->currentPlayer >= game->numPlayers) {
+        return "bad player to move";
+    }
+    return NULL;
 }
 
 Player *Game_player(Game *game, int num) {
@@ -42,11 +130,126 @@ Player *Game_currentPlayer(Game *game) {
     return &(game->players[game->currentPlayer]);
 }
 
+// Plays a turn found by the search and passes the turn on.  A turn that
+// begins with a draw takes the top of the stock; the search plans such a
+// turn without knowing that card, so it stays in hand.  The player's turn
+// is left as played, the card drawn included.
+void Game_play(Game *game, const Turn *turn) {
+    Player *player = Game_currentPlayer(game);
+    Game_make(game, turn->taken.size, turn->meld.runs, turn->meld.sets, turn->discard);
+    player->turn.eval = turn->eval;
+    Game_commit(game);
+}
+
+void Game_make(Game *game, int taken, Cards runs, Cards sets, Cards discard) {
+    Player *player = Game_currentPlayer(game);
+    if (taken == 0) {
+        Player_draw(player);
+    }
+    for (int i = 0; i < taken; ++i) {
+        Player_take(player);
+    }
+
+    // Lay-offs of fewer than three cards go one at a time, each next to
+    // what is already on the table.
+    if (Cards_size(runs) >= 3) {
+        Player_playRun(player, runs);
+    } else {
+        while (runs != 0) {
+            Table *table = &game->table;
+            Cards next = Cards_low(runs & ((table->runs << 1) | (table->runs >> 1)));
+            assert(next != 0);
+            Player_playRun(player, next);
+            Cards_remove(&runs, next);
+        }
+    }
+    if (sets != 0) {
+        Player_playSet(player, sets);
+    }
+    if (discard != 0) {
+        Player_discard(player, discard);
+    }
+    Game_nextTurn(game);
+}
+
+static void record(Game *game, MoveType type, int player, Cards cards, bool known) {
+    Journal *journal = &game->journal;
+    assert(journal->size < JOURNAL_SIZE);
+    Move *move = &journal->moves[journal->size++];
+    move->cards = cards;
+    move->type = (uint8_t)type;
+    move->player = (uint8_t)player;
+    move->known = known;
+    move->unused = 0;
+}
+
+// Unmaking a turn change leaves the next player's turn empty, as it was
+// found at the start of the turn.  The record of a turn unmade past the
+// next one's start (Player.turn) is not brought back: it stays empty.
 void Game_nextTurn(Game *game) {
+    record(game, MOVE_NEXT_TURN, game->currentPlayer, 0, false);
     game->currentPlayer = (game->currentPlayer + 1) % game->numPlayers;
     Turn_init(&game->players[game->currentPlayer].turn);
 }
 
+void Game_unmake(Game *game) {
+    Journal *journal = &game->journal;
+    assert(journal->size > 0);
+    Move *move = &journal->moves[--journal->size];
+    Player *player = &game->players[move->player];
+    Cards cards = move->cards;
+    switch (move->type) {
+    case MOVE_DRAW:
+        Pile_push(&game->drawPile, cards);
+        Cards_remove(&player->hand, cards);
+        player->turn.draw = 0;
+        break;
+    case MOVE_TAKE:
+        if (Pile_size(&player->turn.taken) > 0) {
+            Pile_pop(&player->turn.taken);
+        }
+        Cards_remove(&player->hand, cards);
+        if (move->known) {
+            Cards_remove(&player->known, cards);
+        }
+        Pile_push(&game->discardPile, cards);
+        Cards_add(&game->discarded, cards);
+        break;
+    case MOVE_RUN:
+        Cards_add(&player->hand, Cards_toHighAces(cards));
+        Table_removeRun(&game->table, cards);
+        Table_removeRun(&player->turn.meld, cards);
+        player->score -= Cards_points(cards);
+        break;
+    case MOVE_SET:
+        Cards_add(&player->hand, cards);
+        Table_removeSet(&game->table, cards);
+        Table_removeSet(&player->turn.meld, cards);
+        player->score -= Cards_points(cards);
+        break;
+    case MOVE_DISCARD:
+        Pile_pop(&game->discardPile);
+        Cards_remove(&game->discarded, cards);
+        Cards_add(&player->hand, cards);
+        player->turn.discard = 0;
+        break;
+    case MOVE_NEXT_TURN:
+        game->currentPlayer = player->id;
+        break;
+    }
+}
+
+void Game_unmakeTo(Game *game, int mark) {
+    assert(mark >= 0 && mark <= game->journal.size);
+    while (game->journal.size > mark) {
+        Game_unmake(game);
+    }
+}
+
+void Game_commit(Game *game) {
+    game->journal.size = 0;
+}
+
 void Game_print(Game *game) {
     printf("Player %d/%d\n", game->currentPlayer, game->numPlayers);
     for (int i = 0; i < game->numPlayers; ++i) {
@@ -66,6 +269,7 @@ void Player_init(Player *player, Game *game, int id) {
     player->id = id;
     player->score = 0;
     player->hand = 0;
+    player->known = 0;
     Turn_init(&player->turn);
 }
 
@@ -73,70 +277,55 @@ Cards Player_draw(Player *player) {
     Cards card = Pile_pop(&player->game->drawPile);
     Cards_add(&player->hand, card);
     player->turn.draw = card;
+    record(player->game, MOVE_DRAW, player->id, card, false);
     return card;
 }
 
-void Player_undoDraw(Player *player, Cards card) {
-    Pile_push(&player->game->drawPile, card);
-    Cards_remove(&player->hand, card);
-    player->turn.draw = 0;
-}
-
 void Player_take(Player *player) {
     assert(Pile_size(&player->game->discardPile) >= 1);
     Cards card = Pile_pop(&player->game->discardPile);
+    Cards_remove(&player->game->discarded, card);
     Pile_push(&player->turn.taken, card);
     Cards_add(&player->hand, card);
+    record(player->game, MOVE_TAKE, player->id, card, (player->known & card) == 0);
+    Cards_add(&player->known, card);
 }
 
-void Player_undoTakes(Player *player) {
-    while (Pile_size(&player->turn.taken) > 0) {
-        Cards card = Pile_pop(&player->turn.taken);
-        Cards_remove(&player->hand, card);
-        Pile_push(&player->game->discardPile, card);
-    }
-}
+// A run or set is either a new meld of three or more cards or a single card
+// laid off on a meld already on the table.  Aces played low are recorded in
+// the low-ace bit on the table but come out of the hand as high aces.
 
 void Player_playRun(Player *player, Cards meld) {
-    assert(Cards_size(meld) >= 3);
-    assert(Cards_isLegal(meld));
-    assert(Cards_has(player->hand, meld));
-    Table_addRun(&player->game->table, meld);
+    Table *table = &player->game->table;
+    assert(Cards_size(meld) >= 3 ||
+           (meld & ((table->runs << 1) | (table->runs >> 1))) == meld);
+    assert(Cards_has(player->hand, Cards_toHighAces(meld)));
+    Table_addRun(table, meld);
     Table_addRun(&player->turn.meld, meld);
-    Cards_remove(&player->hand, meld);
-}
-
-void Player_undoPlayRun(Player *player, Cards meld) {
-    Cards_add(&player->hand, meld);
-    Table_removeRun(&player->game->table, meld);
-    Table_removeRun(&player->turn.meld, meld);
+    Cards_remove(&player->hand, Cards_toHighAces(meld));
+    player->score += Cards_points(meld);
+    record(player->game, MOVE_RUN, player->id, meld, false);
 }
 
 void Player_playSet(Player *player, Cards meld) {
-    assert(Cards_size(meld) >= 3);
+    Table *table = &player->game->table;
+    assert(Cards_size(meld) >= 3 ||
+           (meld & ((table->sets << 16) | (table->sets >> 16))) == meld);
     assert(Cards_isLegal(meld));
     assert(Cards_has(player->hand, meld));
-    Table_addSet(&player->game->table, meld);
+    Table_addSet(table, meld);
     Table_addSet(&player->turn.meld, meld);
     Cards_remove(&player->hand, meld);
-}
-
-void Player_undoPlaySet(Player *player, Cards meld) {
-    Cards_add(&player->hand, meld);
-    Table_removeSet(&player->game->table, meld);
-    Table_removeSet(&player->turn.meld, meld);
+    player->score += Cards_points(meld);
+    record(player->game, MOVE_SET, player->id, meld, false);
 }
 
 void Player_discard(Player *player, Cards card) {
     Cards_remove(&player->hand, card);
     Pile_push(&player->game->discardPile, card);
+    Cards_add(&player->game->discarded, card);
     player->turn.discard = card;
-}
-
-void Player_undoDiscard(Player *player) {
-    Cards card = Pile_pop(&player->game->discardPile);
-    Cards_add(&player->hand, card);
-    player->turn.discard = 0;
+    record(player->game, MOVE_DISCARD, player->id, card, false);
 }
 
 void Player_print(Player *player) {
@@ -0,0 +1,191 @@
+#include <pthread.h>
+#include <stdbool.h>
+#include "histogram.h"
+
+#define LOAD(x) atomic_load_explicit(&(x), memory_order_relaxed)
+#define STORE(x, v) atomic_store_explicit(&(x), (v), memory_order_relaxed)
+
+void Histogram_init(Histogram *h) {
+    STORE(h->count, 0);
+    STORE(h->sum, 0);
+    STORE(h->min, 0);
+    STORE(h->max, 0);
+    for (int i = 0; i < HISTOGRAM_BUCKETS; ++i) {
+        STORE(h->buckets[i], 0);
+    }
+}
+
+uint64_t Histogram_bucketLow(int index) {
+    if (index < 2 * HISTOGRAM_SUB_BUCKETS) {
+        return (uint64_t)index;
+    }
+    int shift = index / HISTOGRAM_SUB_BUCKETS - 1;
+    return (uint64_t)(index % HISTOGRAM_SUB_BUCKETS + HISTOGRAM_SUB_BUCKETS) << shift;
+}
+
+uint64_t Histogram_bucketHigh(int index) {
+    if (index < 2 * HISTOGRAM_SUB_BUCKETS) {
+        return (uint64_t)index;
+    }
+    int shift = index / HISTOGRAM_SUB_BUCKETS - 1;
+    return Histogram_bucketLow(index) + ((1ULL << shift) - 1);
+}
+
+// The total is written by the caller only, so it is safe to merge a
+// histogram another thread is still recording into.
+void Histogram_merge(Histogram *total, const Histogram *h) {
+    uint64_t count = atomic_load_explicit(&h->count, memory_order_acquire);
+    if (count == 0) {
+        return;
+    }
+    uint64_t totalCount = LOAD(total->count);
+    if (totalCount == 0 || LOAD(h->min) < LOAD(total->min)) {
+        STORE(total->min, LOAD(h->min));
+    }
+    if (LOAD(h->max) > LOAD(total->max)) {
+        STORE(total->max, LOAD(h->max));
+    }
+    STORE(total->sum, LOAD(total->sum) + LOAD(h->sum));
+    for (int i = 0; i < HISTOGRAM_BUCKETS; ++i) {
+        STORE(total->buckets[i], LOAD(total->buckets[i]) + LOAD(h->buckets[i]));
+    }
+    STORE(total->count, totalCount + count);
+}
+
+uint64_t Histogram_count(const Histogram *h) {
+    return LOAD(h->count);
+}
+
+// Returns the highest value equivalent to the one at the given percentile,
+// capped at the largest value recorded.
+uint64_t Histogram_percentile(const Histogram *h, double percent) {
+    uint64_t count = LOAD(h->count);
+    if (count == 0) {
+        return 0;
+    }
+    uint64_t rank = (uint64_t)(percent / 100.0 * (double)count + 0.5);
+    if (rank < 1) {
+        rank = 1;
+    }
+    uint64_t seen = 0;
+    for (int i = 0; i < HISTOGRAM_BUCKETS; ++i) {
+        seen += LOAD(h->buckets[i]);
+        if (seen >= rank) {
+            uint64_t high = Histogram_bucketHigh(i);
+            uint64_t max = LOAD(h->max);
+            return high < max ? high : max;
+        }
+    }
+    return LOAD(h->max);
+}
+
+static const double kPercentiles[] = { 50.0, 90.0, 99.0, 99.9 };
+static const char *kPercentileName[] = { "p50", "p90", "p99", "p999" };
+#define NUM_PERCENTILES 4
+
+void Histogram_print(const Histogram *h, const char *name, FILE *out) {
+    uint64_t count = LOAD(h->count);
+    fprintf(out, "histogram %s count %llu", name, (unsigned long long)count);
+    if (count > 0) {
+        fprintf(out, " mean %llu min %llu", (unsigned long long)(LOAD(h->sum) / count),
+                (unsigned long long)LOAD(h->min));
+        for (int i = 0; i < NUM_PERCENTILES; ++i) {
+            fprintf(out, " %s %llu", kPercentileName[i],
+                    (unsigned long long)Histogram_percentile(h, kPercentiles[i]));
+        }
+        fprintf(out, " max %llu", (unsigned long long)LOAD(h->max));
+    }
+    fprintf(out, "\n");
+}
+
+void Histogram_printJson(const Histogram *h, const char *name, FILE *out) {
+    uint64_t count = LOAD(h->count);
+    fprintf(out, "\"%s\":{\"count\":%llu,\"sum\":%llu,\"min\":%llu,\"max\":%llu", name,
+            (unsigned long long)count, (unsigned long long)LOAD(h->sum),
+            (unsigned long long)LOAD(h->min), (unsigned long long)LOAD(h->max));
+    for (int i = 0; i < NUM_PERCENTILES; ++i) {
+        fprintf(out, ",\"%s\":%llu", kPercentileName[i],
+                (unsigned long long)Histogram_percentile(h, kPercentiles[i]));
+    }
+    // Only non-empty buckets, as [low, high, count].
+    fprintf(out, ",\"buckets\":[");
+    bool first = true;
+    for (int i = 0; i < HISTOGRAM_BUCKETS; ++i) {
+        uint64_t n = LOAD(h->buckets[i]);
+        if (n) {
+            fprintf(out, "%s[%llu,%llu,%llu]", first ? "" : ",",
+                    (unsigned long long)Histogram_bucketLow(i),
+                    (unsigned long long)Histogram_bucketHigh(i), (unsigned long long)n);
+            first = false;
+        }
+    }
+    fprintf(out, "]}");
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//    DecisionHistograms
+//
+
+const char *kDecisionMetricName[DECISION_COUNT] = {
+    "decision_ns", "decision_nodes", "first_move_ns"
+};
+
+static DecisionHistograms *registry = NULL;
+static pthread_mutex_t registryLock = PTHREAD_MUTEX_INITIALIZER;
+
+void DecisionHistograms_init(DecisionHistograms *h) {
+    for (int i = 0; i < DECISION_COUNT; ++i) {
+        Histogram_init(&h->metrics[i]);
+    }
+    h->next = NULL;
+}
+
+void DecisionHistograms_merge(DecisionHistograms *total, const DecisionHistograms *h) {
+    for (int i = 0; i < DECISION_COUNT; ++i) {
+        Histogram_merge(&total->metrics[i], &h->metrics[i]);
+    }
+}
+
+void DecisionHistograms_print(const DecisionHistograms *h, FILE *out) {
+    for (int i = 0; i < DECISION_COUNT; ++i) {
+        Histogram_print(&h->metrics[i], kDecisionMetricName[i], out);
+    }
+}
+
+void DecisionHistograms_printJson(const DecisionHistograms *h, FILE *out) {
+    fprintf(out, "{");
+    for (int i = 0; i < DECISION_COUNT; ++i) {
+        if (i > 0) {
+            fprintf(out, ",");
+        }
+        Histogram_printJson(&h->metrics[i], kDecisionMetricName[i], out);
+    }
+    fprintf(out, "}\n");
+}
+
+void DecisionHistograms_register(DecisionHistograms *h) {
+    pthread_mutex_lock(&registryLock);
+    h->next = registry;
+    registry = h;
+    pthread_mutex_unlock(&registryLock);
+}
+
+void DecisionHistograms_unregister(DecisionHistograms *h) {
+    pthread_mutex_lock(&registryLock);
+    for (DecisionHistograms **p = &registry; *p; p = &(*p)->next) {
+        if (*p == h) {
+            *p = h->next;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&registryLock);
+}
+
+void DecisionHistograms_mergeRegistered(DecisionHistograms *total) {
+    pthread_mutex_lock(&registryLock);
+    for (DecisionHistograms *h = registry; h; h = h->next) {
+        DecisionHistograms_merge(total, h);
+    }
+    pthread_mutex_unlock(&registryLock);
+}
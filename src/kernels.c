@@ -0,0 +1,329 @@
+#include <stdatomic.h>
+#include "kernels.h"
+#include "play.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define KERNELS_X86 1
+#else
+#define KERNELS_X86 0
+#endif
+
+typedef struct KernelsStruct {
+    void (*size)(const Cards *cards, int32_t *sizes, int n);
+    void (*points)(const Cards *cards, int32_t *points, int n);
+    void (*find)(const Cards *hands, const Cards *runs, const Cards *sets,
+                 Cards *runCenters, Cards *runExtensions,
+                 Cards *setCenters, Cards *setExtensions, int n);
+    int32_t (*dot)(const uint64_t *bits, const int8_t *weights, int words);
+} Kernels;
+
+// Scalar kernels: the single-hand functions in a loop.
+
+static void sizeScalar(const Cards *cards, int32_t *sizes, int n) {
+    for (int i = 0; i < n; ++i) {
+        sizes[i] = Cards_size(cards[i]);
+    }
+}
+
+static void pointsScalar(const Cards *cards, int32_t *points, int n) {
+    for (int i = 0; i < n; ++i) {
+        points[i] = Cards_points(cards[i]);
+    }
+}
+
+static void findScalar(const Cards *hands, const Cards *runs, const Cards *sets,
+                       Cards *runCenters, Cards *runExtensions,
+                       Cards *setCenters, Cards *setExtensions, int n) {
+    for (int i = 0; i < n; ++i) {
+        Play play;
+        Play_findHand(&play, hands[i], runs[i], sets[i]);
+        runCenters[i] = play.runCenters;
+        runExtensions[i] = play.runExtensions;
+        setCenters[i] = play.setCenters;
+        setExtensions[i] = play.setExtensions;
+    }
+}
+
+static int32_t dotScalar(const uint64_t *bits, const int8_t *weights, int words) {
+    int32_t sum = 0;
+    for (int w = 0; w < words; ++w) {
+        for (uint64_t b = bits[w]; b != 0; b &= b - 1) {
+            sum += weights[64 * w + __builtin_ctzll(b)];
+        }
+    }
+    return sum;
+}
+
+#if KERNELS_X86
+
+// AVX2 has no 64-bit popcount.  Count the bits of each nibble with a
+// byte shuffle, then add the eight byte counts of each lane with SAD
+// against zero.
+
+__attribute__((target("avx2")))
+static inline __m256i popcount256(__m256i v) {
+    const __m256i table = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+                                           0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+    const __m256i low = _mm256_set1_epi8(0x0F);
+    __m256i lo = _mm256_shuffle_epi8(table, _mm256_and_si256(v, low));
+    __m256i hi = _mm256_shuffle_epi8(table, _mm256_and_si256(_mm256_srli_epi16(v, 4), low));
+    return _mm256_sad_epu8(_mm256_add_epi8(lo, hi), _mm256_setzero_si256());
+}
+
+// Stores the low 32 bits of each 64-bit lane as four int32_t.
+__attribute__((target("avx2")))
+static inline void store4x32(int32_t *out, __m256i v) {
+    const __m256i order = _mm256_setr_epi32(0, 2, 4, 6, 1, 3, 5, 7);
+    __m256i packed = _mm256_permutevar8x32_epi32(v, order);
+    _mm_storeu_si128((__m128i *)out, _mm256_castsi256_si128(packed));
+}
+
+__attribute__((target("avx2")))
+static void sizeAvx2(const Cards *cards, int32_t *sizes, int n) {
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256i h = _mm256_loadu_si256((const __m256i *)(cards + i));
+        store4x32(sizes + i, popcount256(h));
+    }
+    sizeScalar(cards + i, sizes + i, n - i);
+}
+
+__attribute__((target("avx2")))
+static void pointsAvx2(const Cards *cards, int32_t *points, int n) {
+    const __m256i five = _mm256_set1_epi64x((long long)FIVE_POINTS);
+    const __m256i ten = _mm256_set1_epi64x((long long)TEN_POINTS);
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256i h = _mm256_loadu_si256((const __m256i *)(cards + i));
+        __m256i fives = popcount256(_mm256_and_si256(h, five));
+        __m256i tens = popcount256(_mm256_and_si256(h, ten));
+        // 5 * (fives + 2 * tens)
+        __m256i units = _mm256_add_epi64(fives, _mm256_add_epi64(tens, tens));
+        store4x32(points + i, _mm256_add_epi64(units, _mm256_slli_epi64(units, 2)));
+    }
+    pointsScalar(cards + i, points + i, n - i);
+}
+
+// Rotating a whole bitboard by 16 moves every card to the next suit.
+__attribute__((target("avx2")))
+static inline __m256i rotl16x4(__m256i v) {
+    return _mm256_or_si256(_mm256_slli_epi64(v, 16), _mm256_srli_epi64(v, 48));
+}
+
+__attribute__((target("avx2")))
+static inline __m256i rotr16x4(__m256i v) {
+    return _mm256_or_si256(_mm256_srli_epi64(v, 16), _mm256_slli_epi64(v, 48));
+}
+
+__attribute__((target("avx2")))
+static void findAvx2(const Cards *hands, const Cards *runs, const Cards *sets,
+                     Cards *runCenters, Cards *runExtensions,
+                     Cards *setCenters, Cards *setExtensions, int n) {
+    const __m256i highAces = _mm256_set1_epi64x((long long)HIGH_ACES);
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256i h = _mm256_loadu_si256((const __m256i *)(hands + i));
+        __m256i r = _mm256_loadu_si256((const __m256i *)(runs + i));
+        __m256i s = _mm256_loadu_si256((const __m256i *)(sets + i));
+        __m256i lowHand = _mm256_or_si256(h, _mm256_srli_epi64(_mm256_and_si256(h, highAces), 13));
+
+        __m256i rc = _mm256_and_si256(h, _mm256_and_si256(_mm256_slli_epi64(h, 1),
+                                                          _mm256_srli_epi64(h, 1)));
+        __m256i sc = _mm256_and_si256(h, _mm256_and_si256(rotl16x4(h), rotr16x4(h)));
+        __m256i re = _mm256_and_si256(lowHand, _mm256_or_si256(_mm256_slli_epi64(r, 1),
+                                                               _mm256_srli_epi64(r, 1)));
+        __m256i se = _mm256_and_si256(lowHand, _mm256_or_si256(_mm256_slli_epi64(s, 16),
+                                                               _mm256_srli_epi64(s, 16)));
+        _mm256_storeu_si256((__m256i *)(runCenters + i), rc);
+        _mm256_storeu_si256((__m256i *)(runExtensions + i), re);
+        _mm256_storeu_si256((__m256i *)(setCenters + i), sc);
+        _mm256_storeu_si256((__m256i *)(setExtensions + i), se);
+    }
+    findScalar(hands + i, runs + i, sets + i, runCenters + i, runExtensions + i,
+               setCenters + i, setExtensions + i, n - i);
+}
+
+// Expands 32 bits into 32 bytes of 0 or 1, then multiplies them with the
+// weights as unsigned by signed bytes and sums in 32-bit lanes.
+__attribute__((target("avx2")))
+static int32_t dotAvx2(const uint64_t *bits, const int8_t *weights, int words) {
+    const __m256i spread = _mm256_setr_epi8(0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 1, 1, 1, 1,
+                                            2, 2, 2, 2, 2, 2, 2, 2, 3, 3, 3, 3, 3, 3, 3, 3);
+    const __m256i select = _mm256_set1_epi64x((long long)0x8040201008040201ULL);
+    const __m256i one8 = _mm256_set1_epi8(1);
+    const __m256i one16 = _mm256_set1_epi16(1);
+    __m256i acc = _mm256_setzero_si256();
+    for (int i = 0; i < 2 * words; ++i) {
+        uint32_t half = (uint32_t)(bits[i / 2] >> (32 * (i & 1)));
+        __m256i x = _mm256_shuffle_epi8(_mm256_set1_epi32((int)half), spread);
+        x = _mm256_and_si256(_mm256_cmpeq_epi8(_mm256_and_si256(x, select), select), one8);
+        __m256i w = _mm256_loadu_si256((const __m256i *)(weights + 32 * i));
+        acc = _mm256_add_epi32(acc, _mm256_madd_epi16(_mm256_maddubs_epi16(x, w), one16));
+    }
+    __m128i sum = _mm_add_epi32(_mm256_castsi256_si128(acc), _mm256_extracti128_si256(acc, 1));
+    sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0x4E));
+    sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0xB1));
+    return _mm_cvtsi128_si32(sum);
+}
+
+// AVX-512 with VPOPCNTDQ counts 64-bit lanes directly, and the rotates and
+// the narrowing store are single instructions.
+
+#define AVX512_TARGET __attribute__((target("avx512f,avx512bw,avx512vpopcntdq")))
+
+AVX512_TARGET
+static void sizeAvx512(const Cards *cards, int32_t *sizes, int n) {
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m512i h = _mm512_loadu_si512((const void *)(cards + i));
+        _mm256_storeu_si256((__m256i *)(sizes + i), _mm512_cvtepi64_epi32(_mm512_popcnt_epi64(h)));
+    }
+    sizeScalar(cards + i, sizes + i, n - i);
+}
+
+AVX512_TARGET
+static void pointsAvx512(const Cards *cards, int32_t *points, int n) {
+    const __m512i five = _mm512_set1_epi64((long long)FIVE_POINTS);
+    const __m512i ten = _mm512_set1_epi64((long long)TEN_POINTS);
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m512i h = _mm512_loadu_si512((const void *)(cards + i));
+        __m512i fives = _mm512_popcnt_epi64(_mm512_and_si512(h, five));
+        __m512i tens = _mm512_popcnt_epi64(_mm512_and_si512(h, ten));
+        __m512i units = _mm512_add_epi64(fives, _mm512_add_epi64(tens, tens));
+        __m512i total = _mm512_add_epi64(units, _mm512_slli_epi64(units, 2));
+        _mm256_storeu_si256((__m256i *)(points + i), _mm512_cvtepi64_epi32(total));
+    }
+    pointsScalar(cards + i, points + i, n - i);
+}
+
+AVX512_TARGET
+static void findAvx512(const Cards *hands, const Cards *runs, const Cards *sets,
+                       Cards *runCenters, Cards *runExtensions,
+                       Cards *setCenters, Cards *setExtensions, int n) {
+    const __m512i highAces = _mm512_set1_epi64((long long)HIGH_ACES);
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m512i h = _mm512_loadu_si512((const void *)(hands + i));
+        __m512i r = _mm512_loadu_si512((const void *)(runs + i));
+        __m512i s = _mm512_loadu_si512((const void *)(sets + i));
+        __m512i lowHand = _mm512_or_si512(h, _mm512_srli_epi64(_mm512_and_si512(h, highAces), 13));
+
+        __m512i rc = _mm512_and_si512(h, _mm512_and_si512(_mm512_slli_epi64(h, 1),
+                                                          _mm512_srli_epi64(h, 1)));
+        __m512i sc = _mm512_and_si512(h, _mm512_and_si512(_mm512_rol_epi64(h, 16),
+                                                          _mm512_ror_epi64(h, 16)));
+        __m512i re = _mm512_and_si512(lowHand, _mm512_or_si512(_mm512_slli_epi64(r, 1),
+                                                               _mm512_srli_epi64(r, 1)));
+        __m512i se = _mm512_and_si512(lowHand, _mm512_or_si512(_mm512_slli_epi64(s, 16),
+                                                               _mm512_srli_epi64(s, 16)));
+        _mm512_storeu_si512((void *)(runCenters + i), rc);
+        _mm512_storeu_si512((void *)(runExtensions + i), re);
+        _mm512_storeu_si512((void *)(setCenters + i), sc);
+        _mm512_storeu_si512((void *)(setExtensions + i), se);
+    }
+    findScalar(hands + i, runs + i, sets + i, runCenters + i, runExtensions + i,
+               setCenters + i, setExtensions + i, n - i);
+}
+
+// A 64-bit word of the bit vector is a byte mask, so the bytes come from
+// one masked move.
+AVX512_TARGET
+static int32_t dotAvx512(const uint64_t *bits, const int8_t *weights, int words) {
+    const __m512i one8 = _mm512_set1_epi8(1);
+    const __m512i one16 = _mm512_set1_epi16(1);
+    __m512i acc = _mm512_setzero_si512();
+    for (int i = 0; i < words; ++i) {
+        __m512i x = _mm512_maskz_mov_epi8((__mmask64)bits[i], one8);
+        __m512i w = _mm512_loadu_si512((const void *)(weights + 64 * i));
+        acc = _mm512_add_epi32(acc, _mm512_madd_epi16(_mm512_maddubs_epi16(x, w), one16));
+    }
+    return _mm512_reduce_add_epi32(acc);
+}
+
+#endif // KERNELS_X86
+
+static const Kernels kernels[KERNELS_COUNT] = {
+    [KERNELS_SCALAR] = {sizeScalar, pointsScalar, findScalar, dotScalar},
+#if KERNELS_X86
+    [KERNELS_AVX2] = {sizeAvx2, pointsAvx2, findAvx2, dotAvx2},
+    [KERNELS_AVX512] = {sizeAvx512, pointsAvx512, findAvx512, dotAvx512},
+#endif
+};
+
+static const char *names[KERNELS_COUNT] = {
+    [KERNELS_SCALAR] = "scalar",
+    [KERNELS_AVX2] = "avx2",
+    [KERNELS_AVX512] = "avx512",
+};
+
+// The kernels in use; NULL until the first call picks the best.
+static _Atomic(const Kernels *) active;
+
+bool Kernels_supported(KernelsLevel level) {
+    switch (level) {
+    case KERNELS_SCALAR:
+        return true;
+#if KERNELS_X86
+    case KERNELS_AVX2:
+        return __builtin_cpu_supports("avx2");
+    case KERNELS_AVX512:
+        return __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw") &&
+               __builtin_cpu_supports("avx512vpopcntdq");
+#endif
+    default:
+        return false;
+    }
+}
+
+KernelsLevel Kernels_best(void) {
+    KernelsLevel level = KERNELS_COUNT - 1;
+    while (!Kernels_supported(level)) {
+        --level;
+    }
+    return level;
+}
+
+static const Kernels *Kernels_get(void) {
+    const Kernels *k = atomic_load_explicit(&active, memory_order_relaxed);
+    if (!k) {
+        k = &kernels[Kernels_best()];
+        atomic_store_explicit(&active, k, memory_order_relaxed);
+    }
+    return k;
+}
+
+KernelsLevel Kernels_level(void) {
+    return (KernelsLevel)(Kernels_get() - kernels);
+}
+
+// Unsupported levels are ignored, so the current choice stays.
+void Kernels_use(KernelsLevel level) {
+    if (level >= 0 && level < KERNELS_COUNT && Kernels_supported(level)) {
+        atomic_store_explicit(&active, &kernels[level], memory_order_relaxed);
+    }
+}
+
+const char *Kernels_name(KernelsLevel level) {
+    return level >= 0 && level < KERNELS_COUNT ? names[level] : "unknown";
+}
+
+void Cards_sizeArray(const Cards *cards, int32_t *sizes, int n) {
+    Kernels_get()->size(cards, sizes, n);
+}
+
+void Cards_pointsArray(const Cards *cards, int32_t *points, int n) {
+    Kernels_get()->points(cards, points, n);
+}
+
+void Play_findArray(const Cards *hands, const Cards *runs, const Cards *sets,
+                    Cards *runCenters, Cards *runExtensions,
+                    Cards *setCenters, Cards *setExtensions, int n) {
+    Kernels_get()->find(hands, runs, sets, runCenters, runExtensions,
+                        setCenters, setExtensions, n);
+}
+
+int32_t Kernels_dot(const uint64_t *bits, const int8_t *weights, int words) {
+    return Kernels_get()->dot(bits, weights, words);
+}
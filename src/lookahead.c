@@ -0,0 +1,330 @@
+#include <string.h>
+#include "endgame.h"
+#include "evalcache.h"
+#include "lookahead.h"
+#include "search.h"
+
+#define INFINITE 30000
+
+static const char *const kBackupNames[] = { "maxn", "paranoid" };
+
+const char *Backup_name(Backup backup) {
+    return kBackupNames[backup];
+}
+
+bool Backup_parse(const char *name, Backup *backup) {
+    for (int i = 0; i < 2; ++i) {
+        if (strcmp(name, kBackupNames[i]) == 0) {
+            *backup = (Backup)i;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool Lookahead_init(Lookahead *lookahead, Backup backup, int maxDepth, int bits, bool hugePages) {
+    lookahead->backup = backup;
+    lookahead->maxDepth = maxDepth;
+    lookahead->evaluator = &Eval_handTuned;
+    lookahead->maxNodes = 0;
+    lookahead->deadline = 0;
+    lookahead->stop = NULL;
+    bool ok = TTable_init(&lookahead->table, bits, hugePages);
+    for (int i = 0; i < LOOKAHEAD_MAX_DEPTH; ++i) {
+        PlanList_init(&lookahead->lists[i]);
+    }
+    lookahead->depth = 0;
+    lookahead->nodes = 0;
+    lookahead->leaves = 0;
+    lookahead->probes = 0;
+    lookahead->hits = 0;
+    lookahead->cutoffs = 0;
+    lookahead->aborted = false;
+    return ok;
+}
+
+void Lookahead_free(Lookahead *lookahead) {
+    TTable_free(&lookahead->table);
+    for (int i = 0; i < LOOKAHEAD_MAX_DEPTH; ++i) {
+        PlanList_free(&lookahead->lists[i]);
+    }
+}
+
+void Lookahead_clear(Lookahead *lookahead) {
+    TTable_clear(&lookahead->table);
+}
+
+// The values are scores, so the scores are part of the key, and a
+// paranoid value is for one player.  The key's bucket is fetched as soon
+// as the key is known, while the caller goes on to the child's search.
+static uint64_t positionKey(Lookahead *lookahead, Game *game, int root) {
+    uint64_t salt = lookahead->backup == BACKUP_PARANOID ? (uint64_t)root + 1 : 0;
+    for (int p = 0; p < game->numPlayers; ++p) {
+        salt = EvalCache_mix(salt, (uint32_t)game->players[p].score);
+    }
+    uint64_t key = Plan_positionKey(game, salt);
+    TTable_prefetch(&lookahead->table, key);
+    return key;
+}
+
+static TTEntry *probe(Lookahead *lookahead, uint64_t key, bool *found) {
+    lookahead->probes++;
+    TTEntry *entry = TTable_probe(&lookahead->table, key, found);
+    lookahead->hits += *found;
+    return entry;
+}
+
+// The position's key, if a child search will probe for it.
+static uint64_t childKey(Lookahead *lookahead, Game *game, int depth, int root) {
+    return depth > 0 && Pile_size(&game->drawPile) > 0 ? positionKey(lookahead, game, root) : 0;
+}
+
+// Scores the player's position as if it were its turn.
+static int evaluateFor(Lookahead *lookahead, Game *game, int p) {
+    int mover = game->currentPlayer;
+    game->currentPlayer = p;
+    int value = lookahead->evaluator->evaluate(lookahead->evaluator, game);
+    game->currentPlayer = mover;
+    lookahead->leaves++;
+    return value;
+}
+
+// The hand is over: everyone loses the points left in hand.
+static int finalValue(Game *game, int p) {
+    return game->players[p].score - Cards_points(game->players[p].hand);
+}
+
+static bool outOfTime(Lookahead *lookahead, Game *game, int ply) {
+    if ((lookahead->maxNodes != 0 && lookahead->nodes > lookahead->maxNodes) ||
+        ply == LOOKAHEAD_MAX_DEPTH || Plan_journalFull(game)) {
+        return true;
+    }
+    if ((lookahead->nodes & 1023) == 0) {
+        return (lookahead->stop && atomic_load_explicit(lookahead->stop, memory_order_relaxed)) ||
+               (lookahead->deadline != 0 && Search_nowNs() >= lookahead->deadline);
+    }
+    return false;
+}
+
+// Generates the plans at ply, hint first if it is one of them.  Returns
+// the number of plans, 0 if there are none, or -1 if out of memory.
+static int generate(Lookahead *lookahead, Game *game, int ply, int *hint) {
+    PlanList *list = &lookahead->lists[ply];
+    if (!PlanList_generate(list, game)) {
+        lookahead->aborted = true;
+        return -1;
+    }
+    PlanList_sort(list);
+    if (*hint >= list->size) {
+        *hint = -1;
+    }
+    return list->size;
+}
+
+// Fail-soft alpha-beta for the root player's value, depth turns deep.  The
+// root player maximizes it and the others minimize it.
+static int paranoid(Lookahead *lookahead, Game *game, uint64_t key, int ply, int depth, int alpha, int beta,
+                    int root, int *move) {
+    lookahead->nodes++;
+    if (outOfTime(lookahead, game, ply)) {
+        lookahead->aborted = true;
+        return 0;
+    }
+    if (Pile_size(&game->drawPile) == 0) {
+        return finalValue(game, root);
+    }
+    if (depth == 0) {
+        return evaluateFor(lookahead, game, root);
+    }
+
+    bool found;
+    TTEntry *entry = probe(lookahead, key, &found);
+    int hint = -1;
+    if (found) {
+        hint = entry->move;
+        int value = entry->values[0], bound = TTEntry_bound(entry);
+        if (entry->depth >= depth &&
+            (bound == BOUND_EXACT ||
+             (bound == BOUND_LOWER && value >= beta) ||
+             (bound == BOUND_UPPER && value <= alpha))) {
+            *move = hint;
+            return value;
+        }
+    }
+
+    int size = generate(lookahead, game, ply, &hint);
+    if (size <= 0) {
+        return size < 0 ? 0 : finalValue(game, root);
+    }
+    const Plan *plans = lookahead->lists[ply].plans;
+    int mover = game->currentPlayer;
+    bool maximizing = mover == root;
+    int best = maximizing ? -INFINITE : INFINITE;
+    int bestMove = 0;
+    int a = alpha, b = beta;
+    int mark = Game_mark(game);
+    for (int n = hint >= 0 ? -1 : 0; n < size; ++n) {
+        int i = n < 0 ? hint : n;
+        if (n >= 0 && i == hint) {
+            continue;
+        }
+        int value, childMove;
+        Plan_make(game, &plans[i]);
+        if (game->players[mover].hand == 0) {
+            value = finalValue(game, root);
+        } else {
+            uint64_t child = childKey(lookahead, game, depth - 1, root);
+            value = paranoid(lookahead, game, child, ply + 1, depth - 1, a, b, root, &childMove);
+        }
+        Game_unmakeTo(game, mark);
+        if (lookahead->aborted) {
+            return 0;
+        }
+
+        if (maximizing ? value > best : value < best) {
+            best = value;
+            bestMove = i;
+        }
+        if (maximizing && best > a) {
+            a = best;
+        } else if (!maximizing && best < b) {
+            b = best;
+        }
+        if (a >= b) {
+            lookahead->cutoffs++;
+            break;
+        }
+    }
+
+    // The children may have moved the entry.
+    int bound = best <= alpha ? BOUND_UPPER : best >= beta ? BOUND_LOWER : BOUND_EXACT;
+    entry = TTable_probe(&lookahead->table, key, &found);
+    TTable_store(&lookahead->table, entry, key, bestMove, depth, bound, &best);
+    *move = bestMove;
+    return best;
+}
+
+// Every player's value, depth turns deep; the player to move takes the
+// turn with the highest value for itself, the first of equals in the
+// sorted list whichever order they were tried in, since the others'
+// values depend on which.
+static void maxn(Lookahead *lookahead, Game *game, uint64_t key, int ply, int depth, int values[MAX_PLAYERS],
+                 int *move) {
+    int numPlayers = game->numPlayers;
+    lookahead->nodes++;
+    if (outOfTime(lookahead, game, ply)) {
+        lookahead->aborted = true;
+        return;
+    }
+    if (Pile_size(&game->drawPile) == 0 || depth == 0) {
+        for (int p = 0; p < numPlayers; ++p) {
+            values[p] = depth == 0 && Pile_size(&game->drawPile) > 0 ? evaluateFor(lookahead, game, p)
+                                                                     : finalValue(game, p);
+        }
+        return;
+    }
+
+    bool found;
+    TTEntry *entry = probe(lookahead, key, &found);
+    int hint = -1;
+    if (found) {
+        hint = entry->move;
+        if (entry->depth >= depth) {
+            for (int p = 0; p < numPlayers; ++p) {
+                values[p] = entry->values[p];
+            }
+            *move = hint;
+            return;
+        }
+    }
+
+    int size = generate(lookahead, game, ply, &hint);
+    if (size <= 0) {
+        for (int p = 0; size == 0 && p < numPlayers; ++p) {
+            values[p] = finalValue(game, p);
+        }
+        return;
+    }
+    const Plan *plans = lookahead->lists[ply].plans;
+    int mover = game->currentPlayer;
+    int bestMove = -1;
+    int mark = Game_mark(game);
+    for (int n = hint >= 0 ? -1 : 0; n < size; ++n) {
+        int i = n < 0 ? hint : n;
+        if (n >= 0 && i == hint) {
+            continue;
+        }
+        int child[MAX_PLAYERS], childMove;
+        Plan_make(game, &plans[i]);
+        if (game->players[mover].hand == 0) {
+            for (int p = 0; p < numPlayers; ++p) {
+                child[p] = finalValue(game, p);
+            }
+        } else {
+            maxn(lookahead, game, childKey(lookahead, game, depth - 1, 0), ply + 1, depth - 1, child, &childMove);
+        }
+        Game_unmakeTo(game, mark);
+        if (lookahead->aborted) {
+            return;
+        }
+        if (bestMove < 0 || child[mover] > values[mover] || (child[mover] == values[mover] && i < bestMove)) {
+            memcpy(values, child, numPlayers * sizeof(int));
+            bestMove = i;
+        }
+    }
+
+    entry = TTable_probe(&lookahead->table, key, &found);
+    TTable_store(&lookahead->table, entry, key, bestMove, depth, BOUND_EXACT, values);
+    *move = bestMove;
+}
+
+bool Lookahead_search(Lookahead *lookahead, Game *game, int values[MAX_PLAYERS], Turn *turn) {
+    lookahead->depth = 0;
+    lookahead->nodes = 0;
+    lookahead->leaves = 0;
+    lookahead->probes = 0;
+    lookahead->hits = 0;
+    lookahead->cutoffs = 0;
+    lookahead->aborted = false;
+    if (Pile_size(&game->drawPile) == 0) {
+        return false;
+    }
+
+    int root = game->currentPlayer;
+    int found[MAX_PLAYERS] = {0}, bestMove = 0;
+    TTable_newSearch(&lookahead->table);
+    TTable_setValues(&lookahead->table, lookahead->backup == BACKUP_PARANOID ? 1 : game->numPlayers);
+    int maxDepth = lookahead->maxDepth < LOOKAHEAD_MAX_DEPTH ? lookahead->maxDepth : LOOKAHEAD_MAX_DEPTH;
+    for (int depth = 1; depth <= maxDepth; ++depth) {
+        int result[MAX_PLAYERS] = {0}, move = 0;
+        uint64_t key = positionKey(lookahead, game, root);
+        if (lookahead->backup == BACKUP_PARANOID) {
+            result[root] = paranoid(lookahead, game, key, 0, depth, -INFINITE, INFINITE, root, &move);
+        } else {
+            maxn(lookahead, game, key, 0, depth, result, &move);
+        }
+        if (lookahead->aborted) {
+            break;
+        }
+        memcpy(found, result, sizeof(found));
+        bestMove = move;
+        lookahead->depth = depth;
+    }
+    if (lookahead->depth == 0) {
+        return false;
+    }
+
+    // A hit at the root leaves the list as it was at an earlier search.
+    PlanList *list = &lookahead->lists[0];
+    if (!PlanList_generate(list, game) || list->size == 0) {
+        return false;
+    }
+    PlanList_sort(list);
+    if (bestMove >= list->size) {
+        return false;
+    }
+    Plan_toTurn(&list->plans[bestMove], game, turn);
+    turn->eval = found[root];
+    memcpy(values, found, sizeof(found));
+    return true;
+}
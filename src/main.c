@@ -1,37 +1,192 @@
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 
 #include "cards.h"
 #include "pile.h"
 #include "table.h"
 #include "game.h"
 #include "turn.h"
+#include "analyze.h"
+#include "batch.h"
+#include "book.h"
+#include "evalcache.h"
+#include "kernels.h"
+#include "lookahead.h"
+#include "position.h"
+#include "search.h"
+#include "trace.h"
 
-void Search_meld(Game *game, Turn *scratch, Turn *bestTurn) {
+// Plays out games with the batch simulator and reports the rate.
+static int batchRollouts(int games) {
+    Batch batch;
+    if (games < 1 || !Batch_init(&batch, games)) {
+        fprintf(stderr, "main: cannot simulate %d games\n", games);
+        return 1;
+    }
+    uint64_t start = Search_nowNs();
+    Batch_deal(&batch, start);
+    int64_t turns = Batch_run(&batch, 1000);
+    double seconds = (double)(Search_nowNs() - start) / 1e9;
+    printf("%d games, %lld turns in %.3f s: %.0f games/s, %.0f turns/s (%s kernels)\n",
+           games, (long long)turns, seconds, games / seconds, turns / seconds,
+           Kernels_name(Kernels_level()));
+    Batch_free(&batch);
+    return 0;
+}
 
+// Parses a file of positions, one per line ("-" for stdin), and reports
+// the errors and the rate.
+static int parsePositions(const char *path) {
+    FILE *in = strcmp(path, "-") == 0 ? stdin : fopen(path, "r");
+    if (!in) {
+        perror(path);
+        return 1;
+    }
+    static Game game;
+    char *line = NULL;
+    size_t capacity = 0;
+    long lines = 0, errors = 0;
+    uint64_t start = Search_nowNs();
+    while (getline(&line, &capacity, in) > 0) {
+        int column;
+        const char *error = Position_parse(&game, line, &column);
+        lines++;
+        if (error) {
+            fprintf(stderr, "%s:%ld:%d: %s\n", path, lines, column + 1, error);
+            errors++;
+        }
+    }
+    double seconds = (double)(Search_nowNs() - start) / 1e9;
+    free(line);
+    if (in != stdin) {
+        fclose(in);
+    }
+    printf("%ld positions, %ld errors in %.3f s: %.0f positions/s\n",
+           lines, errors, seconds, lines / seconds);
+    return errors == 0 ? 0 : 1;
 }
 
-void Search_take(Game *game, Turn *scratch, Turn *bestTurn) {
-    Player *player = Game_currentPlayer(game);
-    Pile *discardPile = &game->discardPile;
+// Searches the first turn of seeded deals six turns ahead (paranoid)
+// with transposition tables of every size, on small and huge pages, and
+// reports the probe rate and hit rate of each.
+static int tableSizes(int deals) {
+    printf("%8s %5s %12s %8s %9s\n", "table", "pages", "probes/s", "hits", "ms/deal");
+    for (int bits = 8; bits <= 20; bits += 2) {
+        for (int huge = 0; huge <= 1; ++huge) {
+            Lookahead lookahead;
+            if (deals < 1 || !Lookahead_init(&lookahead, BACKUP_PARANOID, 6, bits, huge)) {
+                fprintf(stderr, "main: cannot search %d deals with %d bits\n", deals, bits);
+                return 1;
+            }
+            uint64_t probes = 0, hits = 0, elapsed = 0;
+            for (int d = 0; d < deals; ++d) {
+                Game game;
+                int values[MAX_PLAYERS];
+                Turn turn;
+                Game_initSeeded(&game, d);
+                uint64_t start = Search_nowNs();
+                Lookahead_search(&lookahead, &game, values, &turn);
+                elapsed += Search_nowNs() - start;
+                probes += lookahead.probes;
+                hits += lookahead.hits;
+            }
+            printf("%6zu K %5s %12.0f %7.1f%% %9.2f\n", (size_t)TTABLE_BUCKET << bits >> 10,
+                   !huge ? "4k" : lookahead.table.hugeMapped ? "2M" : "thp",
+                   probes / (elapsed / 1e9), 100.0 * hits / (probes ? probes : 1), elapsed / 1e6 / deals);
+            Lookahead_free(&lookahead);
+        }
+    }
+    return 0;
+}
 
-    // Try taking each number of cards in the discard pile, up to all of them.
-    while (Pile_size(discardPile) > 0) {
-        Player_take(player);
-        Search_meld(game, scratch, bestTurn);
+// Searches every position of a file ("-" for stdin) and writes the best
+// turns to stdout, in order; the totals go to stderr.
+static int analyzePositions(const char *path, const AnalyzeOptions *options) {
+    FILE *in = strcmp(path, "-") == 0 ? stdin : fopen(path, "r");
+    if (!in) {
+        perror(path);
+        return 1;
+    }
+    AnalyzeTotals totals;
+    bool ok = Analyze_run(in, stdout, options, &totals);
+    if (in != stdin) {
+        fclose(in);
     }
-    Player_undoTakes(player);
+    if (!ok) {
+        fprintf(stderr, "main: cannot start %d threads\n", options->threads);
+        return 1;
+    }
+    double seconds = (double)totals.elapsedNs / 1e9;
+    fprintf(stderr, "%llu positions, %llu errors, %llu nodes in %.3f s: %.0f positions/s (%d threads)\n",
+            (unsigned long long)totals.positions, (unsigned long long)totals.errors,
+            (unsigned long long)totals.nodes, seconds, totals.positions / seconds, options->threads);
+    return 0;
 }
 
-int main(void) {
+int main(int argc, char **argv) {
+    const char *analyzePath = NULL;
+    static Book book;
+    AnalyzeOptions options;
+    AnalyzeOptions_init(&options);
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--trace") == 0 && i + 1 < argc) {
+            Trace_setLevel(atoi(argv[++i]));
+        } else if (strcmp(argv[i], "--cache") == 0 && i + 1 < argc) {
+            EvalCache_setBits(atoi(argv[++i]));
+        } else if (strcmp(argv[i], "--batch") == 0 && i + 1 < argc) {
+            return batchRollouts(atoi(argv[++i]));
+        } else if (strcmp(argv[i], "--tables") == 0 && i + 1 < argc) {
+            return tableSizes(atoi(argv[++i]));
+        } else if (strcmp(argv[i], "--positions") == 0 && i + 1 < argc) {
+            return parsePositions(argv[++i]);
+        } else if (strcmp(argv[i], "--analyze") == 0 && i + 1 < argc) {
+            analyzePath = argv[++i];
+        } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            options.threads = atoi(argv[++i]);
+            options.window = 16 * options.threads;
+        } else if (strcmp(argv[i], "--nodes") == 0 && i + 1 < argc) {
+            options.limits.nodes = strtoull(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--multipv") == 0 && i + 1 < argc) {
+            options.multiPV = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--endgame") == 0 && i + 1 < argc) {
+            options.endgameStock = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--book") == 0 && i + 1 < argc) {
+            const char *error = Book_open(&book, argv[++i]);
+            if (error) {
+                fprintf(stderr, "main: %s: %s\n", argv[i], error);
+                return 1;
+            }
+            options.book = &book;
+        } else {
+            fprintf(stderr, "usage: main [--trace <level>] [--cache <bits>] [--book <file>]\n"
+                            "            [--batch <games>] [--tables <deals>] [--positions <file>]\n"
+                            "            [--analyze <file> [--threads <n>] [--nodes <n>]\n"
+                            "                              [--endgame <stock>] [--multipv <k>]]\n");
+            return 2;
+        }
+    }
+    if (analyzePath) {
+        return analyzePositions(analyzePath, &options);
+    }
+
     Game game;
     Game_init(&game);
     Game_print(&game);
 
-    Turn scratch, bestTurn;
-    Turn_init(&scratch);
-    Turn_init(&bestTurn);
+    Search search;
+    SearchLimits limits;
+    Search_init(&search);
+    search.book = options.book;
+    SearchLimits_init(&limits);
+    Search_start(&search, &game, &limits);
+    Search_run(&search);
+    Trace_flush(stderr);
 
-    Search_take(&game, &scratch, &bestTurn);
+    printf("--- BEST TURN ---\n");
+    Turn_print(&search.best);
+    printf("Nodes: %llu\n", (unsigned long long)search.nodes);
+    SearchStats_print(&search.stats, stdout);
 
     return 0;
-}
\ No newline at end of file
+}
@@ -0,0 +1,133 @@
+#include <string.h>
+#include "evalcache.h"
+#include "kernels.h"
+#include "model.h"
+
+// The spare slots of a plane: values 14 and 15 of each suit.
+static const int kSpareSlots[8] = {14, 15, 30, 31, 46, 47, 62, 63};
+
+void Model_init(Model *model) {
+    memset(model->weights, 0, sizeof(model->weights));
+    model->bias = 0;
+    model->scale = 1 << MODEL_SCALE_BITS;
+}
+
+static uint64_t rivalCards(Game *game, int player) {
+    int cards = 0;
+    for (int p = 0; p < game->numPlayers; ++p) {
+        if (p != player) {
+            cards += Cards_size(game->players[p].hand);
+        }
+    }
+    uint64_t slots = 1ULL << MODEL_WENT_OUT;
+    for (int i = 1; i < 8 && cards >= 2 * i; ++i) {
+        slots |= 1ULL << kSpareSlots[i];
+    }
+    return slots;
+}
+
+static void features(Game *game, int player, Cards hand, Cards buried, uint64_t out[MODEL_WORDS]) {
+    Player *next = &game->players[(player + 1) % game->numPlayers];
+    out[0] = hand;
+    out[1] = Cards_toHighAces(game->table.runs) | game->table.sets;
+    out[2] = buried;
+    out[3] = (next->known & next->hand) | (hand == 0 ? rivalCards(game, player) : 0);
+}
+
+static Cards discardTop(Game *game) {
+    int size = Pile_size(&game->discardPile);
+    return size > 0 ? game->discardPile.cards[size - 1] : 0;
+}
+
+void Model_features(Game *game, int player, uint64_t out[MODEL_WORDS]) {
+    features(game, player, game->players[player].hand, game->discarded & ~discardTop(game), out);
+}
+
+static int scaled(const Model *model, int32_t sum) {
+    return (int)(((int64_t)(model->bias + sum) * model->scale) >> MODEL_SCALE_BITS);
+}
+
+int Model_evaluate(const Model *model, Game *game) {
+    uint64_t f[MODEL_WORDS];
+    Model_features(game, game->currentPlayer, f);
+    return Game_currentPlayer(game)->score + scaled(model, Kernels_dot(f, model->weights, MODEL_WORDS));
+}
+
+// The features are the same for every discard except the hand plane, and
+// the discard pile becomes buried under whichever card is thrown.  So one
+// dot product serves the whole hand, less each card's own weight.
+int Model_discards(const Model *model, Game *game, Discard *top, int k) {
+    Player *player = Game_currentPlayer(game);
+    Cards hand = player->hand;
+    uint64_t f[MODEL_WORDS];
+    if (k <= 0 || hand == 0) {
+        return 0;
+    }
+    if (Cards_size(hand) == 1) {
+        features(game, player->id, 0, game->discarded, f);
+        top[0].card = hand;
+        top[0].eval = player->score + scaled(model, Kernels_dot(f, model->weights, MODEL_WORDS));
+        return 1;
+    }
+
+    features(game, player->id, hand, game->discarded, f);
+    int32_t sum = Kernels_dot(f, model->weights, MODEL_WORDS);
+    int written = 0;
+    for (Cards c = Cards_low(hand); c != 0; c = Cards_next(hand, c)) {
+        int eval = player->score + scaled(model, sum - model->weights[Cards_toCard(c)]);
+
+        // Insert into the sorted top k; equal evaluations keep card order.
+        int i = written < k ? written++ : k;
+        for (; i > 0 && top[i - 1].eval < eval; --i) {
+            if (i < k) {
+                top[i] = top[i - 1];
+            }
+        }
+        if (i < k) {
+            top[i].card = c;
+            top[i].eval = eval;
+        }
+    }
+    return written;
+}
+
+static int modelEvaluate(const Evaluator *evaluator, Game *game) {
+    return Model_evaluate(evaluator->data, game);
+}
+
+static int modelDiscards(const Evaluator *evaluator, Game *game, Discard *top, int k) {
+    return Model_discards(evaluator->data, game, top, k);
+}
+
+void Model_evaluator(const Model *model, Evaluator *evaluator) {
+    evaluator->name = "model";
+    evaluator->evaluate = modelEvaluate;
+    evaluator->discards = modelDiscards;
+    evaluator->data = model;
+}
+
+bool Model_load(Model *model, FILE *in) {
+    Model loaded;
+    int version;
+    if (fscanf(in, " rumbot-model %d bias %d scale %d weights", &version,
+               &loaded.bias, &loaded.scale) != 3 || version != 1) {
+        return false;
+    }
+    for (int i = 0; i < MODEL_INPUTS; ++i) {
+        int w;
+        if (fscanf(in, "%d", &w) != 1 || w < -128 || w > 127) {
+            return false;
+        }
+        loaded.weights[i] = (int8_t)w;
+    }
+    *model = loaded;
+    EvalCache_invalidate();
+    return true;
+}
+
+void Model_save(const Model *model, FILE *out) {
+    fprintf(out, "rumbot-model 1\nbias %d\nscale %d\nweights\n", model->bias, model->scale);
+    for (int i = 0; i < MODEL_INPUTS; ++i) {
+        fprintf(out, "%d%c", model->weights[i], i % 16 == 15 ? '\n' : ' ');
+    }
+}
@@ -0,0 +1,33 @@
+#include <sys/mman.h>
+#include "pages.h"
+
+// The pool's mapping reserves its pages up front, so a pool too small
+// fails here rather than with SIGBUS on the first touch.
+void *Pages_map(size_t size, bool hugePages, bool *huge) {
+    *huge = false;
+#ifdef MAP_HUGETLB
+    if (hugePages) {
+        void *map = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (map != MAP_FAILED) {
+            *huge = true;
+            return map;
+        }
+    }
+#endif
+    void *map = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (map == MAP_FAILED) {
+        return NULL;
+    }
+#ifdef MADV_HUGEPAGE
+    if (hugePages) {
+        madvise(map, size, MADV_HUGEPAGE);
+    }
+#endif
+    return map;
+}
+
+void Pages_unmap(void *pages, size_t size) {
+    if (pages) {
+        munmap(pages, size);
+    }
+}
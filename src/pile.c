@@ -19,6 +19,15 @@ void Pile_shuffle(Pile *pile) {
     }
 }
 
+void Pile_shuffleRandom(Pile *pile, Random *random) {
+    for (int i = pile->size - 1; i > 0; --i) {
+        int j = (int)Random_uniform(random, i + 1);
+        Cards temp = pile->cards[i];
+        pile->cards[i] = pile->cards[j];
+        pile->cards[j] = temp;
+    }
+}
+
 void Pile_print(Pile *pile) {
     bool first = true;
     for (int i = 0; i < pile->size; ++i) {
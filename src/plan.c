@@ -0,0 +1,182 @@
+#include <stdlib.h>
+#include "evalcache.h"
+#include "plan.h"
+#include "play.h"
+
+void PlanList_init(PlanList *list) {
+    list->plans = NULL;
+    list->size = 0;
+    list->capacity = 0;
+}
+
+void PlanList_free(PlanList *list) {
+    free(list->plans);
+    PlanList_init(list);
+}
+
+typedef struct GeneratorStruct {
+    PlanList *list;
+    Game *game;
+    bool failed;
+} Generator;
+
+static void add(Generator *gen, Cards discard) {
+    PlanList *list = gen->list;
+    if (list->size == list->capacity) {
+        int capacity = list->capacity > 0 ? 2 * list->capacity : 256;
+        Plan *plans = realloc(list->plans, capacity * sizeof(Plan));
+        if (!plans) {
+            gen->failed = true;
+            return;
+        }
+        list->plans = plans;
+        list->capacity = capacity;
+    }
+    Turn *turn = &Game_currentPlayer(gen->game)->turn;
+    Plan *plan = &list->plans[list->size++];
+    plan->runs = turn->meld.runs;
+    plan->sets = turn->meld.sets;
+    plan->discard = discard;
+    plan->taken = Pile_size(&turn->taken);
+    plan->points = Cards_points(turn->meld.runs) + Cards_points(turn->meld.sets);
+}
+
+static void addDiscards(Generator *gen) {
+    Player *player = Game_currentPlayer(gen->game);
+    Turn *turn = &player->turn;
+    int taken = Pile_size(&turn->taken);
+    if (taken > 0 && (player->hand & turn->taken.cards[taken - 1]) != 0) {
+        return;
+    }
+    if (player->hand == 0) {
+        add(gen, 0);
+    }
+    for (Cards card = Cards_low(player->hand); card != 0; card = Cards_next(player->hand, card)) {
+        add(gen, card);
+    }
+}
+
+// As searchMeldRec() in search.c.
+static void generateMelds(Generator *gen, const Play *parent, Cards runMeld, Cards setMeld,
+                          Play *rejected) {
+    Game *game = gen->game;
+    Player *player = Game_currentPlayer(game);
+    Play all = *parent;
+    if (runMeld != 0) {
+        Play_meldRun(&all, player->hand, runMeld);
+    } else if (setMeld != 0) {
+        Play_meldSet(&all, player->hand, setMeld);
+    }
+    Play options = all;
+    Play_exclude(&options, rejected);
+    if (Play_none(&options)) {
+        addDiscards(gen);
+        return;
+    }
+
+    for (Cards center = Cards_low(options.runCenters); center != 0; center = Cards_next(options.runCenters, center)) {
+        Cards meld = Play_runCenterToMeld(center);
+        Player_playRun(player, meld);
+        generateMelds(gen, &all, meld, 0, rejected);
+        Game_unmake(game);
+        Cards_add(&rejected->runCenters, center);
+    }
+    for (Cards center = Cards_low(options.setCenters); center != 0; center = Cards_next(options.setCenters, center)) {
+        Cards meld = Play_setCenterToMeld(center);
+        Player_playSet(player, meld);
+        generateMelds(gen, &all, 0, meld, rejected);
+        Game_unmake(game);
+        Cards_add(&rejected->setCenters, center);
+    }
+    for (Cards meld = Cards_low(options.runExtensions); meld != 0; meld = Cards_next(options.runExtensions, meld)) {
+        Player_playRun(player, meld);
+        generateMelds(gen, &all, meld, 0, rejected);
+        Game_unmake(game);
+        Cards_add(&rejected->runExtensions, meld);
+    }
+    for (Cards meld = Cards_low(options.setExtensions); meld != 0; meld = Cards_next(options.setExtensions, meld)) {
+        Player_playSet(player, meld);
+        generateMelds(gen, &all, 0, meld, rejected);
+        Game_unmake(game);
+        Cards_add(&rejected->setExtensions, meld);
+    }
+    generateMelds(gen, &all, 0, 0, rejected);
+
+    Cards_remove(&rejected->runCenters, options.runCenters);
+    Cards_remove(&rejected->setCenters, options.setCenters);
+    Cards_remove(&rejected->runExtensions, options.runExtensions);
+    Cards_remove(&rejected->setExtensions, options.setExtensions);
+}
+
+static void generateTurn(Generator *gen, const Play *options) {
+    Play rejected;
+    Play_init(&rejected);
+    generateMelds(gen, options, 0, 0, &rejected);
+}
+
+bool PlanList_generate(PlanList *list, Game *game) {
+    Generator gen = { list, game, false };
+    Player *player = Game_currentPlayer(game);
+    Turn saved = player->turn;
+    int mark = Game_mark(game);
+    list->size = 0;
+    Turn_init(&player->turn);
+
+    Play options;
+    if (Pile_size(&game->drawPile) > 0) {
+        Player_draw(player);
+        Play_find(game, &options);
+        generateTurn(&gen, &options);
+        Game_unmakeTo(game, mark);
+    }
+    Play_find(game, &options);
+    while (Pile_size(&game->discardPile) > 0) {
+        Player_take(player);
+        Cards taken = player->turn.taken.cards[Pile_size(&player->turn.taken) - 1];
+        Play_addCards(&options, player->hand, taken, game->table.runs, game->table.sets);
+        generateTurn(&gen, &options);
+    }
+    Game_unmakeTo(game, mark);
+    player->turn = saved;
+    return !gen.failed;
+}
+
+static int comparePoints(const void *a, const void *b) {
+    const Plan *x = a, *y = b;
+    return y->points - x->points;
+}
+
+void PlanList_sort(PlanList *list) {
+    qsort(list->plans, list->size, sizeof(Plan), comparePoints);
+}
+
+void Plan_toTurn(const Plan *plan, Game *game, Turn *turn) {
+    Turn_init(turn);
+    int piled = Pile_size(&game->discardPile);
+    for (int i = 0; i < plan->taken; ++i) {
+        Pile_push(&turn->taken, game->discardPile.cards[piled - 1 - i]);
+    }
+    if (plan->taken == 0) {
+        turn->draw = game->drawPile.cards[Pile_size(&game->drawPile) - 1];
+    }
+    turn->meld.runs = plan->runs;
+    turn->meld.sets = plan->sets;
+    turn->discard = plan->discard;
+}
+
+uint64_t Plan_positionKey(Game *game, uint64_t salt) {
+    uint64_t h = EvalCache_mix(0x9E3779B97F4A7C15ULL ^ salt, (uint64_t)game->currentPlayer);
+    for (int p = 0; p < game->numPlayers; ++p) {
+        h = EvalCache_mix(h, game->players[p].hand);
+    }
+    h = EvalCache_mix(h, game->table.runs);
+    h = EvalCache_mix(h, game->table.sets);
+    for (int i = 0; i < Pile_size(&game->drawPile); ++i) {
+        h = EvalCache_mix(h, game->drawPile.cards[i]);
+    }
+    h = EvalCache_mix(h, (uint64_t)Pile_size(&game->drawPile) << 32 | (uint64_t)Pile_size(&game->discardPile));
+    for (int i = 0; i < Pile_size(&game->discardPile); ++i) {
+        h = EvalCache_mix(h, game->discardPile.cards[i]);
+    }
+    return h != 0 ? h : 1;
+}
@@ -0,0 +1,247 @@
+#include <stdio.h>
+#include <string.h>
+#include "position.h"
+
+static inline bool endsWord(char c) {
+    return c == ' ' || c == '\t' || c == '/' || c == '\n' || c == '\r' || c == '\0';
+}
+
+// Errors in a list are collected as it is read and checked once at the end.
+const char *Position_parseCards(const char *s, Cards *cards, Pile *pile) {
+    if (pile) {
+        Pile_init(pile);
+    }
+    *cards = 0;
+    if (s[0] == '-' && endsWord(s[1])) {
+        return s + 1;
+    }
+    unsigned bad = 0;
+    Cards seen = 0, repeated = 0;
+    int n = 0;
+    Cards order[52];
+    for (; !endsWord(s[0]); s += 2) {
+        if (endsWord(s[1]) || n == 52) {
+            return NULL;
+        }
+        unsigned card = Card_parse(s[0], s[1]);
+        bad |= card;
+        Cards bit = 1ULL << (card & 63);
+        repeated |= seen & bit;
+        seen |= bit;
+        order[n++] = bit;
+    }
+    if ((bad & CARD_BAD) || repeated != 0 || n == 0) {
+        return NULL;
+    }
+    *cards = seen;
+    if (pile) {
+        memcpy(pile->cards, order, n * sizeof(Cards));
+        pile->size = n;
+    }
+    return s;
+}
+
+static const char *skipBlanks(const char *s) {
+    while (*s == ' ' || *s == '\t') {
+        s++;
+    }
+    return s;
+}
+
+static const char *parseInt(const char *s, int *value) {
+    bool negative = *s == '-';
+    s += negative;
+    if (*s < '0' || *s > '9') {
+        return NULL;
+    }
+    long v = 0;
+    for (; *s >= '0' && *s <= '9' && v < 1000000000; ++s) {
+        v = v * 10 + (*s - '0');
+    }
+    *value = (int)(negative ? -v : v);
+    return s;
+}
+
+typedef struct ParserStruct {
+    const char *s;
+    const char *error;
+    const char *at;
+} Parser;
+
+static bool fail(Parser *p, const char *error) {
+    p->error = error;
+    p->at = p->s;
+    return false;
+}
+
+// Moves to the next field, which must be there.
+static bool nextField(Parser *p) {
+    const char *s = skipBlanks(p->s);
+    if (s == p->s || endsWord(*s)) {
+        return fail(p, "missing field");
+    }
+    p->s = s;
+    return true;
+}
+
+static bool cardsField(Parser *p, Cards *cards, Pile *pile) {
+    const char *end = Position_parseCards(p->s, cards, pile);
+    if (!end || *end == '/') {
+        return fail(p, "bad cards");
+    }
+    p->s = end;
+    return true;
+}
+
+// One entry per player, separated by '/'.  Returns the number of entries.
+static int perPlayer(Parser *p, Cards cards[MAX_PLAYERS], int scores[MAX_PLAYERS]) {
+    int n = 0;
+    for (;;) {
+        if (n == MAX_PLAYERS) {
+            fail(p, "too many players");
+            return 0;
+        }
+        const char *end = cards ? Position_parseCards(p->s, &cards[n], NULL)
+                                : parseInt(p->s, &scores[n]);
+        if (!end) {
+            fail(p, cards ? "bad cards" : "bad score");
+            return 0;
+        }
+        p->s = end;
+        n++;
+        if (*p->s != '/') {
+            return n;
+        }
+        p->s++;
+    }
+}
+
+const char *Position_parse(Game *game, const char *line, int *column) {
+    Parser parser = { line, NULL, line };
+    Parser *p = &parser;
+    Cards hands[MAX_PLAYERS], known[MAX_PLAYERS], stock;
+    int scores[MAX_PLAYERS];
+    int tomove = 0;
+
+    Game_clear(game);
+    p->s = skipBlanks(p->s);
+    int players = perPlayer(p, hands, NULL);
+    if (players == 0) {
+        goto error;
+    }
+    if (players < MIN_PLAYERS) {
+        fail(p, "too few players");
+        goto error;
+    }
+    Game_clearPlayers(game, players);
+    if (!nextField(p) || !cardsField(p, &stock, &game->drawPile) ||
+        !nextField(p) || !cardsField(p, &game->discarded, &game->discardPile) ||
+        !nextField(p) || !cardsField(p, &game->table.runs, NULL) ||
+        !nextField(p) || !cardsField(p, &game->table.sets, NULL) ||
+        !nextField(p)) {
+        goto error;
+    }
+    if (perPlayer(p, NULL, scores) != players) {
+        if (!p->error) {
+            fail(p, "wrong number of scores");
+        }
+        goto error;
+    }
+    if (!nextField(p)) {
+        goto error;
+    }
+    const char *end = parseInt(p->s, &tomove);
+    if (!end || tomove < 0 || tomove >= players || !endsWord(*end) || *end == '/') {
+        fail(p, "bad player to move");
+        goto error;
+    }
+    p->s = end;
+
+    memset(known, 0, sizeof(known));
+    const char *rest = skipBlanks(p->s);
+    if (!endsWord(*rest)) {
+        p->s = rest;
+        int n = perPlayer(p, known, NULL);
+        if (n == 0) {
+            goto error;
+        }
+        if (n != players) {
+            fail(p, "wrong number of known hands");
+            goto error;
+        }
+        rest = skipBlanks(p->s);
+    }
+    p->s = rest;
+    if (*p->s == '\r') {
+        p->s++;
+    }
+    if (*p->s == '\n') {
+        p->s++;
+    }
+    if (*p->s != '\0') {
+        fail(p, "unexpected text");
+        goto error;
+    }
+
+    for (int i = 0; i < players; ++i) {
+        game->players[i].hand = hands[i];
+        game->players[i].known = known[i];
+        game->players[i].score = scores[i];
+    }
+    game->currentPlayer = tomove;
+    const char *invalid = Game_validate(game);
+    if (invalid) {
+        p->s = line;
+        fail(p, invalid);
+        goto error;
+    }
+    return NULL;
+
+error:
+    if (column) {
+        *column = (int)(p->at - line);
+    }
+    return p->error;
+}
+
+static char *writePile(char *out, Pile *pile) {
+    if (Pile_size(pile) == 0) {
+        *out++ = '-';
+    }
+    for (int i = 0; i < Pile_size(pile); ++i) {
+        const char *name = kCardName[Cards_toCard(pile->cards[i])];
+        *out++ = name[0];
+        *out++ = name[1];
+    }
+    return out;
+}
+
+int Position_format(Game *game, char *buf) {
+    char *out = buf;
+    bool anyKnown = false;
+    for (int i = 0; i < game->numPlayers; ++i) {
+        if (i > 0) {
+            *out++ = '/';
+        }
+        out = Cards_write(game->players[i].hand, out);
+        anyKnown |= game->players[i].known != 0;
+    }
+    *out++ = ' ';
+    out = writePile(out, &game->drawPile);
+    *out++ = ' ';
+    out = writePile(out, &game->discardPile);
+    *out++ = ' ';
+    out = Cards_write(game->table.runs, out);
+    *out++ = ' ';
+    out = Cards_write(game->table.sets, out);
+    for (int i = 0; i < game->numPlayers; ++i) {
+        out += sprintf(out, "%c%d", i == 0 ? ' ' : '/', game->players[i].score);
+    }
+    out += sprintf(out, " %d", game->currentPlayer);
+    for (int i = 0; anyKnown && i < game->numPlayers; ++i) {
+        *out++ = i == 0 ? ' ' : '/';
+        out = Cards_write(game->players[i].known, out);
+    }
+    *out = '\0';
+    return (int)(out - buf);
+}
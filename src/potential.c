@@ -0,0 +1,33 @@
+#include "potential.h"
+
+uint16_t Potential_runOuts[1 << 13];
+uint8_t Potential_setOuts[1 << 8];
+
+// The cards that complete a run of three with two cards of the suit: the
+// same shifts as Play_find, on the suit with its low ace added.
+static uint16_t runOuts(unsigned index) {
+    unsigned high = index << 1;
+    unsigned low = high | ((high >> 13) & 1);
+    unsigned outs = ((low << 1) & (low << 2)) | ((low >> 1) & (low << 1)) | ((low >> 1) & (low >> 2));
+    outs &= SUIT_MASK & ~low;
+    // An ace completes a run at either end; it is the same card.
+    return (uint16_t)((outs | ((outs & 1) << 13)) & ~1U);
+}
+
+static uint8_t setOuts(unsigned index) {
+    unsigned hand = index & 0xF, dead = index >> 4;
+    if (__builtin_popcount(hand) < 2) {
+        return 0;
+    }
+    return (uint8_t)__builtin_popcount(~(hand | dead) & 0xF);
+}
+
+__attribute__((constructor))
+static void Potential_init(void) {
+    for (unsigned i = 0; i < (1 << 13); ++i) {
+        Potential_runOuts[i] = runOuts(i);
+    }
+    for (unsigned i = 0; i < (1 << 8); ++i) {
+        Potential_setOuts[i] = setOuts(i);
+    }
+}
@@ -0,0 +1,609 @@
+#include <limits.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+#include "endgame.h"
+#include "lookahead.h"
+#include "evalcache.h"
+#include "position.h"
+#include "protocol.h"
+#include "trace.h"
+
+#define MAX_WORDS 16
+#define LIST_BUFFER (2 * 64 + 1)
+
+void Engine_init(Engine *engine, Search *search) {
+    engine->search = search;
+    engine->endgame = NULL;
+    engine->lookahead = NULL;
+    pthread_mutex_init(&engine->lock, NULL);
+    pthread_cond_init(&engine->wake, NULL);
+    engine->job = NULL;
+    engine->started = false;
+    engine->quit = false;
+}
+
+void Engine_destroy(Engine *engine) {
+    if (engine->started) {
+        pthread_mutex_lock(&engine->lock);
+        engine->quit = true;
+        pthread_cond_signal(&engine->wake);
+        pthread_mutex_unlock(&engine->lock);
+        pthread_join(engine->thread, NULL);
+    }
+    engine->search->endgame = NULL;
+    engine->search->lookahead = NULL;
+    if (engine->endgame) {
+        Endgame_free(engine->endgame);
+        free(engine->endgame);
+    }
+    if (engine->lookahead) {
+        Lookahead_free(engine->lookahead);
+        free(engine->lookahead);
+    }
+    pthread_cond_destroy(&engine->wake);
+    pthread_mutex_destroy(&engine->lock);
+}
+
+void Session_init(Session *session, Engine *engine, FILE *in, FILE *out) {
+    Search *search = engine->search;
+    session->in = in;
+    session->out = out;
+    session->engine = engine;
+    session->search = search;
+    // The engine may have served an earlier session with its own settings.
+    search->multiPV = 1;
+    TopTurns_init(&search->top, 1);
+    search->endgame = NULL;
+    search->lookahead = NULL;
+    Game_clear(&session->game);
+    SearchStats_init(&session->stats);
+    pthread_mutex_init(&session->lock, NULL);
+    pthread_cond_init(&session->done, NULL);
+    session->searching = false;
+    session->running = false;
+    session->pondering = false;
+    session->pending = false;
+}
+
+static void stopSearch(Session *session);
+
+void Session_destroy(Session *session) {
+    stopSearch(session);
+    pthread_cond_destroy(&session->done);
+    pthread_mutex_destroy(&session->lock);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//    Card lists
+//
+
+// Parses a card list word into a set of cards and, if pile is not NULL,
+// into a pile in the order written.  Returns false on any malformed card.
+static bool parseCards(const char *word, Cards *cards, Pile *pile) {
+    const char *end = Position_parseCards(word, cards, pile);
+    return end && *end == '\0';
+}
+
+static const char *formatCards(Cards cards, char *buf) {
+    *Cards_write(cards, buf) = '\0';
+    return buf;
+}
+
+static const char *formatPile(Pile *pile, char *buf) {
+    char *p = buf;
+    for (int i = 0; i < Pile_size(pile); ++i) {
+        const char *name = Card_name(Cards_toCard(pile->cards[i]));
+        *p++ = name[0];
+        *p++ = name[1];
+    }
+    if (p == buf) {
+        *p++ = '-';
+    }
+    *p = '\0';
+    return buf;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//    Output
+//
+
+static void reply(Session *session, const char *fmt, ...)
+    __attribute__((format(printf, 2, 3)));
+
+static void reply(Session *session, const char *fmt, ...) {
+    va_list args;
+    va_start(args, fmt);
+    pthread_mutex_lock(&session->lock);
+    vfprintf(session->out, fmt, args);
+    fputc('\n', session->out);
+    fflush(session->out);
+    pthread_mutex_unlock(&session->lock);
+    va_end(args);
+}
+
+// Prints the result of the last search.  The caller holds session->lock.
+static void reportLocked(Session *session) {
+    Search *search = session->search;
+    Turn *best = &search->best;
+    char turn[TURN_FORMAT_MAX];
+
+    fprintf(session->out, "info nodes %llu time %llu\n",
+            (unsigned long long)search->nodes,
+            (unsigned long long)(search->elapsedNs / 1000000));
+    if (search->multiPV > 1) {
+        Turn top[TURN_MAX_TOP];
+        int n = TopTurns_sorted(&search->top, &search->game->discardPile, top);
+        for (int i = 0; i < n; ++i) {
+            Turn_format(&top[i], turn);
+            fprintf(session->out, "info multipv %d %s\n", i + 1, turn);
+        }
+    }
+    if (best->eval == INT_MIN) {
+        fprintf(session->out, "bestmove none\n");
+    } else {
+        Turn_format(best, turn);
+        fprintf(session->out, "bestmove %s\n", turn);
+    }
+    fflush(session->out);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//    Searching
+//
+
+// Runs every search of the engine, one "go" at a time, so that what a
+// thread keeps for itself (its evaluation cache) lasts from one search to
+// the next, whichever session made it.
+static void *searchThread(void *arg) {
+    Engine *engine = arg;
+    while (true) {
+        pthread_mutex_lock(&engine->lock);
+        while (!engine->job && !engine->quit) {
+            pthread_cond_wait(&engine->wake, &engine->lock);
+        }
+        Session *session = engine->job;
+        engine->job = NULL;
+        pthread_mutex_unlock(&engine->lock);
+        if (!session) {
+            break;
+        }
+
+        Search_run(engine->search);
+
+        pthread_mutex_lock(&session->lock);
+        SearchStats_merge(&session->stats, &session->search->stats);
+        Trace_flush(session->out);
+        session->running = false;
+        if (session->pondering) {
+            session->pending = true;
+        } else {
+            reportLocked(session);
+        }
+        pthread_cond_signal(&session->done);
+        pthread_mutex_unlock(&session->lock);
+    }
+    return NULL;
+}
+
+// Waits for the running search, if any, to finish.
+static void waitSearch(Session *session) {
+    pthread_mutex_lock(&session->lock);
+    while (session->running) {
+        pthread_cond_wait(&session->done, &session->lock);
+    }
+    pthread_mutex_unlock(&session->lock);
+}
+
+// Stops any search, waits for it, and prints a result still held back.
+static void stopSearch(Session *session) {
+    if (!session->searching) {
+        return;
+    }
+    Search_stop(session->search);
+    waitSearch(session);
+    session->searching = false;
+
+    pthread_mutex_lock(&session->lock);
+    session->pondering = false;
+    if (session->pending) {
+        reportLocked(session);
+        session->pending = false;
+    }
+    pthread_mutex_unlock(&session->lock);
+}
+
+// Returns true if a search is running or holds an unreported result.  A
+// search that is completely finished is collected.
+static bool busy(Session *session) {
+    if (!session->searching) {
+        return false;
+    }
+    pthread_mutex_lock(&session->lock);
+    bool result = session->running || session->pending;
+    pthread_mutex_unlock(&session->lock);
+    if (!result) {
+        session->searching = false;
+    }
+    return result;
+}
+
+static void commandGo(Session *session, char **words, int numWords) {
+    SearchLimits limits;
+    SearchLimits_init(&limits);
+    bool ponder = false;
+
+    for (int i = 1; i < numWords; ++i) {
+        if (strcmp(words[i], "nodes") == 0 && i + 1 < numWords) {
+            limits.nodes = strtoull(words[++i], NULL, 10);
+        } else if (strcmp(words[i], "movetime") == 0 && i + 1 < numWords) {
+            limits.timeMs = atoi(words[++i]);
+        } else if (strcmp(words[i], "infinite") == 0) {
+            SearchLimits_init(&limits);
+        } else if (strcmp(words[i], "ponder") == 0) {
+            ponder = true;
+        } else {
+            reply(session, "error bad go option %s", words[i]);
+            return;
+        }
+    }
+
+    const char *why = Game_validate(&session->game);
+    if (why) {
+        reply(session, "error %s", why);
+        return;
+    }
+
+    Engine *engine = session->engine;
+    if (!engine->started) {
+        if (pthread_create(&engine->thread, NULL, searchThread, engine) != 0) {
+            reply(session, "error cannot start search");
+            return;
+        }
+        engine->started = true;
+    }
+    Search_start(session->search, &session->game, &limits);
+    pthread_mutex_lock(&session->lock);
+    session->running = true;
+    session->pondering = ponder;
+    session->pending = false;
+    session->searching = true;
+    pthread_mutex_unlock(&session->lock);
+
+    pthread_mutex_lock(&engine->lock);
+    engine->job = session;
+    pthread_cond_signal(&engine->wake);
+    pthread_mutex_unlock(&engine->lock);
+}
+
+static void commandHistogram(Session *session, bool json) {
+    DecisionHistograms *total = malloc(sizeof(DecisionHistograms));
+    if (!total) {
+        reply(session, "error out of memory");
+        return;
+    }
+    DecisionHistograms_init(total);
+    DecisionHistograms_mergeRegistered(total);
+    pthread_mutex_lock(&session->lock);
+    if (json) {
+        DecisionHistograms_printJson(total, session->out);
+    } else {
+        DecisionHistograms_print(total, session->out);
+    }
+    fflush(session->out);
+    pthread_mutex_unlock(&session->lock);
+    free(total);
+}
+
+// The solver is made at the first use and kept, with its table, by the
+// engine.  Returns false if out of memory.
+static bool commandEndgame(Session *session, int stock) {
+    Engine *engine = session->engine;
+    if (stock <= 0) {
+        session->search->endgame = NULL;
+        return true;
+    }
+    if (!engine->endgame) {
+        Endgame *endgame = malloc(sizeof(Endgame));
+        if (!endgame || !Endgame_init(endgame, stock, ENDGAME_DEFAULT_BITS)) {
+            free(endgame);
+            return false;
+        }
+        engine->endgame = endgame;
+    }
+    engine->endgame->maxStock = stock;
+    session->search->endgame = engine->endgame;
+    return true;
+}
+
+static void commandPonderhit(Session *session) {
+    pthread_mutex_lock(&session->lock);
+    session->pondering = false;
+    if (session->pending) {
+        reportLocked(session);
+        session->pending = false;
+    }
+    pthread_mutex_unlock(&session->lock);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//    Position
+//
+
+static void commandShow(Session *session) {
+    Game *game = &session->game;
+    char buf[LIST_BUFFER];
+
+    pthread_mutex_lock(&session->lock);
+    FILE *out = session->out;
+    fprintf(out, "players %d\n", game->numPlayers);
+    for (int i = 0; i < game->numPlayers; ++i) {
+        fprintf(out, "hand %d %s\n", i, formatCards(game->players[i].hand, buf));
+        fprintf(out, "score %d %d\n", i, game->players[i].score);
+        fprintf(out, "known %d %s\n", i, formatCards(game->players[i].known, buf));
+    }
+    fprintf(out, "drawpile %s\n", formatPile(&game->drawPile, buf));
+    fprintf(out, "discardpile %s\n", formatPile(&game->discardPile, buf));
+    fprintf(out, "runs %s\n", formatCards(game->table.runs, buf));
+    fprintf(out, "sets %s\n", formatCards(game->table.sets, buf));
+    fprintf(out, "tomove %d\n", game->currentPlayer);
+    char position[POSITION_MAX];
+    Position_format(game, position);
+    fprintf(out, "position %s\n", position);
+    fprintf(out, "end\n");
+    fflush(out);
+    pthread_mutex_unlock(&session->lock);
+}
+
+static bool parsePlayer(Session *session, const char *word, int *player) {
+    char *end;
+    long p = strtol(word, &end, 10);
+    if (*end != '\0' || p < 0 || p >= session->game.numPlayers) {
+        reply(session, "error bad player %s", word);
+        return false;
+    }
+    *player = (int)p;
+    return true;
+}
+
+static bool parseList(Session *session, const char *word, Cards *cards, Pile *pile) {
+    if (!parseCards(word, cards, pile)) {
+        reply(session, "error bad cards %s", word);
+        return false;
+    }
+    return true;
+}
+
+// The position is only replaced if the whole notation is good.
+static void commandSetPosition(Session *session, char **words, int numWords) {
+    char line[POSITION_MAX];
+    size_t used = 0;
+    for (int i = 0; i < numWords; ++i) {
+        size_t length = strlen(words[i]);
+        if (used + length + 1 >= sizeof(line)) {
+            reply(session, "error position too long");
+            return;
+        }
+        if (i > 0) {
+            line[used++] = ' ';
+        }
+        memcpy(line + used, words[i], length);
+        used += length;
+    }
+    line[used] = '\0';
+
+    static _Thread_local Game parsed;
+    int column;
+    const char *error = Position_parse(&parsed, line, &column);
+    if (error) {
+        reply(session, "error %s at column %d", error, column);
+        return;
+    }
+    Game_copy(&session->game, &parsed);
+}
+
+// Handles the commands that change the position.  Returns false if the
+// command is not one of them.
+static bool commandPosition(Session *session, char **words, int numWords) {
+    Game *game = &session->game;
+    const char *cmd = words[0];
+    int player;
+    Cards cards;
+    Pile pile;
+
+    if (strcmp(cmd, "newgame") == 0) {
+        Game_deal(game, game->numPlayers, ((uint64_t)arc4random() << 32) | arc4random());
+    } else if (strcmp(cmd, "clear") == 0) {
+        Game_clearPlayers(game, game->numPlayers);
+    } else if (strcmp(cmd, "players") == 0 && numWords == 2) {
+        char *end;
+        long n = strtol(words[1], &end, 10);
+        if (*end != '\0' || n < MIN_PLAYERS || n > MAX_PLAYERS) {
+            reply(session, "error bad number of players %s", words[1]);
+        } else {
+            Game_clearPlayers(game, (int)n);
+        }
+    } else if (strcmp(cmd, "hand") == 0 && numWords == 3) {
+        if (parsePlayer(session, words[1], &player) &&
+            parseList(session, words[2], &cards, NULL)) {
+            game->players[player].hand = cards;
+        }
+    } else if (strcmp(cmd, "score") == 0 && numWords == 3) {
+        if (parsePlayer(session, words[1], &player)) {
+            char *end;
+            long score = strtol(words[2], &end, 10);
+            if (*end != '\0' || end == words[2] || score < -MAX_SCORE || score > MAX_SCORE) {
+                reply(session, "error bad score %s", words[2]);
+            } else {
+                game->players[player].score = (int)score;
+            }
+        }
+    } else if (strcmp(cmd, "known") == 0 && numWords == 3) {
+        if (parsePlayer(session, words[1], &player) &&
+            parseList(session, words[2], &cards, NULL)) {
+            game->players[player].known = cards;
+        }
+    } else if (strcmp(cmd, "drawpile") == 0 && numWords == 2) {
+        if (parseList(session, words[1], &cards, &pile)) {
+            game->drawPile = pile;
+        }
+    } else if (strcmp(cmd, "discardpile") == 0 && numWords == 2) {
+        if (parseList(session, words[1], &cards, &pile)) {
+            game->discardPile = pile;
+        }
+    } else if (strcmp(cmd, "runs") == 0 && numWords == 2) {
+        if (parseList(session, words[1], &cards, NULL)) {
+            game->table.runs = cards;
+        }
+    } else if (strcmp(cmd, "sets") == 0 && numWords == 2) {
+        if (parseList(session, words[1], &cards, NULL)) {
+            game->table.sets = cards;
+        }
+    } else if (strcmp(cmd, "position") == 0 && numWords > 1) {
+        commandSetPosition(session, words + 1, numWords - 1);
+    } else if (strcmp(cmd, "tomove") == 0 && numWords == 2) {
+        if (parsePlayer(session, words[1], &player)) {
+            game->currentPlayer = player;
+            Turn_init(&game->players[player].turn);
+        }
+    } else {
+        return false;
+    }
+    return true;
+}
+
+static bool isPositionCommand(const char *cmd) {
+    static const char *kCommands[] = {
+        "newgame", "clear", "players", "hand", "score", "known", "drawpile", "discardpile",
+        "runs", "sets", "tomove", "position", NULL
+    };
+    for (int i = 0; kCommands[i]; ++i) {
+        if (strcmp(cmd, kCommands[i]) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//    Commands
+//
+// As commandEndgame().  The table is cleared when the rule changes.
+static bool commandLookahead(Session *session, int depth, Backup backup) {
+    Engine *engine = session->engine;
+    if (depth <= 0) {
+        session->search->lookahead = NULL;
+        return true;
+    }
+    if (!engine->lookahead) {
+        Lookahead *lookahead = malloc(sizeof(Lookahead));
+        if (!lookahead || !Lookahead_init(lookahead, backup, depth, LOOKAHEAD_DEFAULT_BITS, true)) {
+            free(lookahead);
+            return false;
+        }
+        engine->lookahead = lookahead;
+    }
+    if (engine->lookahead->backup != backup) {
+        Lookahead_clear(engine->lookahead);
+    }
+    engine->lookahead->backup = backup;
+    engine->lookahead->maxDepth = depth;
+    session->search->lookahead = engine->lookahead;
+    return true;
+}
+
+bool Session_command(Session *session, char *line) {
+    char *words[MAX_WORDS];
+    int numWords = 0;
+    char *save;
+
+    for (char *w = strtok_r(line, " \t\r\n", &save); w && numWords < MAX_WORDS;
+         w = strtok_r(NULL, " \t\r\n", &save)) {
+        words[numWords++] = w;
+    }
+    if (numWords == 0) {
+        return true;
+    }
+
+    const char *cmd = words[0];
+    if (strcmp(cmd, "quit") == 0) {
+        stopSearch(session);
+        return false;
+    } else if (strcmp(cmd, "rumbot") == 0) {
+        reply(session, "id name RumBot");
+        reply(session, "rumbotok");
+    } else if (strcmp(cmd, "isready") == 0) {
+        reply(session, "readyok");
+    } else if (strcmp(cmd, "stop") == 0) {
+        stopSearch(session);
+    } else if (strcmp(cmd, "ponderhit") == 0) {
+        commandPonderhit(session);
+    } else if (strcmp(cmd, "trace") == 0 && numWords == 2) {
+        Trace_setLevel(atoi(words[1]));
+    } else if (strcmp(cmd, "multipv") == 0 && numWords == 2) {
+        if (busy(session)) {
+            reply(session, "error busy");
+        } else {
+            TopTurns_init(&session->search->top, atoi(words[1]));
+            session->search->multiPV = session->search->top.k;
+        }
+    } else if (strcmp(cmd, "cache") == 0 && numWords == 2) {
+        EvalCache_setBits(atoi(words[1]));
+    } else if (strcmp(cmd, "endgame") == 0 && numWords == 2) {
+        if (busy(session)) {
+            reply(session, "error busy");
+        } else if (!commandEndgame(session, atoi(words[1]))) {
+            reply(session, "error out of memory");
+        }
+    } else if (strcmp(cmd, "lookahead") == 0 && (numWords == 2 || numWords == 3)) {
+        Backup backup = BACKUP_PARANOID;
+        if (numWords == 3 && !Backup_parse(words[2], &backup)) {
+            reply(session, "error unknown rule %s", words[2]);
+        } else if (busy(session)) {
+            reply(session, "error busy");
+        } else if (!commandLookahead(session, atoi(words[1]), backup)) {
+            reply(session, "error out of memory");
+        }
+    } else if (strcmp(cmd, "stats") == 0) {
+        pthread_mutex_lock(&session->lock);
+        SearchStats_print(&session->stats, session->out);
+        fflush(session->out);
+        pthread_mutex_unlock(&session->lock);
+    } else if (strcmp(cmd, "histogram") == 0) {
+        commandHistogram(session, numWords > 1 && strcmp(words[1], "json") == 0);
+    } else if (strcmp(cmd, "show") == 0) {
+        commandShow(session);
+    } else if (strcmp(cmd, "go") == 0 || isPositionCommand(cmd)) {
+        if (busy(session)) {
+            reply(session, "error busy");
+        } else if (strcmp(cmd, "go") == 0) {
+            commandGo(session, words, numWords);
+        } else if (!commandPosition(session, words, numWords)) {
+            reply(session, "error bad arguments to %s", cmd);
+        }
+    } else {
+        reply(session, "error unknown command %s", cmd);
+    }
+    return true;
+}
+
+// Reads commands until "quit" or the end of the input.  At the end of the
+// input a running search is allowed to finish, so that a script piped into
+// the engine gets its answer.
+void Session_run(Session *session) {
+    char line[1024];
+    while (fgets(line, sizeof(line), session->in)) {
+        if (!Session_command(session, line)) {
+            return;
+        }
+    }
+    // Let the search finish; stopSearch() then prints its result, even one
+    // held back for a ponderhit that will not come.
+    waitSearch(session);
+    stopSearch(session);
+}
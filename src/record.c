@@ -0,0 +1,216 @@
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "record.h"
+
+static const char kMagic[8] = {'R', 'U', 'M', 'B', 'O', 'T', 'G', 'R'};
+
+static uint8_t cardIndex(Cards card) {
+    return card != 0 ? Cards_toCard(card) : RECORD_NO_CARD;
+}
+
+static Record *append(RecordWriter *writer) {
+    if (writer->used == RECORD_BUFFER) {
+        RecordWriter_flush(writer);
+    }
+    Record *record = &writer->buffer[writer->used++];
+    memset(record, 0, sizeof(Record));
+    return record;
+}
+
+void RecordWriter_init(RecordWriter *writer, FILE *out) {
+    writer->out = out;
+    writer->used = 0;
+    writer->games = 0;
+    writer->turns = 0;
+    writer->failed = false;
+    Record *header = append(writer);
+    header->kind = RECORD_HEADER;
+    memcpy(header->header.magic, kMagic, sizeof(kMagic));
+    header->header.version = RECORD_VERSION;
+    header->header.recordSize = sizeof(Record);
+}
+
+void RecordWriter_game(RecordWriter *writer, uint64_t seed, int numPlayers, uint64_t nodes) {
+    Record *record = append(writer);
+    record->kind = RECORD_GAME;
+    record->player = (uint8_t)numPlayers;
+    record->game.seed = seed;
+    record->game.nodes = nodes;
+    writer->games++;
+}
+
+void RecordWriter_turn(RecordWriter *writer, int player, const Turn *turn) {
+    Record *record = append(writer);
+    record->kind = RECORD_TURN;
+    record->player = (uint8_t)player;
+    record->taken = (uint8_t)turn->taken.size;
+    record->drawn = cardIndex(turn->draw);
+    record->discard = cardIndex(turn->discard);
+    record->turn.runs = turn->meld.runs;
+    record->turn.sets = turn->meld.sets;
+    record->turn.eval = turn->eval;
+    writer->turns++;
+}
+
+bool RecordWriter_flush(RecordWriter *writer) {
+    if (writer->used > 0 && !writer->failed &&
+        fwrite(writer->buffer, sizeof(Record), writer->used, writer->out) != (size_t)writer->used) {
+        writer->failed = true;
+    }
+    writer->used = 0;
+    if (!writer->failed && fflush(writer->out) != 0) {
+        writer->failed = true;
+    }
+    return !writer->failed;
+}
+
+const char *RecordReader_open(RecordReader *reader, const char *path) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return "cannot open file";
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < (off_t)sizeof(Record)) {
+        close(fd);
+        return "not a record file";
+    }
+    void *map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        return "cannot map file";
+    }
+    const Record *header = map;
+    const char *error = NULL;
+    if (header->kind != RECORD_HEADER || memcmp(header->header.magic, kMagic, sizeof(kMagic)) != 0) {
+        error = "not a record file";
+    } else if (header->header.version != RECORD_VERSION || header->header.recordSize != sizeof(Record)) {
+        error = "unsupported record version";
+    }
+    if (error) {
+        munmap(map, (size_t)st.st_size);
+        return error;
+    }
+    madvise(map, (size_t)st.st_size, MADV_SEQUENTIAL);
+
+    // A record cut short by a writer that did not finish is left out.
+    reader->map = map;
+    reader->mapSize = (size_t)st.st_size;
+    reader->records = header + 1;
+    reader->count = reader->mapSize / sizeof(Record) - 1;
+    reader->next = 0;
+    return NULL;
+}
+
+bool RecordReader_nextGame(RecordReader *reader, RecordGame *game) {
+    while (reader->next < reader->count && reader->records[reader->next].kind != RECORD_GAME) {
+        reader->next++;
+    }
+    if (reader->next == reader->count) {
+        return false;
+    }
+    game->start = &reader->records[reader->next++];
+    game->turns = &reader->records[reader->next];
+    while (reader->next < reader->count && reader->records[reader->next].kind == RECORD_TURN) {
+        reader->next++;
+    }
+    game->numTurns = (int)(&reader->records[reader->next] - game->turns);
+    return true;
+}
+
+void RecordReader_close(RecordReader *reader) {
+    munmap(reader->map, reader->mapSize);
+    reader->map = NULL;
+    reader->records = NULL;
+    reader->count = 0;
+}
+
+static bool cardFromIndex(uint8_t index, Cards *card) {
+    if (index == RECORD_NO_CARD) {
+        *card = 0;
+        return true;
+    }
+    *card = index < 64 ? 1ULL << index : 0;
+    return Cards_isLegal(*card) && *card != 0;
+}
+
+// The checks Game_play() leaves to assertions, made before anything moves.
+static const char *checkTurn(Game *game, const Record *record, Turn *turn) {
+    Player *player = Game_currentPlayer(game);
+    Cards drawn, discard;
+    if (record->kind != RECORD_TURN || record->player != game->currentPlayer) {
+        return "wrong player";
+    }
+    if (!cardFromIndex(record->drawn, &drawn) || !cardFromIndex(record->discard, &discard)) {
+        return "bad card";
+    }
+
+    Cards hand = player->hand;
+    int piled = Pile_size(&game->discardPile);
+    if (record->taken == 0) {
+        int stock = Pile_size(&game->drawPile);
+        if (stock == 0 || (drawn != 0 && drawn != game->drawPile.cards[stock - 1])) {
+            return "bad draw";
+        }
+        hand |= game->drawPile.cards[stock - 1];
+    } else if (record->taken > piled || drawn != 0) {
+        return "bad take";
+    } else {
+        for (int i = piled - record->taken; i < piled; ++i) {
+            hand |= game->discardPile.cards[i];
+        }
+    }
+
+    Cards runs = record->turn.runs, sets = record->turn.sets;
+    Cards melded = Cards_toHighAces(runs) | sets;
+    if ((runs & ~(FULL_DECK | LOW_ACES)) != 0 || !Cards_isLegal(sets) ||
+        (Cards_toHighAces(runs) & sets) != 0 || !Cards_has(hand, melded)) {
+        return "bad meld";
+    }
+    if (record->taken > 0 && (melded & game->discardPile.cards[piled - record->taken]) == 0) {
+        return "deepest card taken not melded";
+    }
+    // Lay-offs of fewer than three cards each go next to the table.
+    Cards table = game->table.runs;
+    for (Cards left = Cards_size(runs) < 3 ? runs : 0; left != 0;) {
+        Cards next = Cards_low(left & ((table << 1) | (table >> 1)));
+        if (next == 0) {
+            return "bad lay-off";
+        }
+        table |= next;
+        left &= ~next;
+    }
+    if (sets != 0 && Cards_size(sets) < 3 &&
+        (sets & ((game->table.sets << 16) | (game->table.sets >> 16))) != sets) {
+        return "bad lay-off";
+    }
+    if (discard != 0 && (hand & ~melded & discard) == 0) {
+        return "bad discard";
+    }
+
+    Turn_init(turn);
+    turn->taken.size = record->taken;
+    turn->meld.runs = runs;
+    turn->meld.sets = sets;
+    turn->discard = discard;
+    turn->eval = record->turn.eval;
+    return NULL;
+}
+
+const char *Record_replay(const RecordGame *record, Game *game) {
+    if (record->start->player < MIN_PLAYERS || record->start->player > MAX_PLAYERS) {
+        return "unsupported number of players";
+    }
+    Game_deal(game, record->start->player, record->start->game.seed);
+    for (int i = 0; i < record->numTurns; ++i) {
+        Turn turn;
+        const char *error = checkTurn(game, &record->turns[i], &turn);
+        if (error) {
+            return error;
+        }
+        Game_play(game, &turn);
+    }
+    return NULL;
+}
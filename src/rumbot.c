@@ -0,0 +1,152 @@
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "game.h"
+#include "rumbot.h"
+#include "search.h"
+
+_Static_assert(RUMBOT_MAX_PLAYERS == MAX_PLAYERS, "rumbot.h and game.h disagree");
+_Static_assert(RUMBOT_NUM_PHASES == PHASE_COUNT, "rumbot.h and stats.h disagree");
+_Static_assert(RUMBOT_NUM_TIMERS == TIMER_COUNT, "rumbot.h and stats.h disagree");
+
+struct RumbotStruct {
+    Game game;
+    Search search;
+    RumbotStats stats;
+    SearchStats searchStats;  // merged from every search
+    DecisionHistograms histograms;
+};
+
+int Rumbot_apiVersion(void) {
+    return RUMBOT_API_VERSION;
+}
+
+Rumbot *Rumbot_create(void) {
+    Rumbot *rb = calloc(1, sizeof(Rumbot));
+    if (!rb) {
+        return NULL;
+    }
+    Game_clear(&rb->game);
+    Search_init(&rb->search);
+    SearchStats_init(&rb->searchStats);
+    DecisionHistograms_init(&rb->histograms);
+    rb->search.histograms = &rb->histograms;
+    return rb;
+}
+
+void Rumbot_destroy(Rumbot *rb) {
+    free(rb);
+}
+
+static bool loadPile(Pile *pile, const uint8_t *cards, int size) {
+    if (size < 0 || size > 52) {
+        return false;
+    }
+    Pile_init(pile);
+    for (int i = 0; i < size; ++i) {
+        if (!Card_isLegal(cards[i]) || cards[i] >= 64) {
+            return false;
+        }
+        Pile_push(pile, 1ULL << cards[i]);
+    }
+    return true;
+}
+
+int Rumbot_loadPosition(Rumbot *rb, const RumbotPosition *position) {
+    Game *game = &rb->game;
+    if (position->numPlayers < MIN_PLAYERS || position->numPlayers > MAX_PLAYERS) {
+        return RUMBOT_EINVAL;
+    }
+
+    Game_clearPlayers(game, position->numPlayers);
+    game->currentPlayer = position->toMove;
+    for (int i = 0; i < game->numPlayers; ++i) {
+        game->players[i].hand = position->hands[i];
+        game->players[i].score = position->scores[i];
+        game->players[i].known = position->known[i];
+    }
+    game->table.runs = position->runs;
+    game->table.sets = position->sets;
+    if (!loadPile(&game->drawPile, position->drawPile, position->drawPileSize) ||
+        !loadPile(&game->discardPile, position->discardPile, position->discardPileSize) ||
+        Game_validate(game) != NULL) {
+        Game_clear(game);
+        return RUMBOT_EINVAL;
+    }
+    return RUMBOT_OK;
+}
+
+int Rumbot_search(Rumbot *rb, const RumbotLimits *limits, RumbotResult *result) {
+    SearchLimits searchLimits;
+    SearchLimits_init(&searchLimits);
+    if (limits) {
+        searchLimits.nodes = limits->nodes;
+        searchLimits.timeMs = limits->timeMs;
+    }
+
+    Search *search = &rb->search;
+    Search_start(search, &rb->game, &searchLimits);
+    Search_run(search);
+
+    rb->stats.searches++;
+    rb->stats.nodes += search->nodes;
+    rb->stats.elapsedNs += search->elapsedNs;
+    rb->stats.lastNodes = search->nodes;
+    rb->stats.lastNs = search->elapsedNs;
+    SearchStats_merge(&rb->searchStats, &search->stats);
+
+    Turn *best = &search->best;
+    if (best->eval == INT_MIN) {
+        return RUMBOT_ENOMOVE;
+    }
+    result->take = Pile_size(&best->taken);
+    result->runs = best->meld.runs;
+    result->sets = best->meld.sets;
+    result->discard = best->discard;
+    result->eval = best->eval;
+    return RUMBOT_OK;
+}
+
+void Rumbot_stop(Rumbot *rb) {
+    Search_stop(&rb->search);
+}
+
+void Rumbot_stats(const Rumbot *rb, RumbotStats *stats) {
+    const SearchStats *searchStats = &rb->searchStats;
+    *stats = rb->stats;
+    for (int i = 0; i < PHASE_COUNT; ++i) {
+        stats->phaseNodes[i] = searchStats->nodes[i];
+    }
+    stats->prunes = searchStats->prunes;
+    stats->cacheProbes = searchStats->cacheProbes;
+    stats->cacheHits = searchStats->cacheHits;
+    stats->branching = SearchStats_branching(searchStats);
+    for (int i = 0; i < TIMER_COUNT; ++i) {
+        stats->timerCalls[i] = searchStats->calls[i];
+        stats->cyclesPerCall[i] = SearchStats_cyclesPerCall(searchStats, i);
+    }
+}
+
+int Rumbot_histograms(const Rumbot *rb, int format, char *buf, int size) {
+    char *report = NULL;
+    size_t length = 0;
+    FILE *out = open_memstream(&report, &length);
+    if (!out) {
+        return RUMBOT_EINVAL;
+    }
+    if (format == RUMBOT_FORMAT_JSON) {
+        DecisionHistograms_printJson(&rb->histograms, out);
+    } else {
+        DecisionHistograms_print(&rb->histograms, out);
+    }
+    fclose(out);
+
+    if (size > 0) {
+        size_t n = length < (size_t)size - 1 ? length : (size_t)size - 1;
+        memcpy(buf, report, n);
+        buf[n] = '\0';
+    }
+    free(report);
+    return (int)length;
+}
@@ -0,0 +1,205 @@
+// rumd: the RumBot engine daemon.  See include/protocol.h for the protocol.
+//
+//   rumd                                  one session over stdin/stdout
+//   rumd --socket <path> [--workers <n>]  many sessions over a Unix socket
+//   rumd --book <file> ...                answer first turns from an opening
+//                                         book (include/book.h)
+//
+// In socket mode each accepted connection is one session.  Connections wait
+// in a bounded queue for one of the worker threads; each worker keeps its
+// own Engine (a Search, its search thread and tables) for its whole life,
+// so warm state carries over between the sessions it serves.  Every Search records its decisions into histograms
+// registered process-wide, which any session can dump.
+
+#include <pthread.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "book.h"
+#include "protocol.h"
+#include "search.h"
+
+#define QUEUE_SIZE 64
+
+static Book book;
+static bool haveBook = false;
+
+typedef struct QueueStruct {
+    int fds[QUEUE_SIZE];
+    int head;
+    int size;
+    pthread_mutex_t lock;
+    pthread_cond_t notEmpty;
+    pthread_cond_t notFull;
+} Queue;
+
+static Queue queue = {
+    .head = 0,
+    .size = 0,
+    .lock = PTHREAD_MUTEX_INITIALIZER,
+    .notEmpty = PTHREAD_COND_INITIALIZER,
+    .notFull = PTHREAD_COND_INITIALIZER,
+};
+
+static void Queue_push(Queue *q, int fd) {
+    pthread_mutex_lock(&q->lock);
+    while (q->size == QUEUE_SIZE) {
+        pthread_cond_wait(&q->notFull, &q->lock);
+    }
+    q->fds[(q->head + q->size++) % QUEUE_SIZE] = fd;
+    pthread_cond_signal(&q->notEmpty);
+    pthread_mutex_unlock(&q->lock);
+}
+
+static int Queue_pop(Queue *q) {
+    pthread_mutex_lock(&q->lock);
+    while (q->size == 0) {
+        pthread_cond_wait(&q->notEmpty, &q->lock);
+    }
+    int fd = q->fds[q->head];
+    q->head = (q->head + 1) % QUEUE_SIZE;
+    q->size--;
+    pthread_cond_signal(&q->notFull);
+    pthread_mutex_unlock(&q->lock);
+    return fd;
+}
+
+static void serve(Engine *engine, FILE *in, FILE *out) {
+    Session session;
+    Session_init(&session, engine, in, out);
+    Session_run(&session);
+    Session_destroy(&session);
+}
+
+static Engine *newEngine(void) {
+    Engine *engine = malloc(sizeof(Engine));
+    Search *search = malloc(sizeof(Search));
+    DecisionHistograms *histograms = malloc(sizeof(DecisionHistograms));
+    if (!engine || !search || !histograms) {
+        fprintf(stderr, "rumd: out of memory\n");
+        exit(1);
+    }
+    Search_init(search);
+    DecisionHistograms_init(histograms);
+    DecisionHistograms_register(histograms);
+    search->histograms = histograms;
+    search->book = haveBook ? &book : NULL;
+    Engine_init(engine, search);
+    return engine;
+}
+
+static void *worker(void *arg) {
+    (void)arg;
+    Engine *engine = newEngine();
+
+    while (true) {
+        int fd = Queue_pop(&queue);
+        int outFd = dup(fd);
+        FILE *in = fdopen(fd, "r");
+        FILE *out = outFd >= 0 ? fdopen(outFd, "w") : NULL;
+        if (in && out) {
+            serve(engine, in, out);
+        }
+        if (in) {
+            fclose(in);
+        } else {
+            close(fd);
+        }
+        if (out) {
+            fclose(out);
+        } else if (outFd >= 0) {
+            close(outFd);
+        }
+    }
+    return NULL;
+}
+
+static int listenOn(const char *path) {
+    struct sockaddr_un addr;
+    if (strlen(path) >= sizeof(addr.sun_path)) {
+        fprintf(stderr, "rumd: socket path too long: %s\n", path);
+        return -1;
+    }
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+        perror("rumd: socket");
+        return -1;
+    }
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, path);
+    unlink(path);
+    if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0 || listen(fd, QUEUE_SIZE) < 0) {
+        perror("rumd: bind");
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+static int serveSocket(const char *path, int numWorkers) {
+    int listenFd = listenOn(path);
+    if (listenFd < 0) {
+        return 1;
+    }
+    for (int i = 0; i < numWorkers; ++i) {
+        pthread_t thread;
+        if (pthread_create(&thread, NULL, worker, NULL) != 0) {
+            fprintf(stderr, "rumd: cannot start worker %d\n", i);
+            return 1;
+        }
+        pthread_detach(thread);
+    }
+    while (true) {
+        int fd = accept(listenFd, NULL, NULL);
+        if (fd >= 0) {
+            Queue_push(&queue, fd);
+        }
+    }
+    return 0;
+}
+
+static void usage(void) {
+    fprintf(stderr, "usage: rumd [--socket <path> [--workers <n>]] [--book <file>]\n");
+}
+
+int main(int argc, char **argv) {
+    const char *socketPath = NULL;
+    int numWorkers = 4;
+
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--socket") == 0 && i + 1 < argc) {
+            socketPath = argv[++i];
+        } else if (strcmp(argv[i], "--workers") == 0 && i + 1 < argc) {
+            numWorkers = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--book") == 0 && i + 1 < argc) {
+            const char *error = Book_open(&book, argv[++i]);
+            if (error) {
+                fprintf(stderr, "rumd: %s: %s\n", argv[i], error);
+                return 1;
+            }
+            haveBook = true;
+        } else {
+            usage();
+            return 2;
+        }
+    }
+    if (numWorkers < 1) {
+        usage();
+        return 2;
+    }
+
+    // A client hanging up mid-reply must not take the daemon down.
+    signal(SIGPIPE, SIG_IGN);
+
+    if (socketPath) {
+        return serveSocket(socketPath, numWorkers);
+    }
+    serve(newEngine(), stdin, stdout);
+    return 0;
+}
@@ -0,0 +1,369 @@
+#include <assert.h>
+#include <limits.h>
+#include <time.h>
+#include "book.h"
+#include "endgame.h"
+#include "eval.h"
+#include "evalcache.h"
+#include "lookahead.h"
+#include "play.h"
+#include "search.h"
+#include "trace.h"
+
+// CHECKS=1 checks the incremental meld options at every node.
+#ifndef CHECKS
+#define CHECKS 0
+#endif
+
+void SearchLimits_init(SearchLimits *limits) {
+    limits->nodes = 0;
+    limits->timeMs = 0;
+}
+
+uint64_t Search_nowNs(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+void Search_init(Search *search) {
+    search->game = NULL;
+    search->evaluator = &Eval_handTuned;
+    SearchLimits_init(&search->limits);
+    atomic_init(&search->stop, false);
+    search->deadline = 0;
+    search->nodes = 0;
+    search->startNs = 0;
+    search->elapsedNs = 0;
+    search->firstMoveNs = 0;
+    SearchStats_init(&search->stats);
+    search->histograms = NULL;
+    search->cacheSeed = 0;
+    search->book = NULL;
+    search->endgame = NULL;
+    search->lookahead = NULL;
+    search->multiPV = 1;
+    TopTurns_init(&search->top, 1);
+    Turn_init(&search->best);
+}
+
+// The hand, the table, the discard pile and the score change from one
+// discard node to the next; the rest of what an evaluation reads is the
+// same for the whole search and hashed once here.
+static uint64_t cacheSeed(Search *search, Game *game) {
+    uint64_t h = EvalCache_mix((uintptr_t)search->evaluator, EvalCache_version());
+    h = EvalCache_mix(h, (uint64_t)game->numPlayers << 8 | (uint64_t)game->currentPlayer);
+    for (int p = 0; p < game->numPlayers; ++p) {
+        if (p != game->currentPlayer) {
+            Player *rival = &game->players[p];
+            h = EvalCache_mix(h, (rival->known & rival->hand) ^ ((uint64_t)Cards_size(rival->hand) << 58));
+        }
+    }
+    return h;
+}
+
+void Search_start(Search *search, Game *game, const SearchLimits *limits) {
+    search->game = game;
+    search->limits = *limits;
+    // Positions may be set up by filling the piles directly.
+    game->discarded = Pile_cards(&game->discardPile);
+    search->cacheSeed = cacheSeed(search, game);
+    atomic_store(&search->stop, false);
+    search->deadline = 0;
+    search->nodes = 0;
+    search->elapsedNs = 0;
+    search->firstMoveNs = 0;
+    SearchStats_init(&search->stats);
+    TopTurns_init(&search->top, search->multiPV);
+    Turn_init(&search->best);
+    search->best.eval = INT_MIN;
+}
+
+void Search_stop(Search *search) {
+    atomic_store_explicit(&search->stop, true, memory_order_relaxed);
+}
+
+bool Search_stopped(Search *search) {
+    return atomic_load_explicit(&search->stop, memory_order_relaxed);
+}
+
+// Called once per discard node, with the leaves it scored.  The clock is
+// only read every 1024 leaves.
+static bool checkLimits(Search *search, int leaves) {
+    uint64_t before = search->nodes;
+    search->nodes += leaves;
+    if (search->limits.nodes != 0 && search->nodes >= search->limits.nodes) {
+        Search_stop(search);
+    } else if (search->deadline != 0 && (before >> 10) != (search->nodes >> 10) &&
+               Search_nowNs() >= search->deadline) {
+        Search_stop(search);
+    }
+    return Search_stopped(search);
+}
+
+// Scores the k best discards into top, or the hand as it stands if top is
+// NULL, and returns the best evaluation.
+static int evaluate(Search *search, Discard *top, int k) {
+    Game *game = search->game;
+    Player *player = Game_currentPlayer(game);
+    Discard *best = top;
+    uint64_t key = 0;
+    if (best && k == 1 && EvalCache_bits() > 0) {
+        key = EvalCache_key(search->cacheSeed, player->hand, game->table.runs, game->table.sets,
+                            game->discarded, player->score);
+        STATS_COUNT(&search->stats, cacheProbes);
+        if (EvalCache_probe(key, player->hand, best)) {
+            STATS_COUNT(&search->stats, cacheHits);
+            return best->eval;
+        }
+    }
+
+    STATS_TIMER_BEGIN(TIMER_EVAL, search->stats.calls[TIMER_EVAL]);
+    int eval;
+    const Evaluator *evaluator = search->evaluator;
+    if (best) {
+        evaluator->discards(evaluator, game, best, k);
+        eval = best->eval;
+    } else {
+        eval = evaluator->evaluate(evaluator, game);
+    }
+    STATS_TIMER_END(&search->stats, TIMER_EVAL);
+    STATS_COUNT(&search->stats, calls[TIMER_EVAL]);
+    if (key != 0) {
+        EvalCache_store(key, player->hand, best);
+    }
+    return eval;
+}
+
+static void improve(Search *search, Turn *turn) {
+    Turn_max(&search->best, turn);
+    if (search->top.k > 1 && TopTurns_admits(&search->top, turn->eval)) {
+        TopTurns_add(&search->top, turn);
+    }
+    if (search->firstMoveNs == 0) {
+        search->firstMoveNs = Search_nowNs() - search->startNs;
+    }
+}
+
+static void searchDiscard(Search *search) {
+    Game *game = search->game;
+    Player *player = Game_currentPlayer(game);
+    Turn *turn = &player->turn;
+    Cards hand = player->hand;
+
+    // The deepest card taken from the discard pile must have been melded.
+    int taken = Pile_size(&turn->taken);
+    if (taken > 0 && (hand & turn->taken.cards[taken - 1]) != 0) {
+        STATS_COUNT(&search->stats, prunes);
+        return;
+    }
+
+    if (hand == 0) {
+        // Hand is empty.  Discard nothing.
+        turn->eval = evaluate(search, NULL, 1);
+        TRACE(TRACE_LEAF, TRACE_EV_LEAF, turn->eval, 0, turn->meld.runs, turn->meld.sets, 0);
+        improve(search, turn);
+        checkLimits(search, 1);
+        return;
+    }
+
+    // Every discard is scored in one pass; only the best can improve on
+    // the best turn so far, and only the best k on the best k.
+    Discard best[TURN_MAX_TOP];
+    int k = search->top.k;
+    turn->eval = evaluate(search, best, k);
+    turn->discard = best[0].card;
+    TRACE(TRACE_LEAF, TRACE_EV_LEAF, turn->eval, hand & ~best[0].card, turn->meld.runs, turn->meld.sets, best[0].card);
+    improve(search, turn);
+    int n = k < Cards_size(hand) ? k : Cards_size(hand);
+    for (int i = 1; i < n && TopTurns_admits(&search->top, best[i].eval); ++i) {
+        turn->discard = best[i].card;
+        turn->eval = best[i].eval;
+        TopTurns_add(&search->top, turn);
+    }
+    turn->discard = 0;
+    checkLimits(search, Cards_size(hand));
+}
+
+// Each meld option is tried in turn and then rejected for the rest of the
+// branch, so that the same combination of melds is not reached in two
+// different orders.
+//
+// The options are not found again at every node: the parent's options are
+// brought up to date for the one meld just played (runMeld or setMeld),
+// and checked against Play_find() when built with CHECKS=1.
+static void searchMeldRec(Search *search, const Play *parent, Cards runMeld, Cards setMeld,
+                          Play *rejected) {
+    Game *game = search->game;
+    Player *player = Game_currentPlayer(game);
+
+    Play all = *parent;
+    STATS_TIMER_BEGIN(TIMER_MOVEGEN, search->stats.nodes[PHASE_MELD]);
+    STATS_TIMER_BEGIN(TIMER_FIND, search->stats.nodes[PHASE_MELD]);
+    if (runMeld != 0) {
+        Play_meldRun(&all, player->hand, runMeld);
+    } else if (setMeld != 0) {
+        Play_meldSet(&all, player->hand, setMeld);
+    }
+    STATS_TIMER_END(&search->stats, TIMER_FIND);
+#if CHECKS
+    Play found;
+    Play_find(game, &found);
+    assert(Play_equal(&all, &found));
+#endif
+    Play options = all;
+    Play_exclude(&options, rejected);
+    bool none = Play_none(&options);
+    STATS_TIMER_END(&search->stats, TIMER_MOVEGEN);
+    STATS_COUNT(&search->stats, nodes[PHASE_MELD]);
+
+    if (none) {
+        searchDiscard(search);
+        return;
+    }
+    STATS_COUNT(&search->stats, expanded);
+    STATS_ADD(&search->stats, children,
+              Cards_size(options.runCenters) + Cards_size(options.setCenters) +
+              Cards_size(options.runExtensions) + Cards_size(options.setExtensions) + 1);
+
+    for (Cards center = Cards_low(options.runCenters); center != 0 && !Search_stopped(search); center = Cards_next(options.runCenters, center)) {
+        Cards meld = Play_runCenterToMeld(center);
+        Player_playRun(player, meld);
+        searchMeldRec(search, &all, meld, 0, rejected);
+        Game_unmake(game);
+        Cards_add(&rejected->runCenters, center);
+    }
+
+    for (Cards center = Cards_low(options.setCenters); center != 0 && !Search_stopped(search); center = Cards_next(options.setCenters, center)) {
+        Cards meld = Play_setCenterToMeld(center);
+        Player_playSet(player, meld);
+        searchMeldRec(search, &all, 0, meld, rejected);
+        Game_unmake(game);
+        Cards_add(&rejected->setCenters, center);
+    }
+
+    for (Cards meld = Cards_low(options.runExtensions); meld != 0 && !Search_stopped(search); meld = Cards_next(options.runExtensions, meld)) {
+        Player_playRun(player, meld);
+        searchMeldRec(search, &all, meld, 0, rejected);
+        Game_unmake(game);
+        Cards_add(&rejected->runExtensions, meld);
+    }
+
+    for (Cards meld = Cards_low(options.setExtensions); meld != 0 && !Search_stopped(search); meld = Cards_next(options.setExtensions, meld)) {
+        Player_playSet(player, meld);
+        searchMeldRec(search, &all, 0, meld, rejected);
+        Game_unmake(game);
+        Cards_add(&rejected->setExtensions, meld);
+    }
+
+    // All options in this branch were rejected.
+    if (!Search_stopped(search)) {
+        searchMeldRec(search, &all, 0, 0, rejected);
+    } else {
+        STATS_COUNT(&search->stats, prunes);
+    }
+
+    Cards_remove(&rejected->runCenters, options.runCenters);
+    Cards_remove(&rejected->setCenters, options.setCenters);
+    Cards_remove(&rejected->runExtensions, options.runExtensions);
+    Cards_remove(&rejected->setExtensions, options.setExtensions);
+}
+
+static void searchMeld(Search *search, const Play *options) {
+    Play rejected;
+    Play_init(&rejected);
+    searchMeldRec(search, options, 0, 0, &rejected);
+}
+
+// Ends every run, however it was answered: its time, its decision
+// histograms and its trace.
+static int finish(Search *search) {
+    search->elapsedNs = Search_nowNs() - search->startNs;
+    if (search->histograms) {
+        Histogram *metrics = search->histograms->metrics;
+        Histogram_record(&metrics[DECISION_TIME_NS], search->elapsedNs);
+        Histogram_record(&metrics[DECISION_NODES], search->nodes);
+        if (search->firstMoveNs != 0) {
+            Histogram_record(&metrics[DECISION_FIRST_MOVE_NS], search->firstMoveNs);
+        }
+    }
+    TRACE(TRACE_INFO, TRACE_EV_SEARCH_END, search->best.eval, search->nodes, search->elapsedNs, 0, 0);
+    return search->best.eval;
+}
+
+// Ends a run answered without the turn search, by the book, the endgame
+// solver or the lookahead, with its one turn, which was also its first.
+static int answered(Search *search, const char *by) {
+    TRACE(TRACE_INFO, TRACE_EV_ANSWER, search->best.eval, (uintptr_t)by, 0, 0, 0);
+    TopTurns_add(&search->top, &search->best);
+    search->firstMoveNs = Search_nowNs() - search->startNs;
+    return finish(search);
+}
+
+int Search_run(Search *search) {
+    Game *game = search->game;
+    Player *player = Game_currentPlayer(game);
+    search->startNs = Search_nowNs();
+    if (search->limits.timeMs > 0) {
+        search->deadline = search->startNs + (uint64_t)search->limits.timeMs * 1000000ULL;
+    }
+
+    Turn_init(&player->turn);
+    TRACE(TRACE_INFO, TRACE_EV_SEARCH_START, 0, player->hand,
+          Pile_size(&game->drawPile), Pile_size(&game->discardPile), 0);
+    if (search->book && Book_probe(search->book, game, &search->best)) {
+        return answered(search, "book");
+    }
+    if (search->endgame && Endgame_applies(search->endgame, game)) {
+        Endgame *endgame = search->endgame;
+        int gain;
+        endgame->deadline = search->deadline;
+        endgame->stop = &search->stop;
+        if (Endgame_solve(endgame, game, &gain, &search->best)) {
+            search->nodes = endgame->nodes;
+            search->stats.solver = endgame->nodes;
+            return answered(search, "endgame");
+        }
+    }
+    if (search->lookahead) {
+        Lookahead *lookahead = search->lookahead;
+        int values[MAX_PLAYERS];
+        lookahead->evaluator = search->evaluator;
+        lookahead->maxNodes = search->limits.nodes;
+        lookahead->deadline = search->deadline;
+        lookahead->stop = &search->stop;
+        if (Lookahead_search(lookahead, game, values, &search->best)) {
+            search->nodes = lookahead->nodes;
+            search->stats.solver = lookahead->nodes;
+            return answered(search, "lookahead");
+        }
+    }
+    // Draw from the stock.
+    Play options;
+    Play_find(game, &options);
+    if (Pile_size(&game->drawPile) > 0) {
+        STATS_COUNT(&search->stats, nodes[PHASE_CHANCE]);
+        searchMeld(search, &options);
+    }
+
+    // Take from the discard pile, one card deeper each time.
+    int mark = Game_mark(game);
+    while (!Search_stopped(search) && Pile_size(&game->discardPile) > 0) {
+        Player_take(player);
+        Cards taken = player->turn.taken.cards[Pile_size(&player->turn.taken) - 1];
+        Play_addCards(&options, player->hand, taken, game->table.runs, game->table.sets);
+        STATS_COUNT(&search->stats, nodes[PHASE_TAKE]);
+        searchMeld(search, &options);
+    }
+    Game_unmakeTo(game, mark);
+    Turn_init(&player->turn);
+    if (search->top.k == 1 && search->best.eval != INT_MIN) {
+        TopTurns_add(&search->top, &search->best);
+    }
+
+    SearchStats *stats = &search->stats;
+    stats->nodes[PHASE_DISCARD] = search->nodes;
+    stats->calls[TIMER_FIND] = stats->nodes[PHASE_MELD];
+    stats->calls[TIMER_MOVEGEN] = stats->nodes[PHASE_MELD];
+    return finish(search);
+}
@@ -0,0 +1,57 @@
+#include "stats.h"
+
+const char *kPhaseName[PHASE_COUNT] = { "chance", "take", "meld", "discard" };
+const char *kTimerName[TIMER_COUNT] = { "find", "eval", "movegen" };
+
+void SearchStats_init(SearchStats *stats) {
+    *stats = (SearchStats){0};
+}
+
+void SearchStats_merge(SearchStats *total, const SearchStats *stats) {
+    for (int i = 0; i < PHASE_COUNT; ++i) {
+        total->nodes[i] += stats->nodes[i];
+    }
+    total->expanded += stats->expanded;
+    total->children += stats->children;
+    total->prunes += stats->prunes;
+    total->solver += stats->solver;
+    total->cacheProbes += stats->cacheProbes;
+    total->cacheHits += stats->cacheHits;
+    for (int i = 0; i < TIMER_COUNT; ++i) {
+        total->calls[i] += stats->calls[i];
+        total->sampled[i] += stats->sampled[i];
+        total->cycles[i] += stats->cycles[i];
+    }
+}
+
+uint64_t SearchStats_nodes(const SearchStats *stats) {
+    uint64_t nodes = stats->solver;
+    for (int i = 0; i < PHASE_COUNT; ++i) {
+        nodes += stats->nodes[i];
+    }
+    return nodes;
+}
+
+double SearchStats_branching(const SearchStats *stats) {
+    return stats->expanded ? (double)stats->children / (double)stats->expanded : 0.0;
+}
+
+double SearchStats_cyclesPerCall(const SearchStats *stats, StatsTimer timer) {
+    return stats->sampled[timer] ? (double)stats->cycles[timer] / (double)stats->sampled[timer] : 0.0;
+}
+
+void SearchStats_print(const SearchStats *stats, FILE *out) {
+    fprintf(out, "stats nodes %llu", (unsigned long long)SearchStats_nodes(stats));
+    for (int i = 0; i < PHASE_COUNT; ++i) {
+        fprintf(out, " %s %llu", kPhaseName[i], (unsigned long long)stats->nodes[i]);
+    }
+    fprintf(out, " solver %llu prunes %llu branching %.2f cache %llu/%llu\n",
+            (unsigned long long)stats->solver, (unsigned long long)stats->prunes, SearchStats_branching(stats),
+            (unsigned long long)stats->cacheHits, (unsigned long long)stats->cacheProbes);
+    fprintf(out, "stats cycles");
+    for (int i = 0; i < TIMER_COUNT; ++i) {
+        fprintf(out, " %s %llu@%.1f", kTimerName[i], (unsigned long long)stats->calls[i],
+                SearchStats_cyclesPerCall(stats, i));
+    }
+    fprintf(out, "\n");
+}
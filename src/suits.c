@@ -0,0 +1,191 @@
+#include <assert.h>
+#include "suits.h"
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#define SUITS_X86 1
+#else
+#define SUITS_X86 0
+#endif
+
+#define PACK_SUIT 0x1FFFULL                 // two to high ace of one suit
+#define NIBBLE_ONES 0x0011111111111111ULL   // bit 0 of 14 nibbles
+
+typedef struct SuitsOpsStruct {
+    uint64_t (*pack)(Cards cards);
+    Cards (*unpack)(uint64_t packed);
+    uint64_t (*transpose)(Cards cards);
+    Cards (*untranspose)(uint64_t transposed);
+} SuitsOps;
+
+// Portable versions: one suit at a time.
+
+static uint64_t packPortable(Cards cards) {
+    uint64_t packed = 0;
+    for (int suit = 0; suit < NUM_SUITS; ++suit) {
+        packed |= ((cards >> (16 * suit + 1)) & PACK_SUIT) << (13 * suit);
+    }
+    return packed;
+}
+
+static Cards unpackPortable(uint64_t packed) {
+    Cards cards = 0;
+    for (int suit = 0; suit < NUM_SUITS; ++suit) {
+        cards |= ((packed >> (13 * suit)) & PACK_SUIT) << (16 * suit + 1);
+    }
+    return cards;
+}
+
+// Moves bit i of a 14-bit field to bit 4 * i, and back.
+static inline uint64_t spreadNibbles(uint64_t x) {
+    x = (x | (x << 24)) & 0x000000FF000000FFULL;
+    x = (x | (x << 12)) & 0x000F000F000F000FULL;
+    x = (x | (x << 6)) & 0x0303030303030303ULL;
+    return (x | (x << 3)) & 0x1111111111111111ULL;
+}
+
+static inline uint64_t gatherNibbles(uint64_t x) {
+    x &= NIBBLE_ONES;
+    x = (x | (x >> 3)) & 0x0303030303030303ULL;
+    x = (x | (x >> 6)) & 0x000F000F000F000FULL;
+    x = (x | (x >> 12)) & 0x000000FF000000FFULL;
+    return (x | (x >> 24)) & SUIT_MASK;
+}
+
+static uint64_t transposePortable(Cards cards) {
+    uint64_t transposed = 0;
+    for (int suit = 0; suit < NUM_SUITS; ++suit) {
+        transposed |= spreadNibbles(Cards_suit(cards, suit)) << suit;
+    }
+    return transposed;
+}
+
+static Cards untransposePortable(uint64_t transposed) {
+    Cards cards = 0;
+    for (int suit = 0; suit < NUM_SUITS; ++suit) {
+        cards |= Cards_fromSuit(gatherNibbles(transposed >> suit), suit);
+    }
+    return cards;
+}
+
+static const SuitsOps portable = {
+    packPortable, unpackPortable, transposePortable, untransposePortable
+};
+
+#if SUITS_X86
+
+#define BMI2_TARGET __attribute__((target("bmi2")))
+
+BMI2_TARGET static uint64_t packBmi2(Cards cards) {
+    return _pext_u64(cards, FULL_DECK);
+}
+
+BMI2_TARGET static Cards unpackBmi2(uint64_t packed) {
+    return _pdep_u64(packed, FULL_DECK);
+}
+
+BMI2_TARGET static uint64_t transposeBmi2(Cards cards) {
+    uint64_t transposed = 0;
+    for (int suit = 0; suit < NUM_SUITS; ++suit) {
+        transposed |= _pdep_u64(Cards_suit(cards, suit), NIBBLE_ONES) << suit;
+    }
+    return transposed;
+}
+
+BMI2_TARGET static Cards untransposeBmi2(uint64_t transposed) {
+    Cards cards = 0;
+    for (int suit = 0; suit < NUM_SUITS; ++suit) {
+        cards |= (Cards)_pext_u64(transposed, NIBBLE_ONES << suit) << (16 * suit);
+    }
+    return cards;
+}
+
+static const SuitsOps bmi2 = {
+    packBmi2, unpackBmi2, transposeBmi2, untransposeBmi2
+};
+
+// Zen and Zen 2 implement PEXT and PDEP in microcode, hundreds of cycles
+// each, so they take the portable path.
+static bool fastBmi2(void) {
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("bmi2") &&
+           !__builtin_cpu_is("znver1") && !__builtin_cpu_is("znver2");
+}
+
+#else
+
+static bool fastBmi2(void) {
+    return false;
+}
+
+#endif // SUITS_X86
+
+static const SuitsOps *ops = &portable;
+
+__attribute__((constructor))
+static void Suits_select(void) {
+    Suits_useBmi2(true);
+}
+
+bool Suits_bmi2(void) {
+    return ops != &portable;
+}
+
+void Suits_useBmi2(bool use) {
+#if SUITS_X86
+    ops = use && fastBmi2() ? &bmi2 : &portable;
+#else
+    (void)use;
+#endif
+}
+
+uint64_t Cards_pack(Cards cards) {
+    return ops->pack(cards);
+}
+
+Cards Cards_unpack(uint64_t packed) {
+    return ops->unpack(packed);
+}
+
+uint64_t Cards_transpose(Cards cards) {
+    return ops->transpose(cards);
+}
+
+Cards Cards_untranspose(uint64_t transposed) {
+    return ops->untranspose(transposed);
+}
+
+Cards Cards_permuteSuits(Cards cards, const uint8_t perm[NUM_SUITS]) {
+    Cards permuted = 0;
+    for (int suit = 0; suit < NUM_SUITS; ++suit) {
+        permuted |= Cards_fromSuit(Cards_suit(cards, suit), perm[suit]);
+    }
+    return permuted;
+}
+
+void Cards_canonicalSuits(const Cards *cards, int n, uint8_t perm[NUM_SUITS]) {
+    assert(n >= 0 && n <= 4);
+    uint64_t keys[NUM_SUITS];
+    int order[NUM_SUITS];
+    for (int suit = 0; suit < NUM_SUITS; ++suit) {
+        uint64_t key = 0;
+        for (int i = 0; i < n; ++i) {
+            key = (key << 14) | Cards_suit(cards[i], suit);
+        }
+        keys[suit] = key;
+        order[suit] = suit;
+    }
+
+    // Insertion sort, highest key first; stable, so ties keep suit order.
+    for (int i = 1; i < NUM_SUITS; ++i) {
+        int suit = order[i];
+        int j = i;
+        for (; j > 0 && keys[order[j - 1]] < keys[suit]; --j) {
+            order[j] = order[j - 1];
+        }
+        order[j] = suit;
+    }
+    for (int i = 0; i < NUM_SUITS; ++i) {
+        perm[order[i]] = (uint8_t)i;
+    }
+}
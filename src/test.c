@@ -1,10 +1,49 @@
 #include <assert.h>
+#include <limits.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
 
+#include "analyze.h"
+#include "arena.h"
+#include "book.h"
 #include "cards.h"
+#include "cards2.h"
+#include "endgame.h"
+#include "lookahead.h"
 #include "pile.h"
 #include "table.h"
 #include "game.h"
+#include "eval.h"
+#include "evalcache.h"
+#include "search.h"
+#include "protocol.h"
+#include "batch.h"
+#include "histogram.h"
+#include "kernels.h"
+#include "model.h"
+#include "play.h"
+#include "plan.h"
+#include "position.h"
+#include "potential.h"
+#include "random.h"
+#include "record.h"
+#include "rumbot.h"
+#include "suits.h"
+#include "trace.h"
+#include "ttable.h"
+
+// Random cards from the deck, each kept with the given chance in 64.
+static Cards randomCards(Random *random, int chance) {
+    Cards cards = 0;
+    for (Cards c = Cards_low(FULL_DECK); c != 0; c = Cards_next(FULL_DECK, c)) {
+        if ((int)Random_uniform(random, 64) < chance) {
+            cards |= c;
+        }
+    }
+    return cards;
+}
 
 void Cards_test(void) {
     puts("Testing Cards...");
@@ -30,6 +69,54 @@ void Cards_test(void) {
     Cards_print(cards);
     printf("\n");
     assert(Cards_points(cards) == 85);
+
+    // Two decks: a card can be held twice, the second copy in its own layer.
+    Cards2 two = {0, 0};
+    Cards2_add(&two, Cards_fromString("5D 6D 7D AS"));
+    Cards2_add(&two, Cards_fromString("5D 6D 7D 5C 5H"));
+    assert(Cards2_isLegal(two) && Cards2_size(two) == 9);
+    assert(Cards2_count(two, Cards_toCard(Cards_fromString("5D"))) == 2);
+    assert(Cards2_count(two, Cards_toCard(Cards_fromString("AS"))) == 1);
+    assert(Cards2_count(two, Cards_toCard(Cards_fromString("KS"))) == 0);
+    assert(Cards2_points(two) == Cards_points(two.one) + Cards_points(two.two) && Cards2_points(two) == 55);
+    // The run twice over, the set of fives once.
+    Cards2 centers = Cards2_runCenters(two);
+    assert(centers.one == Cards_fromString("6D") && centers.two == Cards_fromString("6D"));
+    centers = Cards2_setCenters(two);
+    assert(centers.one == Cards_fromString("5D") && centers.two == 0);
+    // Overlapping runs take second copies of the cards they share.
+    Cards2 runs = { Cards_fromString("5H 6H 7H 8H"), Cards_fromString("6H 7H") };
+    assert(Cards2_runCenters(runs).two == Cards_fromString("6H 7H"));
+    runs = (Cards2){ Cards_fromString("5H 6H 7H 8H 9H"), Cards_fromString("7H") };
+    assert(Cards2_runCenters(runs).two == Cards_fromString("6H 8H"));
+    runs = (Cards2){ Cards_fromString("5H 6H 7H 8H"), Cards_fromString("6H") };
+    assert(Cards2_runCenters(runs).one == Cards_fromString("6H 7H") && Cards2_runCenters(runs).two == 0);
+    runs = (Cards2){ Cards_fromString("5H 6H 7H 9H TH JH"), 0 };
+    assert(Cards2_runCenters(runs).one == Cards_fromString("6H TH") && Cards2_runCenters(runs).two == 0);
+    // Two sets of one value hold six of its cards, no suit twice in a set.
+    Cards2 sets = { Cards_fromString("5C 5D 5H 5S"), Cards_fromString("5C 5D") };
+    assert(Cards2_setCenters(sets).two == sets.one);
+    sets = (Cards2){ Cards_fromString("5C 5D 5H 8C 8D 8H 8S"), Cards_fromString("5C 5D 5H 8C") };
+    assert(Cards2_setCenters(sets).two == Cards_fromString("5D"));
+    Cards2_remove(&two, Cards_fromString("5D AS"));
+    assert(Cards2_count(two, Cards_toCard(Cards_fromString("5D"))) == 1 && !Cards2_has(two, Cards_fromString("AS")));
+    Cards2_remove(&two, Cards_fromString("5D"));
+    assert(!Cards2_has(two, Cards_fromString("5D")) && Cards2_size(two) == 6);
+    Cards2 more = {Cards_fromString("5C KS"), 0};
+    Cards2 sum = Cards2_union(two, more);
+    assert(Cards2_isLegal(sum) && sum.two == Cards_fromString("5C 6D 7D") && Cards2_size(sum) == 8);
+    assert(!Cards2_isLegal((Cards2){0, Cards_fromString("KS")}));
+
+    // Malformed and repeated cards are refused, not aborted on.
+    assert(Cards_parse("", &cards) && cards == 0);
+    assert(Cards_parse("AS aS", &cards) && cards == ((1ULL << 61) | (1ULL << 48)));
+    assert(!Cards_parse("AS  KS", &cards));
+    assert(!Cards_parse("1C", &cards));
+    assert(!Cards_parse("KX", &cards));
+    assert(!Cards_parse("KS KS", &cards));
+    assert(!Cards_parse("KS ", &cards));
+    assert(!Cards_parse("K", &cards));
+    assert(Cards_fromString("ZZ") == 0);
 }
 
 void Pile_test(void) {
@@ -86,17 +173,95 @@ void Table_test(void) {
     assert(table.sets == 0);
 }
 
+// Picks one card of cards at random, or 0 if there is none.
+static Cards randomCard(Random *random, Cards cards) {
+    int n = Cards_size(cards);
+    if (n == 0) {
+        return 0;
+    }
+    int skip = (int)Random_uniform(random, n);
+    Cards c = Cards_low(cards);
+    while (skip-- > 0) {
+        c = Cards_next(cards, c);
+    }
+    return c;
+}
+
+void Play_test(void) {
+    puts("Testing Play...");
+    // Random walks of melds, discards and takes: the options kept up to
+    // date step by step always equal those found from scratch.
+    Random random;
+    Random_seed(&random, 9);
+    for (int walk = 0; walk < 200; ++walk) {
+        Cards hand = randomCards(&random, 20), runs = 0, sets = 0;
+        Play play, found;
+        Play_findHand(&play, hand, runs, sets);
+        for (int step = 0; step < 30; ++step) {
+            Play_findHand(&found, hand, runs, sets);
+            Cards outside = FULL_DECK & ~hand & ~Cards_toHighAces(runs) & ~sets;
+            Cards c;
+            switch (Random_uniform(&random, 6)) {
+            case 0:
+                c = randomCard(&random, found.runCenters);
+                if (c != 0) {
+                    hand &= ~Play_runCenterToMeld(c);
+                    runs |= Play_runCenterToMeld(c);
+                    Play_meldRun(&play, hand, Play_runCenterToMeld(c));
+                }
+                break;
+            case 1:
+                c = randomCard(&random, found.setCenters);
+                if (c != 0) {
+                    hand &= ~Play_setCenterToMeld(c);
+                    sets |= Play_setCenterToMeld(c);
+                    Play_meldSet(&play, hand, Play_setCenterToMeld(c));
+                }
+                break;
+            case 2:
+                c = randomCard(&random, found.runExtensions);
+                if (c != 0) {
+                    hand &= ~Cards_toHighAces(c);
+                    runs |= c;
+                    Play_meldRun(&play, hand, c);
+                }
+                break;
+            case 3:
+                c = randomCard(&random, found.setExtensions);
+                if (c != 0) {
+                    hand &= ~c;
+                    sets |= c;
+                    Play_meldSet(&play, hand, c);
+                }
+                break;
+            case 4:
+                c = randomCard(&random, hand);
+                hand &= ~c;
+                Play_removeCards(&play, c);
+                break;
+            default:
+                c = randomCard(&random, outside);
+                hand |= c;
+                Play_addCards(&play, hand, c, runs, sets);
+                break;
+            }
+            Play_findHand(&found, hand, runs, sets);
+            assert(Play_equal(&play, &found));
+        }
+    }
+}
+
 void Game_test(void) {
     puts("Testing Game...");
     Game game;
     Game_init(&game);
-    assert(game.numPlayers == NUM_PLAYERS);
+    assert(game.numPlayers == DEFAULT_PLAYERS);
     assert(game.currentPlayer == 0);
-    assert(Pile_size(&game.drawPile) == 52 - NUM_PLAYERS * 7 - 1);
+    assert(Pile_size(&game.drawPile) == 52 - DEFAULT_PLAYERS * 7 - 1);
     assert(Pile_size(&game.discardPile) == 1);
     assert(game.table.runs == 0);
     assert(game.table.sets == 0);
-    assert(game.discarded == 0);
+    assert(game.discarded == game.discardPile.cards[0]);
     for (int i = 0; i < game.numPlayers; ++i) {
         Player *player = Game_player(&game, i);
         assert(player->game == &game);
@@ -104,14 +269,1763 @@ void Game_test(void) {
         assert(player->score == 0);
         assert(Cards_size(player->hand) == 7);
     }
+    assert(Game_mark(&game) == 0);
     Game_print(&game);
+
+    // Any number of players can be dealt; the same seed deals the same
+    // cards to the first seats.
+    Game other;
+    for (int n = MIN_PLAYERS; n <= MAX_PLAYERS; ++n) {
+        Game_deal(&other, n, 5);
+        assert(other.numPlayers == n && Game_validate(&other) == NULL);
+        assert(Pile_size(&other.drawPile) == 52 - n * 7 - 1);
+        for (int i = 0; i < n; ++i) {
+            assert(other.players[i].game == &other && Cards_size(other.players[i].hand) == 7);
+        }
+    }
+    Game_initSeeded(&game, 5);
+    Game_deal(&other, MAX_PLAYERS, 5);
+    assert(other.players[0].hand == game.players[0].hand);
+
+    // Every move goes into the journal and unmaking them, in any number,
+    // restores the position exactly.
+    Game_clear(&game);
+    Player *p0 = Game_player(&game, 0), *p1 = Game_player(&game, 1);
+    p0->hand = Cards_fromString("5H 5D 5S 6H 7H 9C");
+    p0->known = Cards_fromString("8H");   // taken once before, then thrown
+    p1->hand = Cards_fromString("9H KD");
+    Pile_push(&game.drawPile, Cards_fromString("2D"));
+    Pile_push(&game.discardPile, Cards_fromString("8H"));
+    game.discarded = Cards_fromString("8H");
+    Game saved = game;
+
+    int mark = Game_mark(&game);
+    Player_take(p0);
+    Player_playRun(p0, Cards_fromString("6H 7H 8H"));
+    Player_playSet(p0, Cards_fromString("5H 5D 5S"));
+    Player_discard(p0, Cards_fromString("9C"));
+    Game_nextTurn(&game);
+    int turn = Game_mark(&game);
+    Player_draw(p1);
+    Player_playRun(p1, Cards_fromString("9H"));
+    assert(Game_mark(&game) == mark + 7);
+    assert(p0->score == 30 && p1->score == 5 && game.currentPlayer == 1);
+
+    Game_unmake(&game);
+    assert(p1->hand == Cards_fromString("9H KD 2D") && p1->score == 0);
+    assert(game.table.runs == Cards_fromString("6H 7H 8H"));
+    Game_unmakeTo(&game, turn);
+    assert(p1->hand == saved.players[1].hand && Pile_size(&game.drawPile) == 1);
+    Game_unmakeTo(&game, mark);
+    assert(game.currentPlayer == 0);
+    for (int i = 0; i < game.numPlayers; ++i) {
+        assert(game.players[i].hand == saved.players[i].hand);
+        assert(game.players[i].known == saved.players[i].known);
+        assert(game.players[i].score == saved.players[i].score);
+    }
+    assert(game.table.runs == 0 && game.table.sets == 0);
+    assert(Pile_size(&game.discardPile) == 1 && game.discarded == saved.discarded);
+    assert(Pile_size(&p0->turn.taken) == 0 && p0->turn.discard == 0);
+}
+
+void Eval_test(void) {
+    puts("Testing Eval...");
+    Game game;
+    Game_init(&game);
+
+    Player *player = Game_player(&game, 0);
+    player->score = 100;
+    player->hand = Cards_fromString("3H QC AC");
+
+    // Eval is 100 points played + 30 / 2 for points in hand + 1 for KC,
+    // which would make QC KC AC
+    assert(Eval_evaluate(&game) == 100 + (5 + 10 + 15) / 2 + 1);
+
+    // Eval is 100 points played + 7 points per rival card in hand
+    player->hand = 0;
+    assert(Eval_evaluate(&game) == 100 + 7 * 7);
+
+    // Every discard, best first, as discarding and evaluating would rank them.
+    player->hand = Cards_fromString("3H QC AC 4D");
+    Discard top[5];
+    assert(Eval_discards(&game, top, 5) == 4);
+    Cards expected[4] = {Cards_fromString("4D"), Cards_fromString("3H"),
+                         Cards_fromString("QC"), Cards_fromString("AC")};
+    for (int i = 0; i < 4; ++i) {
+        assert(top[i].card == expected[i]);
+        Player_discard(player, top[i].card);
+        assert(top[i].eval == Eval_evaluate(&game));
+        Game_unmake(&game);
+    }
+    assert(Eval_discards(&game, top, 2) == 2 && top[1].card == expected[1]);
+
+    // Discarding the last card goes out.
+    player->hand = Cards_fromString("KD");
+    assert(Eval_discards(&game, top, 5) == 1 && top[0].eval == 100 + 7 * 7);
+
+    // Cards that lay off on the table or complete a meld with what the
+    // next player took or can take from the discard pile are dangerous.
+    Cards pool = Cards_fromString("JC QC 2S 3S KD KH");
+    Cards runs = Cards_fromString("5H 6H 7H"), sets = Cards_fromString("9C 9D 9S");
+    assert(Play_danger(pool, runs, sets) ==
+           Cards_fromString("TC KC 4H 8H 9H KS AS 4S"));
+
+    Game_clear(&game);
+    game.table.runs = runs;
+    Player *next = Game_player(&game, 1);
+    next->hand = Cards_fromString("JC QC 5D");
+    Pile_push(&game.discardPile, Cards_fromString("JC"));
+    Pile_push(&game.discardPile, Cards_fromString("QC"));
+    game.discarded = Cards_fromString("JC QC");
+    Player_take(next);
+    Player_take(next);
+    assert(next->known == Cards_fromString("JC QC") && game.discarded == 0);
+    player->hand = Cards_fromString("8H KC 2D");
+    assert(Eval_danger(&game) == Cards_fromString("TC KC 4H 8H"));
+    assert(Eval_discards(&game, top, 3) == 3);
+    assert(top[0].card == Cards_fromString("2D") && top[2].card == Cards_fromString("KC"));
+    for (int i = 0; i < 3; ++i) {
+        Player_discard(player, top[i].card);
+        assert(top[i].eval == Eval_evaluate(&game));
+        Game_unmake(&game);
+    }
+}
+
+// Sets up a fixed position: player 0 holds a run, a set and a loose card.
+static void searchPosition(Game *game) {
+    Game_clear(game);
+    game->players[0].hand = Cards_fromString("8C 9C TC 2H 2D 2S 4C");
+    game->players[1].hand = Cards_fromString("3D 4D 7H 8H JS QS KD");
+    game->players[2].hand = Cards_fromString("5S 6S 9D TD 3H AH 6C");
+    Pile_push(&game->drawPile, Cards_fromString("7D"));
+    Pile_push(&game->discardPile, Cards_fromString("KS"));
+}
+
+void Potential_test(void) {
+    puts("Testing Potential...");
+    assert(Potential_outs(Cards_fromString("5H 7H"), 0) == 1);
+    assert(Potential_outs(Cards_fromString("5H 6H"), 0) == 2);
+    assert(Potential_outs(Cards_fromString("5H 6H"), Cards_fromString("7H")) == 1);
+    assert(Potential_outs(Cards_fromString("9C 9D"), 0) == 2);
+    assert(Potential_outs(Cards_fromString("9C 9D"), Cards_fromString("9S")) == 1);
+    // A low ace on the table is the same card as the high ace.
+    assert(Potential_outs(Cards_fromString("2H 3H"), 0) == 2);
+    assert(Potential_outs(Cards_fromString("2H 3H"), Cards_fromString("aH")) == 1);
+    assert(Potential_outs(Cards_fromString("AS AD"), Cards_fromString("aH")) == 1);
+    assert(Potential_outs(Cards_fromString("QC AC"), 0) == 1);
+
+    // Scoring every discard at once agrees with discarding and evaluating.
+    Random random;
+    Random_seed(&random, 5);
+    for (int i = 0; i < 200; ++i) {
+        Game game;
+        Game_init(&game);
+        Player *player = Game_player(&game, 0);
+        for (int p = 1; p < game.numPlayers; ++p) {
+            Player *rival = Game_player(&game, p);
+            rival->known = rival->hand & randomCards(&random, 16);
+            Player_discard(rival, Cards_low(rival->hand));
+        }
+        Player_draw(player);
+        Discard top[8];
+        int n = Eval_discards(&game, top, 8);
+        assert(n == 8);
+        for (int j = 0; j < n; ++j) {
+            assert(j == 0 || top[j - 1].eval >= top[j].eval);
+            Player_discard(player, top[j].card);
+            assert(top[j].eval == Eval_evaluate(&game));
+            Game_unmake(&game);
+        }
+    }
+}
+
+void Model_test(void) {
+    puts("Testing Model...");
+    Model model;
+    Model_init(&model);
+    Evaluator evaluator;
+    Model_evaluator(&model, &evaluator);
+
+    // With no weights, the model evaluates to the score.
+    Game game;
+    searchPosition(&game);
+    game.players[0].score = 12;
+    assert(evaluator.evaluate(&evaluator, &game) == 12);
+
+    // Scoring every discard at once agrees with discarding and evaluating.
+    Random random;
+    Random_seed(&random, 3);
+    for (int i = 0; i < MODEL_INPUTS; ++i) {
+        model.weights[i] = (int8_t)(Random_uniform(&random, 255) - 127);
+    }
+    model.bias = 40;
+    model.scale = 100;
+    for (int i = 0; i < 100; ++i) {
+        Game_initSeeded(&game, i);
+        Player *player = Game_currentPlayer(&game);
+        Player *next = Game_player(&game, 1);
+        next->known = next->hand & randomCards(&random, 32);
+        if (i % 10 == 0) {
+            player->hand = Cards_low(player->hand);   // goes out
+        } else {
+            Player_draw(player);
+        }
+        Discard top[8];
+        int n = Model_discards(&model, &game, top, 8);
+        assert(n == Cards_size(player->hand) || n == 8);
+        for (int j = 0; j < n; ++j) {
+            assert(j == 0 || top[j - 1].eval >= top[j].eval);
+            Player_discard(player, top[j].card);
+            assert(top[j].eval == Model_evaluate(&model, &game));
+            Game_unmake(&game);
+        }
+    }
+
+    // Save and load round trip; garbage is refused.
+    char *text = NULL;
+    size_t size = 0;
+    FILE *out = open_memstream(&text, &size);
+    Model_save(&model, out);
+    fclose(out);
+    Model loaded;
+    FILE *in = fmemopen(text, size, "r");
+    assert(Model_load(&loaded, in));
+    fclose(in);
+    assert(memcmp(loaded.weights, model.weights, sizeof(model.weights)) == 0);
+    assert(loaded.bias == model.bias && loaded.scale == model.scale);
+    in = fmemopen("rumbot-model 2", 14, "r");
+    assert(!Model_load(&loaded, in));
+    fclose(in);
+    free(text);
+
+    // The search runs with the model in place of the hand-tuned evaluation.
+    searchPosition(&game);
+    Search search;
+    SearchLimits limits;
+    Search_init(&search);
+    SearchLimits_init(&limits);
+    search.evaluator = &evaluator;
+    Search_start(&search, &game, &limits);
+    Search_run(&search);
+    assert(search.best.eval != INT_MIN && search.nodes > 0);
+}
+
+void Search_test(void) {
+    puts("Testing Search...");
+    Game game;
+    searchPosition(&game);
+    Cards hand = game.players[0].hand;
+
+    Search search;
+    SearchLimits limits;
+    Search_init(&search);
+    SearchLimits_init(&limits);
+    Search_start(&search, &game, &limits);
+    int eval = Search_run(&search);
+    Turn_print(&search.best);
+
+    // Melding 8C 9C TC and the three twos and discarding 4C goes out.
+    assert(eval == (5 + 5 + 10) + (5 + 5 + 5) + 7 * 7);
+    assert(Pile_size(&search.best.taken) == 0);
+    assert(search.best.meld.runs == Cards_fromString("8C 9C TC"));
+    assert(search.best.meld.sets == Cards_fromString("2D 2H 2S"));
+    assert(search.best.discard == Cards_fromString("4C"));
+    assert(search.nodes > 0);
+
+    // One draw, one take (of KS, which cannot be melded and is pruned).
+    SearchStats *stats = &search.stats;
+    assert(stats->nodes[PHASE_CHANCE] == 1);
+    assert(stats->nodes[PHASE_TAKE] == 1);
+    assert(stats->nodes[PHASE_DISCARD] == search.nodes);
+    assert(stats->nodes[PHASE_MELD] > 0 && stats->expanded > 0);
+    assert(stats->prunes > 0);
+    assert(SearchStats_branching(stats) > 1.0);
+    // Each discard node scores its whole hand with one call.
+    assert(stats->calls[TIMER_EVAL] > 0 && stats->calls[TIMER_EVAL] < search.nodes);
+    assert(stats->sampled[TIMER_EVAL] >= 1);
+
+    SearchStats total;
+    SearchStats_init(&total);
+    SearchStats_merge(&total, stats);
+    SearchStats_merge(&total, stats);
+    assert(SearchStats_nodes(&total) == 2 * SearchStats_nodes(stats));
+    SearchStats_print(&total, stdout);
+
+    // The position is left exactly as it was found.
+    assert(game.players[0].hand == hand);
+    assert(game.players[0].score == 0);
+    assert(game.table.runs == 0 && game.table.sets == 0);
+    assert(Pile_size(&game.discardPile) == 1);
+
+    // A node limit stops the search after the discard node that reaches it.
+    limits.nodes = 1;
+    Search_start(&search, &game, &limits);
+    Search_run(&search);
+    assert(search.nodes >= 1 && search.nodes <= 8);
+    assert(game.players[0].hand == hand);
+
+    // Six players take their turns in order and the cards stay consistent.
+    Game_deal(&game, MAX_PLAYERS, 3);
+    limits.nodes = 0;
+    for (int turn = 0; turn < 2 * MAX_PLAYERS && Pile_size(&game.drawPile) > 0; ++turn) {
+        int mover = game.currentPlayer;
+        assert(mover == turn % MAX_PLAYERS);
+        Search_start(&search, &game, &limits);
+        Search_run(&search);
+        assert(search.best.eval != INT_MIN);
+        Game_play(&game, &search.best);
+        assert(Game_validate(&game) == NULL);
+        if (game.players[mover].hand == 0) {
+            break;
+        }
+    }
+}
+
+static bool sameTurn(const Turn *a, const Turn *b) {
+    return a->taken.size == b->taken.size && a->meld.runs == b->meld.runs && a->meld.sets == b->meld.sets &&
+           a->discard == b->discard && a->eval == b->eval;
+}
+
+void TopTurns_test(void) {
+    puts("Testing TopTurns...");
+    TopTurns top;
+    TopTurns_init(&top, 3);
+    Pile discardPile;
+    Pile_init(&discardPile);
+    Pile_push(&discardPile, Cards_fromString("KS"));
+    Turn turn, sorted[TURN_MAX_TOP];
+    Turn_init(&turn);
+    int evals[] = { 5, 9, 7, 9, 1, 8 };
+    for (int i = 0; i < 6; ++i) {
+        turn.discard = 1ULL << i;
+        turn.eval = evals[i];
+        TopTurns_add(&top, &turn);
+    }
+    // The same turn again is not kept twice.
+    turn.discard = 1ULL << 1;
+    turn.eval = 9;
+    TopTurns_add(&top, &turn);
+    assert(TopTurns_sorted(&top, &discardPile, sorted) == 3);
+    assert(sorted[0].eval == 9 && sorted[0].discard == 1ULL << 1);
+    assert(sorted[1].eval == 9 && sorted[1].discard == 1ULL << 3);
+    assert(sorted[2].eval == 8 && sorted[2].discard == 1ULL << 5);
+    assert(!TopTurns_admits(&top, 8) && TopTurns_admits(&top, 10));
+
+    // Taken cards come back off the discard pile.
+    TopTurns_init(&top, 0);
+    assert(top.k == 1);
+    Pile_push(&turn.taken, Cards_fromString("KS"));
+    TopTurns_add(&top, &turn);
+    assert(TopTurns_sorted(&top, &discardPile, sorted) == 1);
+    assert(sorted[0].taken.size == 1 && sorted[0].taken.cards[0] == Cards_fromString("KS"));
+
+    // The best turns come from the same search, which is no larger for
+    // them; the best three are the first three of the best five.
+    Search search[3];
+    SearchLimits limits;
+    SearchLimits_init(&limits);
+    for (int i = 0; i < 3; ++i) {
+        Search_init(&search[i]);
+        search[i].multiPV = 1 + 2 * i;
+    }
+    for (uint64_t seed = 0; seed < 20; ++seed) {
+        Game game;
+        Game_initSeeded(&game, seed);
+        for (int t = 0; t < 8 && Pile_size(&game.drawPile) > 0; ++t) {
+            Turn found[3][TURN_MAX_TOP];
+            int n[3];
+            for (int i = 0; i < 3; ++i) {
+                Search_start(&search[i], &game, &limits);
+                Search_run(&search[i]);
+                n[i] = TopTurns_sorted(&search[i].top, &game.discardPile, found[i]);
+                assert(search[i].nodes == search[0].nodes);
+                assert(n[i] >= 1 && n[i] <= search[i].multiPV);
+                assert(sameTurn(&found[i][0], &search[0].best));
+            }
+            for (int j = 1; j < n[2]; ++j) {
+                assert(found[2][j].eval <= found[2][j - 1].eval);
+                for (int other = 0; other < j; ++other) {
+                    assert(!sameTurn(&found[2][j], &found[2][other]));
+                }
+            }
+            for (int j = 0; j < n[1]; ++j) {
+                assert(sameTurn(&found[1][j], &found[2][j]));
+            }
+            if (search[0].best.eval == INT_MIN) {
+                break;
+            }
+            Game_play(&game, &search[0].best);
+        }
+    }
+}
+
+void Record_test(void) {
+    puts("Testing Record...");
+    char path[] = "/tmp/rumbot-record-XXXXXX";
+    int fd = mkstemp(path);
+    assert(fd >= 0);
+    FILE *out = fdopen(fd, "wb");
+
+    // Record a few games with a small node limit, keeping the final states.
+    enum { GAMES = 5 };
+    Game played[GAMES];
+    static RecordWriter writer;
+    RecordWriter_init(&writer, out);
+    Search search;
+    SearchLimits limits;
+    Search_init(&search);
+    SearchLimits_init(&limits);
+    limits.nodes = 200;
+    for (int g = 0; g < GAMES; ++g) {
+        Game *game = &played[g];
+        Game_initSeeded(game, 100 + g);
+        RecordWriter_game(&writer, 100 + g, game->numPlayers, limits.nodes);
+        for (int t = 0; t < 12 && Pile_size(&game->drawPile) > 0; ++t) {
+            int mover = game->currentPlayer;
+            Search_start(&search, game, &limits);
+            Search_run(&search);
+            if (search.best.eval == INT_MIN) {
+                break;
+            }
+            Game_play(game, &search.best);
+            RecordWriter_turn(&writer, mover, &game->players[mover].turn);
+        }
+    }
+    assert(RecordWriter_flush(&writer));
+    fclose(out);
+    assert(writer.games == GAMES);
+
+    // Replaying the records reaches the same positions.
+    RecordReader reader;
+    assert(RecordReader_open(&reader, path) == NULL);
+    assert(reader.count == GAMES + writer.turns);
+    RecordGame record;
+    Game game;
+    int games = 0;
+    while (RecordReader_nextGame(&reader, &record)) {
+        assert(record.start->game.seed == (uint64_t)(100 + games));
+        assert(Record_replay(&record, &game) == NULL);
+        for (int p = 0; p < game.numPlayers; ++p) {
+            assert(game.players[p].hand == played[games].players[p].hand);
+            assert(game.players[p].score == played[games].players[p].score);
+        }
+        assert(game.table.runs == played[games].table.runs);
+        assert(game.discarded == played[games].discarded);
+
+        // A turn that cannot be played is refused, not played.
+        Record turns[64];
+        memcpy(turns, record.turns, record.numTurns * sizeof(Record));
+        RecordGame bad = record;
+        bad.turns = turns;
+        turns[0].discard = 15;
+        assert(strcmp(Record_replay(&bad, &game), "bad card") == 0);
+        turns[0].discard = RECORD_NO_CARD;
+        Game_initSeeded(&game, record.start->game.seed);
+        turns[0].turn.sets = game.drawPile.cards[0];   // not in hand
+        assert(strcmp(Record_replay(&bad, &game), "bad meld") == 0);
+        games++;
+    }
+    assert(games == GAMES);
+    RecordReader_close(&reader);
+
+    // Anything but a record file is refused.
+    out = fopen(path, "wb");
+    fputs("rumbot-model 1\nbias 0\nscale 256\nweights\n", out);
+    fclose(out);
+    assert(strcmp(RecordReader_open(&reader, path), "not a record file") == 0);
+    unlink(path);
+}
+
+void Position_test(void) {
+    puts("Testing Position...");
+    // Formatting and parsing are inverses.
+    Game game, parsed;
+    char text[POSITION_MAX], again[POSITION_MAX];
+    for (int seed = 0; seed < 50; ++seed) {
+        Game_deal(&game, MIN_PLAYERS + seed % (MAX_PLAYERS - MIN_PLAYERS + 1), seed);
+        Player *player = Game_currentPlayer(&game);
+        player->score = seed - 25;
+        Player_take(player);
+        Player_discard(player, Cards_low(player->hand));
+        int length = Position_format(&game, text);
+        assert(length == (int)strlen(text) && length < POSITION_MAX);
+        assert(Position_parse(&parsed, text, NULL) == NULL);
+        assert(parsed.numPlayers == game.numPlayers);
+        Position_format(&parsed, again);
+        assert(strcmp(text, again) == 0);
+        assert(parsed.players[0].known == game.players[0].known);
+        assert(parsed.discarded == game.discarded);
+        assert(Pile_size(&parsed.drawPile) == Pile_size(&game.drawPile));
+    }
+
+    const char *good = "8C9CTC2H2D2S4C/3D4D7H8HJSQSKD/5S6S9DTD3HAH6C 7D KS aCAS2C - 0/-5/0 1 -/-/-\n";
+    assert(Position_parse(&parsed, good, NULL) == NULL);
+    assert(parsed.players[1].score == -5 && parsed.currentPlayer == 1);
+    assert(parsed.table.runs == Cards_fromString("aC AS 2C"));
+
+    // Each error is reported with where it was found.
+    static const struct {
+        const char *text;
+        const char *error;
+        int column;
+    } kBad[] = {
+        { "", "bad cards", 0 },
+        { "8C/-/- - - - - 0/0/0", "missing field", 20 },
+        { "8C/-/-/-/-/-/- - - - - 0/0/0/0/0/0/0 0", "too many players", 13 },
+        { "8C - - - - 0 0", "too few players", 2 },
+        { "8C/- - - - - 0/0/0 0", "wrong number of scores", 18 },
+        { "8C9/-/- - - - - 0/0/0 0", "bad cards", 0 },
+        { "8C/-/- 8X - - - 0/0/0 0", "bad cards", 7 },
+        { "8C/-/- - 8D8D - - 0/0/0 0", "bad cards", 9 },
+        { "8C/-/- - - - - 0/0/z 0", "bad score", 19 },
+        { "8C/-/- - - - - 0/0 0", "wrong number of scores", 18 },
+        { "8C/-/- - - - - 0/0/0 3", "bad player to move", 21 },
+        { "8C/-/- - - - - 0/0/0 0 -/-", "wrong number of known hands", 26 },
+        { "8C/-/- - - - - 0/0/0 0 -/-/- x", "unexpected text", 29 },
+        { "8C/8C/- - - - - 0/0/0 0", "card in two places", 0 },
+        { "aC/-/- - - - - 0/0/0 0", "illegal card", 0 },
+        { "8C/-/- - - - - 0/40000/0 0", "score out of range", 0 },
+    };
+    for (size_t i = 0; i < sizeof(kBad) / sizeof(kBad[0]); ++i) {
+        int column = -1;
+        const char *error = Position_parse(&parsed, kBad[i].text, &column);
+        printf("%-40s %s at %d\n", kBad[i].text, error ? error : "(none)", column);
+        assert(error && strcmp(error, kBad[i].error) == 0);
+        assert(column == kBad[i].column);
+    }
+}
+
+// Analyzes the text and returns the output.
+static char *analyzeText(const char *text, int threads, int window, AnalyzeTotals *totals) {
+    char *output = NULL;
+    size_t size = 0;
+    FILE *in = fmemopen((void *)text, strlen(text), "r");
+    FILE *out = open_memstream(&output, &size);
+    AnalyzeOptions options;
+    AnalyzeOptions_init(&options);
+    options.threads = threads;
+    options.window = window;
+    options.limits.nodes = 500;
+    assert(Analyze_run(in, out, &options, totals));
+    fclose(in);
+    fclose(out);
+    return output;
+}
+
+void Analyze_test(void) {
+    puts("Testing Analyze...");
+    // Every line gets its answer, in order, however many threads search.
+    char *text = NULL;
+    size_t size = 0;
+    FILE *corpus = open_memstream(&text, &size);
+    Game game;
+    char line[POSITION_MAX];
+    for (int seed = 0; seed < 200; ++seed) {
+        Game_initSeeded(&game, seed);
+        Position_format(&game, line);
+        fprintf(corpus, "%s\n", seed == 7 ? "8C/8C/- - - - - 0/0/0 0" : line);
+    }
+    fclose(corpus);
+
+    AnalyzeTotals totals;
+    char *one = analyzeText(text, 1, 1, &totals);
+    assert(totals.positions == 200 && totals.errors == 1);
+    uint64_t nodes = totals.nodes;
+    char *many = analyzeText(text, 4, 5, &totals);
+    assert(strcmp(one, many) == 0);
+    assert(totals.positions == 200 && totals.errors == 1 && totals.nodes == nodes);
+    assert(totals.stats.nodes[PHASE_DISCARD] == nodes);
+
+    // The first answer is the search's own.
+    Search search;
+    SearchLimits limits;
+    Search_init(&search);
+    SearchLimits_init(&limits);
+    limits.nodes = 500;
+    Game_initSeeded(&game, 0);
+    Search_start(&search, &game, &limits);
+    Search_run(&search);
+    char turn[TURN_FORMAT_MAX], expected[TURN_FORMAT_MAX + 64];
+    Turn_format(&search.best, turn);
+    sprintf(expected, "bestmove %s nodes %llu\n", turn, (unsigned long long)search.nodes);
+    assert(strncmp(one, expected, strlen(expected)) == 0);
+    // Line 8 is the bad one.
+    const char *p = one;
+    for (int i = 0; i < 7; ++i) {
+        p = strchr(p, '\n') + 1;
+    }
+    assert(strncmp(p, "error card in two places at column 0\n", 37) == 0);
+
+    free(one);
+    free(many);
+    free(text);
+    one = analyzeText("", 2, 2, &totals);
+    assert(strcmp(one, "") == 0 && totals.positions == 0);
+    free(one);
+}
+
+static int compareKeys(const void *a, const void *b) {
+    uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+    return x < y ? -1 : x > y;
+}
+
+// Checks the turn could be played: the melds come from the hand and what
+// was taken, which holds the discard, and a taken card is melded.
+static void checkBookTurn(Game *game, const Turn *turn) {
+    Cards up = game->discardPile.cards[0];
+    Cards hand = Game_currentPlayer(game)->hand | (turn->taken.size > 0 ? up : 0);
+    Cards melded = Cards_toHighAces(turn->meld.runs) | turn->meld.sets;
+    assert(Cards_has(hand, melded) && (Cards_toHighAces(turn->meld.runs) & turn->meld.sets) == 0);
+    assert(turn->discard == 0 || Cards_has(hand & ~melded, turn->discard));
+    assert(turn->taken.size == 0 || Cards_has(melded, up));
+}
+
+void Book_test(void) {
+    puts("Testing Book...");
+    // The cursor starts from the lowest hand, 2C to 8C with the 9C up, and
+    // hands out canonical keys in increasing order.
+    BookCursor cursor;
+    BookCursor_init(&cursor);
+    uint64_t key, last;
+    uint8_t perm[NUM_SUITS];
+    Game game;
+    Search search;
+    Search_init(&search);
+    assert(BookCursor_next(&cursor, &key));
+    assert(key == (0x7FULL << 6 | 7));
+    for (int i = 0; i < 100000; ++i) {
+        last = key;
+        assert(BookCursor_next(&cursor, &key) && key > last);
+        if (i % 1000 == 0) {
+            BookEntry entry;
+            Book_solve(&search, &game, DEFAULT_PLAYERS, key, &entry);
+            uint64_t again;
+            assert(Book_key(&game, &again, perm) && again == key && entry.key == key);
+        }
+    }
+
+    // Solve the first turns of some deals into a book.
+    enum { DEALS = 100 };
+    uint64_t keys[DEALS];
+    for (int g = 0; g < DEALS; ++g) {
+        Game_initSeeded(&game, g);
+        assert(Book_key(&game, &keys[g], perm));
+    }
+    qsort(keys, DEALS, sizeof(uint64_t), compareKeys);
+    char path[] = "/tmp/rumbot-book-XXXXXX";
+    int fd = mkstemp(path);
+    assert(fd >= 0);
+    FILE *out = fdopen(fd, "wb");
+    BookHeader header;
+    BookHeader_init(&header, DEFAULT_PLAYERS, DEALS);
+    fwrite(&header, sizeof(header), 1, out);
+    for (int i = 0; i < DEALS; ++i) {
+        BookEntry entry;
+        Book_solve(&search, &game, DEFAULT_PLAYERS, keys[i], &entry);
+        fwrite(&entry, sizeof(entry), 1, out);
+    }
+    assert(fclose(out) == 0);
+
+    Book book;
+    assert(Book_open(&book, path) == NULL);
+    assert(book.count == DEALS && book.numPlayers == DEFAULT_PLAYERS);
+    SearchLimits limits;
+    SearchLimits_init(&limits);
+    for (int g = 0; g < DEALS; ++g) {
+        // The book's turn is as good as the search's, and playable.
+        Turn turn;
+        Game_initSeeded(&game, g);
+        assert(Book_probe(&book, &game, &turn));
+        checkBookTurn(&game, &turn);
+        Search_start(&search, &game, &limits);
+        Search_run(&search);
+        assert(search.nodes > 0 && turn.eval == search.best.eval);
+
+        // With the book, the search only looks it up, and the decision is
+        // recorded like any other.
+        DecisionHistograms histograms;
+        DecisionHistograms_init(&histograms);
+        search.book = &book;
+        search.histograms = &histograms;
+        Search_start(&search, &game, &limits);
+        Search_run(&search);
+        assert(search.nodes == 0 && search.best.eval == turn.eval);
+        assert(search.best.meld.runs == turn.meld.runs && search.best.discard == turn.discard);
+        assert(Histogram_count(&histograms.metrics[DECISION_TIME_NS]) == 1);
+        assert(Histogram_count(&histograms.metrics[DECISION_NODES]) == 1);
+        assert(Histogram_count(&histograms.metrics[DECISION_FIRST_MOVE_NS]) == 1);
+        assert(search.firstMoveNs > 0 && search.firstMoveNs <= search.elapsedNs);
+        search.book = NULL;
+        search.histograms = NULL;
+
+        // Renaming the suits renames the turn.
+        static const uint8_t rename[NUM_SUITS] = {2, 0, 3, 1};
+        Game renamed;
+        Game_copy(&renamed, &game);
+        for (int p = 0; p < game.numPlayers; ++p) {
+            renamed.players[p].hand = Cards_permuteSuits(game.players[p].hand, rename);
+        }
+        for (int i = 0; i < Pile_size(&game.drawPile); ++i) {
+            renamed.drawPile.cards[i] = Cards_permuteSuits(game.drawPile.cards[i], rename);
+        }
+        renamed.discardPile.cards[0] = Cards_permuteSuits(game.discardPile.cards[0], rename);
+        Turn other;
+        assert(Book_probe(&book, &renamed, &other));
+        assert(other.eval == turn.eval && other.taken.size == turn.taken.size);
+        assert(other.meld.runs == Cards_permuteSuits(turn.meld.runs, rename));
+        assert(other.meld.sets == Cards_permuteSuits(turn.meld.sets, rename));
+        assert(other.discard == Cards_permuteSuits(turn.discard, rename));
+
+        // Only the first turn is in the book.
+        Game_play(&game, &turn);
+        assert(!Book_probe(&book, &game, &turn));
+    }
+    Game_initSeeded(&game, 1000);
+    Turn turn;
+    assert(!Book_probe(&book, &game, &turn));
+    Book_close(&book);
+
+    assert(strcmp(Book_open(&book, "/nonexistent/book"), "cannot open file") == 0);
+    out = fopen(path, "wb");
+    fputs("not a book, but long enough to have a header", out);
+    fclose(out);
+    assert(strcmp(Book_open(&book, path), "not a book file") == 0);
+    unlink(path);
+}
+
+void Plan_test(void) {
+    puts("Testing Plan...");
+    Game game;
+    searchPosition(&game);
+    PlanList list;
+    PlanList_init(&list);
+    assert(PlanList_generate(&list, &game));
+    Cards hand = game.players[0].hand;
+    Cards top = game.drawPile.cards[Pile_size(&game.drawPile) - 1];
+
+    // Every plan plays, and is unmade, leaving the game as it was.  The
+    // turn the search finds, 8C 9C TC and the three twos with 4C thrown,
+    // is among them.
+    bool found = false;
+    for (int i = 0; i < list.size; ++i) {
+        Plan *plan = &list.plans[i];
+        assert(plan->points == Cards_points(plan->runs) + Cards_points(plan->sets));
+        assert(plan->taken == 0);   // KS cannot be melded
+        int mark = Game_mark(&game);
+        Plan_make(&game, plan);
+        assert(game.currentPlayer == 1);
+        assert(game.players[0].score == plan->points);
+        found |= plan->runs == Cards_fromString("8C 9C TC") &&
+                 plan->sets == Cards_fromString("2D 2H 2S") && plan->discard == Cards_fromString("4C");
+        Game_unmakeTo(&game, mark);
+        assert(game.players[0].hand == hand && game.currentPlayer == 0);
+        assert(game.drawPile.cards[Pile_size(&game.drawPile) - 1] == top);
+    }
+    assert(found);
+    Turn turn;
+    Plan_toTurn(&list.plans[0], &game, &turn);
+    assert(turn.draw == top && Pile_size(&turn.taken) == 0);
+
+    // Every discard of every meld combination: with nothing to meld, one
+    // plan per card in hand after the draw, and one per card after a take.
+    Game_clear(&game);
+    game.players[0].hand = Cards_fromString("2C 5D 9H");
+    Pile_push(&game.drawPile, Cards_fromString("KS"));
+    Pile_push(&game.discardPile, Cards_fromString("7C"));
+    assert(PlanList_generate(&list, &game));
+    assert(list.size == 4);
+    game.players[0].hand = Cards_fromString("5C 6C 9H");
+    assert(PlanList_generate(&list, &game));
+    // Draw: no meld, 4 discards.  Take 7C: meld 5C 6C 7C, discard 9H.
+    assert(list.size == 5);
+    assert(list.plans[4].taken == 1 && list.plans[4].discard == Cards_fromString("9H"));
+    assert(list.plans[4].runs == Cards_fromString("5C 6C 7C") && list.plans[4].points == 15);
+    PlanList_free(&list);
+}
+
+// The paranoid value by brute force, for checking the endgame solver.
+static int paranoidValue(Game *game, int root) {
+    int stake = -Cards_points(game->players[root].hand);
+    if (Pile_size(&game->drawPile) == 0) {
+        return stake;
+    }
+    PlanList list;
+    PlanList_init(&list);
+    assert(PlanList_generate(&list, game));
+    int mover = game->currentPlayer;
+    int best = list.size > 0 ? (mover == root ? INT_MIN : INT_MAX) : stake;
+    for (int i = 0; i < list.size; ++i) {
+        int mark = Game_mark(game);
+        int gain = mover == root ? list.plans[i].points : 0;
+        Plan_make(game, &list.plans[i]);
+        int value = gain + (game->players[mover].hand == 0 ? -Cards_points(game->players[root].hand)
+                                                           : paranoidValue(game, root));
+        Game_unmakeTo(game, mark);
+        best = mover == root ? (value > best ? value : best) : (value < best ? value : best);
+    }
+    PlanList_free(&list);
+    return best;
+}
+
+// Plays a seeded game with a small search until the stock is down to
+// stock cards.  Returns false if the game ends first.
+static bool playToStock(Game *game, uint64_t seed, int stock) {
+    Search search;
+    SearchLimits limits;
+    Search_init(&search);
+    SearchLimits_init(&limits);
+    limits.nodes = 200;
+    Game_initSeeded(game, seed);
+    while (Pile_size(&game->drawPile) > stock) {
+        Search_start(&search, game, &limits);
+        Search_run(&search);
+        if (search.best.eval == INT_MIN) {
+            return false;
+        }
+        int mover = game->currentPlayer;
+        Game_play(game, &search.best);
+        if (game->players[mover].hand == 0) {
+            return false;
+        }
+    }
+    return Pile_size(&game->drawPile) == stock;
+}
+
+void Endgame_test(void) {
+    puts("Testing Endgame...");
+    Endgame endgame;
+    assert(Endgame_init(&endgame, 2, 12));
+    Game game;
+    int solved = 0;
+    for (uint64_t seed = 0; solved < 6 && seed < 400; ++seed) {
+        if (!playToStock(&game, seed, 1 + seed % 2)) {
+            continue;
+        }
+        assert(Endgame_applies(&endgame, &game));
+        int mover = game.currentPlayer;
+        int score = game.players[mover].score;
+        Cards hand = game.players[mover].hand;
+
+        // The solver's value is the brute-force one, and its turn earns it.
+        int gain;
+        Turn turn;
+        assert(Endgame_solve(&endgame, &game, &gain, &turn));
+        assert(gain == paranoidValue(&game, mover));
+        assert(turn.eval == score + gain);
+        assert(game.players[mover].hand == hand && game.currentPlayer == mover);
+        uint64_t nodes = endgame.nodes;
+
+        // Solved again, the answer comes from the table.
+        int again;
+        Turn same;
+        assert(Endgame_solve(&endgame, &game, &again, &same));
+        assert(again == gain && same.eval == turn.eval && endgame.hits > 0);
+        assert(endgame.nodes <= nodes);
+
+        // The search hands over to the solver.
+        Search search;
+        SearchLimits limits;
+        Search_init(&search);
+        SearchLimits_init(&limits);
+        DecisionHistograms histograms;
+        DecisionHistograms_init(&histograms);
+        search.endgame = &endgame;
+        search.histograms = &histograms;
+        Search_start(&search, &game, &limits);
+        assert(Search_run(&search) == turn.eval);
+        assert(search.stats.solver == endgame.nodes && SearchStats_nodes(&search.stats) == endgame.nodes);
+        assert(Histogram_count(&histograms.metrics[DECISION_NODES]) == 1);
+
+        // The turn is worth what was promised, whatever the rivals do.
+        Game_play(&game, &turn);
+        int gained = game.players[mover].score - score;
+        if (game.players[mover].hand == 0 || Pile_size(&game.drawPile) == 0) {
+            assert(gained - Cards_points(game.players[mover].hand) == gain);
+        } else {
+            assert(gained + paranoidValue(&game, mover) >= gain);
+        }
+        solved++;
+    }
+    assert(solved == 6);
+
+    // Limits give up rather than answer.
+    Endgame_clear(&endgame);
+    endgame.maxNodes = 1;
+    int gain;
+    Turn turn;
+    assert(!Endgame_solve(&endgame, &game, &gain, &turn) || endgame.nodes <= 1);
+    Endgame_free(&endgame);
+}
+
+// Plain max-n or minimax, depth turns deep: every player's value with
+// max-n, values[root] with paranoid.
+static void lookaheadValues(Game *game, int depth, Backup backup, int root, int values[MAX_PLAYERS]) {
+    int numPlayers = game->numPlayers;
+    if (Pile_size(&game->drawPile) == 0 || depth == 0) {
+        int mover = game->currentPlayer;
+        for (int p = 0; p < numPlayers; ++p) {
+            game->currentPlayer = p;
+            values[p] = depth == 0 && Pile_size(&game->drawPile) > 0
+                            ? Eval_evaluate(game)
+                            : game->players[p].score - Cards_points(game->players[p].hand);
+        }
+        game->currentPlayer = mover;
+        return;
+    }
+    PlanList list;
+    PlanList_init(&list);
+    assert(PlanList_generate(&list, game) && list.size > 0);
+    PlanList_sort(&list);
+    int mover = game->currentPlayer;
+    int chooser = backup == BACKUP_MAXN ? mover : root;
+    bool maximizing = backup == BACKUP_MAXN || mover == root;
+    for (int i = 0; i < list.size; ++i) {
+        int mark = Game_mark(game);
+        int child[MAX_PLAYERS];
+        Plan_make(game, &list.plans[i]);
+        lookaheadValues(game, game->players[mover].hand == 0 ? 0 : depth - 1, backup, root, child);
+        if (game->players[mover].hand == 0) {
+            for (int p = 0; p < numPlayers; ++p) {
+                child[p] = game->players[p].score - Cards_points(game->players[p].hand);
+            }
+        }
+        Game_unmakeTo(game, mark);
+        if (i == 0 || (maximizing ? child[chooser] > values[chooser] : child[chooser] < values[chooser])) {
+            memcpy(values, child, sizeof(child));
+        }
+    }
+    PlanList_free(&list);
+}
+
+void Lookahead_test(void) {
+    puts("Testing Lookahead...");
+    Lookahead lookahead;
+    assert(Lookahead_init(&lookahead, BACKUP_MAXN, 1, 12, false));
+    Game game;
+    int searched = 0;
+    for (uint64_t seed = 0; searched < 6 && seed < 100; ++seed) {
+        if (!playToStock(&game, seed, 20 - (int)(seed % 8))) {
+            continue;
+        }
+        int mover = game.currentPlayer;
+        Cards hand = game.players[mover].hand;
+        lookahead.maxNodes = 0;
+        lookahead.stop = NULL;
+        for (int backup = BACKUP_MAXN; backup <= BACKUP_PARANOID; ++backup) {
+            for (int depth = 1; depth <= 3; ++depth) {
+                // Deepened with the table, cut with alpha-beta, the values
+                // are the plain ones.
+                lookahead.backup = (Backup)backup;
+                lookahead.maxDepth = depth;
+                int values[MAX_PLAYERS], expected[MAX_PLAYERS];
+                Turn turn;
+                assert(Lookahead_search(&lookahead, &game, values, &turn));
+                assert(lookahead.depth == depth);
+                assert(game.players[mover].hand == hand && game.currentPlayer == mover);
+                lookaheadValues(&game, depth, (Backup)backup, mover, expected);
+                assert(values[mover] == expected[mover] && turn.eval == expected[mover]);
+                for (int p = 0; backup == BACKUP_MAXN && p < game.numPlayers; ++p) {
+                    assert(values[p] == expected[p]);
+                }
+            }
+            assert(lookahead.probes > 0 && lookahead.hits > 0);
+            assert(backup == BACKUP_MAXN || lookahead.cutoffs > 0);
+            Lookahead_clear(&lookahead);
+        }
+
+        // The search hands over, and a node limit stops the deepening
+        // with the answer of the last depth completed.
+        Search search;
+        SearchLimits limits;
+        Search_init(&search);
+        SearchLimits_init(&limits);
+        limits.nodes = 400;
+        lookahead.maxDepth = LOOKAHEAD_MAX_DEPTH;
+        DecisionHistograms histograms;
+        DecisionHistograms_init(&histograms);
+        search.lookahead = &lookahead;
+        search.histograms = &histograms;
+        Search_start(&search, &game, &limits);
+        int eval = Search_run(&search);
+        assert(lookahead.depth >= 1 && lookahead.depth < LOOKAHEAD_MAX_DEPTH);
+        assert(search.stats.solver == lookahead.nodes);
+        assert(Histogram_count(&histograms.metrics[DECISION_TIME_NS]) == 1);
+        int expected[MAX_PLAYERS];
+        lookaheadValues(&game, lookahead.depth, BACKUP_PARANOID, mover, expected);
+        assert(eval == expected[mover] && search.nodes == lookahead.nodes);
+        searched++;
+    }
+    assert(searched == 6);
+
+    Backup backup;
+    assert(Backup_parse("maxn", &backup) && backup == BACKUP_MAXN);
+    assert(Backup_parse(Backup_name(BACKUP_PARANOID), &backup) && backup == BACKUP_PARANOID);
+    assert(!Backup_parse("max-n", &backup));
+    Lookahead_free(&lookahead);
+}
+
+// Runs a script of protocol commands and returns everything the engine said.
+static char *sessionScript(const char *script) {
+    char *output = NULL;
+    size_t size = 0;
+    FILE *in = fmemopen((void *)script, strlen(script), "r");
+    FILE *out = open_memstream(&output, &size);
+    Search search;
+    Search_init(&search);
+    Engine engine;
+    Engine_init(&engine, &search);
+    Session session;
+    Session_init(&session, &engine, in, out);
+    Session_run(&session);
+    Session_destroy(&session);
+    Engine_destroy(&engine);
+    fclose(in);
+    fclose(out);
+    return output;
+}
+
+// Searches the game and returns the best evaluation; the stats are left in
+// search.
+static int cachedSearch(Search *search, Game *game, int bits) {
+    SearchLimits limits;
+    SearchLimits_init(&limits);
+    EvalCache_setBits(bits);
+    Search_start(search, game, &limits);
+    return Search_run(search);
+}
+
+void EvalCache_test(void) {
+    puts("Testing EvalCache...");
+    Game game;
+    Search search;
+    Search_init(&search);
+    for (int seed = 0; seed < 20; ++seed) {
+        Game_initSeeded(&game, seed);
+        int eval = cachedSearch(&search, &game, 0);
+        Turn best = search.best;
+        uint64_t nodes = search.nodes, calls = search.stats.calls[TIMER_EVAL];
+        assert(search.stats.cacheProbes == 0);
+
+        // The cache changes how often the evaluator is called, not the result.
+        EvalCache_invalidate();
+        assert(cachedSearch(&search, &game, 10) == eval);
+        assert(search.best.discard == best.discard && search.best.meld.runs == best.meld.runs);
+        assert(search.best.meld.sets == best.meld.sets && search.best.taken.size == best.taken.size);
+        assert(search.nodes == nodes);
+        SearchStats *stats = &search.stats;
+        assert(stats->cacheProbes > 0 && stats->cacheHits < stats->cacheProbes);
+        assert(stats->calls[TIMER_EVAL] == calls - stats->cacheHits);
+
+        // The same search again finds every discard node cached.
+        assert(cachedSearch(&search, &game, 10) == eval);
+        assert(stats->cacheHits == stats->cacheProbes);
+    }
+
+    // A change to the evaluator is seen once the cache is invalidated.
+    Model model;
+    Model_init(&model);
+    Evaluator evaluator;
+    Model_evaluator(&model, &evaluator);
+    search.evaluator = &evaluator;
+    Game_initSeeded(&game, 1);
+    int before = cachedSearch(&search, &game, 10);
+    model.bias = 1000;
+    assert(cachedSearch(&search, &game, 10) == before);
+    EvalCache_invalidate();
+    assert(cachedSearch(&search, &game, 10) == cachedSearch(&search, &game, 0));
+    assert(search.best.eval != before);
+
+    // An engine runs every search on one thread, so a position searched
+    // again, by the next session, finds the cache the first search left.
+    char *output = NULL;
+    size_t size = 0;
+    FILE *out = open_memstream(&output, &size);
+    Search_init(&search);
+    Engine engine;
+    Engine_init(&engine, &search);
+    EvalCache_setBits(10);
+    Game_initSeeded(&game, 3);
+    for (int i = 0; i < 2; ++i) {
+        Session session;
+        Session_init(&session, &engine, stdin, out);
+        char command[POSITION_MAX + 16];
+        strcpy(command, "position ");
+        Position_format(&game, command + strlen(command));
+        Session_command(&session, command);
+        strcpy(command, "go");
+        Session_command(&session, command);
+        bool running = true;
+        while (running) {
+            usleep(1000);
+            pthread_mutex_lock(&session.lock);
+            running = session.running;
+            pthread_mutex_unlock(&session.lock);
+        }
+        Session_destroy(&session);
+    }
+    assert(search.stats.cacheProbes > 0 && search.stats.cacheHits == search.stats.cacheProbes);
+    Engine_destroy(&engine);
+    fclose(out);
+    free(output);
+    EvalCache_setBits(EVALCACHE_DEFAULT_BITS);
+}
+
+void Protocol_test(void) {
+    puts("Testing Protocol...");
+    char *output = sessionScript(
+        "rumbot\n"
+        "clear\n"
+        "hand 0 8C9CTC2H2D2S4C\n"
+        "hand 1 3D4D7H8HJSQSKD\n"
+        "hand 2 5S6S9DTD3HAH6C\n"
+        "drawpile 7D\n"
+        "discardpile KS\n"
+        "hand 9 -\n"
+        "hand 1 ZZ\n"
+        "score 0 40000\n"
+        "go\n"
+        "stats\n");
+    printf("%s", output);
+    assert(strstr(output, "rumbotok\n"));
+    // The stats line has the fields of the documented format, in its order.
+    unsigned long long counts[9];
+    double branching;
+    assert(sscanf(strstr(output, "stats nodes "),
+                  "stats nodes %llu chance %llu take %llu meld %llu discard %llu solver %llu "
+                  "prunes %llu branching %lf cache %llu/%llu",
+                  &counts[0], &counts[1], &counts[2], &counts[3], &counts[4], &counts[5],
+                  &counts[6], &branching, &counts[7], &counts[8]) == 10);
+    assert(strstr(output, "error bad player 9\n"));
+    assert(strstr(output, "error bad cards ZZ\n"));
+    assert(strstr(output, "error bad score 40000\n"));
+    assert(strstr(output, "bestmove draw runs 8C9CTC sets 2D2H2S discard 4C eval 84\n"));
+    free(output);
+
+    output = sessionScript(
+        "clear\n"
+        "hand 0 8C9CTC\n"
+        "hand 1 8C\n"
+        "go\n"
+        "hand 1 -\n"
+        "known 1 8C\n"
+        "tomove 2\n"
+        "show\n"
+        "go\n");
+    printf("%s", output);
+    assert(strstr(output, "error card in two places\n"));
+    assert(strstr(output, "bestmove none\n"));
+    assert(strstr(output, "known 1 8C\n"));
+    assert(strstr(output, "tomove 2\nposition 8C9CTC/-/- - - - - 0/0/0 2 -/8C/-\nend\n"));
+    free(output);
+
+    output = sessionScript(
+        "position 8C9CTC/-/- 7D KS - - 0/0/0 x\n"
+        "position 8C9CTC2H2D2S4C/3D4D7H8HJSQSKD/5S6S9DTD3HAH6C 7D KS - - 0/0/0 0\n"
+        "show\n"
+        "multipv 3\n"
+        "go\n");
+    printf("%s", output);
+    assert(strstr(output, "error bad player to move at column 27\n"));
+    assert(strstr(output, "hand 1 3D4DKD7H8HJSQS\n"));
+    assert(strstr(output, "info multipv 1 draw runs 8C9CTC sets 2D2H2S discard 4C eval 84\n"
+                          "info multipv 2 draw runs 8C9CTC sets - discard 2D eval 29\n"
+                          "info multipv 3 draw runs 8C9CTC sets - discard 2H eval 29\n"));
+    assert(strstr(output, "bestmove draw runs 8C9CTC sets 2D2H2S discard 4C eval 84\n"));
+    free(output);
+
+    // An engine that outlives its session keeps the tables made for it, but
+    // not its settings, for the next one.
+    Search search;
+    Search_init(&search);
+    Engine engine;
+    Engine_init(&engine, &search);
+    const char *settings = "multipv 3\nendgame 2\nlookahead 2\n";
+    FILE *in = fmemopen((void *)settings, strlen(settings), "r");
+    Session session;
+    Session_init(&session, &engine, in, stdout);
+    Session_run(&session);
+    Session_destroy(&session);
+    fclose(in);
+    assert(search.multiPV == 3 && search.endgame == engine.endgame && search.lookahead == engine.lookahead);
+    Session_init(&session, &engine, stdin, stdout);
+    assert(search.multiPV == 1 && search.top.k == 1);
+    assert(!search.endgame && !search.lookahead && engine.endgame && engine.lookahead);
+    Session_destroy(&session);
+    Engine_destroy(&engine);
+
+    // A default build traces every search at level info.
+    output = sessionScript("trace 2\nnewgame\ngo\n");
+    Trace_setLevel(TRACE_OFF);
+    printf("%s", output);
+    assert(strstr(output, "trace info search-start hand="));
+    assert(strstr(output, "trace info search-end nodes="));
+    free(output);
+
+    // The end of the input prints a pondered result rather than dropping it.
+    output = sessionScript("newgame\ngo ponder\n");
+    printf("%s", output);
+    assert(strstr(output, "bestmove "));
+    free(output);
+
+    // The endgame solver answers once the stock is small enough.
+    output = sessionScript(
+        "trace 2\n"
+        "endgame 2\n"
+        "position 4D5D8D9D/KC/3D 5H 2D 2C3C4C5C8C9CTCJCQCTDJDQDKD2H3H4H8H9HTHJHQHKH"
+        "2S3S4S5S8S9STSJSQSKS 6C7CAC6D7DAD6H7HAH6S7SAS 70/55/210 2\n"
+        "go\n");
+    printf("%s", output);
+    Trace_setLevel(TRACE_OFF);
+    assert(strstr(output, "trace info answer by=endgame eval=215\n"));
+    assert(strstr(output, "bestmove draw runs 5H sets - discard 3D eval 215\n"));
+    free(output);
+
+    // With the lookahead, the one card left in the stock ends the hand.
+    output = sessionScript(
+        "position 8C9CTC2H2D2S4C/3D4D7H8HJSQSKD/5S6S9DTD3HAH6C 7D KS - - 0/0/0 0\n"
+        "lookahead 3 minimax\n"
+        "lookahead 3 maxn\n"
+        "go\n");
+    printf("%s", output);
+    assert(strstr(output, "error unknown rule minimax\n"));
+    assert(strstr(output, "bestmove draw runs 8C9CTC sets 2D2H2S discard 4C eval 30\n"));
+    free(output);
+
+    // The player count sticks through clear and newgame.
+    output = sessionScript(
+        "players 7\n"
+        "players 5\n"
+        "hand 4 8C\n"
+        "clear\n"
+        "show\n"
+        "newgame\n"
+        "hand 5 -\n");
+    printf("%s", output);
+    assert(strstr(output, "error bad number of players 7\n"));
+    assert(strstr(output, "position -/-/-/-/- - - - - 0/0/0/0/0 0\n"));
+    assert(strstr(output, "error bad player 5\n"));
+    assert(!strstr(output, "error bad player 4\n"));
+    free(output);
+
+    // What show prints rebuilds the position, its player count included,
+    // in a session that starts with three.
+    output = sessionScript(
+        "players 5\n"
+        "hand 4 8C9CTC\n"
+        "score 2 30\n"
+        "drawpile 7D\n"
+        "tomove 3\n"
+        "show\n");
+    printf("%s", output);
+    assert(strstr(output, "players 5\nhand 0 -\n") == output);
+    char script[1024];
+    *strstr(output, "end\n") = '\0';
+    snprintf(script, sizeof(script), "%sshow\n", output);
+    char *again = sessionScript(script);
+    assert(strncmp(again, output, strlen(output)) == 0 && strcmp(again + strlen(output), "end\n") == 0);
+    free(again);
+    free(output);
+}
+
+void Rumbot_test(void) {
+    puts("Testing Rumbot...");
+    assert(Rumbot_apiVersion() == RUMBOT_API_VERSION);
+    Rumbot *rb = Rumbot_create();
+    assert(rb);
+
+    RumbotPosition position = {0};
+    position.numPlayers = 3;
+    position.toMove = 0;
+    position.hands[0] = Cards_fromString("8C 9C TC 2H 2D 2S 4C");
+    position.hands[1] = Cards_fromString("3D 4D 7H 8H JS QS KD");
+    position.hands[2] = Cards_fromString("5S 6S 9D TD 3H AH 6C");
+    position.drawPile[position.drawPileSize++] = Cards_toCard(Cards_fromString("7D"));
+    position.discardPile[position.discardPileSize++] = Cards_toCard(Cards_fromString("KS"));
+    assert(Rumbot_loadPosition(rb, &position) == RUMBOT_OK);
+
+    RumbotResult result;
+    assert(Rumbot_search(rb, NULL, &result) == RUMBOT_OK);
+    assert(result.take == 0);
+    assert(result.runs == Cards_fromString("8C 9C TC"));
+    assert(result.sets == Cards_fromString("2D 2H 2S"));
+    assert(result.discard == Cards_fromString("4C"));
+    assert(result.eval == 84);
+
+    RumbotStats stats;
+    Rumbot_stats(rb, &stats);
+    assert(stats.searches == 1);
+    assert(stats.nodes == stats.lastNodes && stats.nodes > 0);
+    assert(stats.phaseNodes[RUMBOT_PHASE_DISCARD] == stats.nodes);
+    assert(stats.timerCalls[RUMBOT_TIMER_EVAL] > 0 && stats.timerCalls[RUMBOT_TIMER_EVAL] < stats.nodes);
+
+    char report[4096];
+    int length = Rumbot_histograms(rb, RUMBOT_FORMAT_TEXT, report, sizeof(report));
+    assert(length > 0 && length < (int)sizeof(report));
+    printf("%s", report);
+    assert(strstr(report, "histogram decision_ns count 1 "));
+    assert(strstr(report, "histogram decision_nodes count 1 "));
+    length = Rumbot_histograms(rb, RUMBOT_FORMAT_JSON, report, 16);
+    assert(length > 16 && strlen(report) == 15 && report[0] == '{');
+
+    // A card in two hands is refused.
+    position.hands[1] |= Cards_fromString("8C");
+    assert(Rumbot_loadPosition(rb, &position) == RUMBOT_EINVAL);
+
+    // So is a player count out of range; four players, the fourth with an
+    // empty hand, are fine.
+    position.hands[1] &= ~Cards_fromString("8C");
+    position.numPlayers = RUMBOT_MAX_PLAYERS + 1;
+    assert(Rumbot_loadPosition(rb, &position) == RUMBOT_EINVAL);
+    position.numPlayers = 1;
+    assert(Rumbot_loadPosition(rb, &position) == RUMBOT_EINVAL);
+    position.numPlayers = 4;
+    assert(Rumbot_loadPosition(rb, &position) == RUMBOT_OK);
+    // And a score too big for the transposition tables.
+    position.scores[2] = 40000;
+    assert(Rumbot_loadPosition(rb, &position) == RUMBOT_EINVAL);
+    position.scores[2] = 0;
+
+    // With nothing to draw or take there is no legal turn.
+    position.numPlayers = 3;
+    position.drawPileSize = 0;
+    position.discardPileSize = 0;
+    assert(Rumbot_loadPosition(rb, &position) == RUMBOT_OK);
+    assert(Rumbot_search(rb, NULL, &result) == RUMBOT_ENOMOVE);
+
+    Rumbot_destroy(rb);
+}
+
+// Flushes the calling thread's trace ring and returns what was printed.
+static char *traceOutput(void) {
+    char *output = NULL;
+    size_t size = 0;
+    FILE *out = open_memstream(&output, &size);
+    Trace_flush(out);
+    fclose(out);
+    return output;
+}
+
+void Trace_test(void) {
+    puts("Testing Trace...");
+
+    // Nothing is recorded at run-time level off.
+    Trace_setLevel(TRACE_OFF);
+    TRACE(TRACE_ERROR, TRACE_EV_MESSAGE, 0, (uintptr_t)"hidden", 0, 0, 0);
+    char *output = traceOutput();
+    assert(output == NULL || strstr(output, "hidden") == NULL);
+    free(output);
+
+    Trace_setLevel(TRACE_LEAF);
+    TRACE(TRACE_INFO, TRACE_EV_MESSAGE, 0, (uintptr_t)"hello", 0, 0, 0);
+    TRACE(TRACE_LEAF, TRACE_EV_LEAF, 42, Cards_fromString("4C 5C"), 0, 0, Cards_fromString("KS"));
+    output = traceOutput();
+    printf("%s", output);
+    assert(strstr(output, "trace info message text=hello\n"));
+#if TRACE_LEVEL >= TRACE_LEAF
+    assert(strstr(output, "trace leaf leaf hand=4C5C runs=- sets=- discard=KS eval=42\n"));
+#else
+    // Leaf tracing was compiled out, so the run-time level cannot bring it back.
+    assert(strstr(output, "leaf") == NULL);
+#endif
+    free(output);
+
+    // A full ring keeps the newest records and says how many it dropped.
+    for (int i = 0; i < TRACE_RING_SIZE + 3; ++i) {
+        TRACE(TRACE_INFO, TRACE_EV_SEARCH_END, i, i, 0, 0, 0);
+    }
+    output = traceOutput();
+    assert(strstr(output, "trace dropped 3\n"));
+    assert(strstr(output, "nodes=3 ns=0 eval=3\n"));
+    assert(strstr(output, "nodes=2 ns=0 eval=2\n") == NULL);
+    free(output);
+    Trace_setLevel(TRACE_OFF);
+}
+
+void Histogram_test(void) {
+    puts("Testing Histogram...");
+
+    // Every value falls inside its bucket, and buckets tile the range.
+    uint64_t values[] = { 0, 1, 15, 16, 17, 31, 32, 1000, 123456789, 1ULL << 62, UINT64_MAX };
+    for (unsigned i = 0; i < sizeof(values) / sizeof(values[0]); ++i) {
+        int b = Histogram_bucket(values[i]);
+        assert(b >= 0 && b < HISTOGRAM_BUCKETS);
+        assert(Histogram_bucketLow(b) <= values[i] && values[i] <= Histogram_bucketHigh(b));
+    }
+    for (int b = 1; b < HISTOGRAM_BUCKETS; ++b) {
+        assert(Histogram_bucketLow(b) == Histogram_bucketHigh(b - 1) + 1);
+    }
+    assert(Histogram_bucket(UINT64_MAX) == HISTOGRAM_BUCKETS - 1);
+
+    // Percentiles are exact to within one eighth.
+    Histogram *h = malloc(sizeof(Histogram));
+    Histogram_init(h);
+    for (uint64_t v = 1; v <= 10000; ++v) {
+        Histogram_record(h, v);
+    }
+    assert(Histogram_count(h) == 10000);
+    uint64_t p50 = Histogram_percentile(h, 50.0);
+    uint64_t p99 = Histogram_percentile(h, 99.0);
+    assert(p50 >= 5000 && p50 <= 5000 + 5000 / 8);
+    assert(p99 >= 9900 && p99 <= 10000);
+    assert(Histogram_percentile(h, 100.0) == 10000);
+
+    Histogram *total = malloc(sizeof(Histogram));
+    Histogram_init(total);
+    Histogram_merge(total, h);
+    Histogram_merge(total, h);
+    assert(Histogram_count(total) == 20000);
+    assert(Histogram_percentile(total, 50.0) == p50);
+    Histogram_print(total, "test", stdout);
+    free(h);
+    free(total);
+}
+
+// Checks that every card of the deck is in exactly one place.
+static void checkBatchGame(Batch *batch, int i) {
+    Cards seen = 0, zone;
+    for (int p = 0; p < batch->numPlayers; ++p) {
+        zone = batch->hands[p][i];
+        assert((seen & zone) == 0);
+        seen |= zone;
+    }
+    zone = batch->runs[i] | batch->sets[i];
+    assert((seen & zone) == 0 && (batch->runs[i] & batch->sets[i]) == 0);
+    seen |= zone;
+    for (int j = 0; j < batch->discardSize[i]; ++j) {
+        zone = 1ULL << batch->discardPile[i * 52 + j];
+        assert((seen & zone) == 0);
+        seen |= zone;
+    }
+    for (int j = batch->drawn[i]; j < 52; ++j) {
+        zone = 1ULL << batch->deck[i * 52 + j];
+        assert((seen & zone) == 0);
+        seen |= zone;
+    }
+    assert(seen == FULL_DECK);
+}
+
+void Batch_test(void) {
+    puts("Testing Batch...");
+    Batch batch, again;
+    assert(Batch_init(&batch, 100));
+    assert(Batch_init(&again, 100));
+
+    Batch_deal(&batch, 1);
+    for (int i = 0; i < batch.size; ++i) {
+        checkBatchGame(&batch, i);
+        assert(Cards_size(batch.hands[0][i]) == 7 && batch.discardSize[i] == 1);
+    }
+    int64_t turns = Batch_run(&batch, 1000);
+    assert(turns > 0);
+    for (int i = 0; i < batch.size; ++i) {
+        assert(batch.done[i]);
+        checkBatchGame(&batch, i);
+    }
+
+    // The same seed plays the same games.
+    Batch_deal(&again, 1);
+    assert(Batch_run(&again, 1000) == turns);
+    for (int i = 0; i < batch.size; ++i) {
+        assert(again.scores[0][i] == batch.scores[0][i]);
+    }
+
+    // From the search test position, player 0 cannot use KS, so draws 7D,
+    // melds the run and the set, and throws 7D over 4C.
+    Game game;
+    searchPosition(&game);
+    Batch_setGame(&batch, 0, &game);
+    Batch_phaseDraw(&batch);
+    Batch_phaseMeld(&batch);
+    Batch_phaseDiscard(&batch);
+    assert(Batch_phaseEnd(&batch) >= 1);
+    assert(batch.scores[0][0] == 35);
+    assert(batch.hands[0][0] == Cards_fromString("4C"));
+    assert(batch.discardTop[0] == Cards_fromString("7D"));
+    assert(batch.current[0] == 1);
+
+    // Six players play out too.
+    Batch wide;
+    assert(Batch_initPlayers(&wide, 50, MAX_PLAYERS));
+    Batch_deal(&wide, 2);
+    assert(Batch_run(&wide, 1000) > 0);
+    for (int i = 0; i < wide.size; ++i) {
+        assert(wide.done[i]);
+        checkBatchGame(&wide, i);
+    }
+
+    Batch_free(&batch);
+    Batch_free(&again);
+    Batch_free(&wide);
+}
+
+void Kernels_test(void) {
+    puts("Testing Kernels...");
+    enum { N = 203 };  // not a multiple of any vector width
+    Cards hands[N], runs[N], sets[N];
+    Cards rc[N], re[N], sc[N], se[N];
+    int32_t sizes[N], points[N];
+    Random random;
+    Random_seed(&random, 7);
+    for (int i = 0; i < N; ++i) {
+        hands[i] = randomCards(&random, i % 64);
+        runs[i] = Cards_addLowAces(randomCards(&random, 16));
+        sets[i] = randomCards(&random, 16);
+    }
+    hands[0] = FULL_DECK;
+
+    KernelsLevel best = Kernels_level();
+    assert(Kernels_supported(KERNELS_SCALAR) && best == Kernels_best());
+    for (KernelsLevel level = KERNELS_SCALAR; level < KERNELS_COUNT; ++level) {
+        if (!Kernels_supported(level)) {
+            continue;
+        }
+        Kernels_use(level);
+        assert(Kernels_level() == level);
+        // Every length up to N, so every tail length is covered.
+        for (int n = 0; n <= N; n += (n < 20 ? 1 : 61)) {
+            memset(sizes, -1, sizeof(sizes));
+            memset(points, -1, sizeof(points));
+            Cards_sizeArray(hands, sizes, n);
+            Cards_pointsArray(hands, points, n);
+            Play_findArray(hands, runs, sets, rc, re, sc, se, n);
+            for (int i = 0; i < n; ++i) {
+                Play play;
+                Play_findHand(&play, hands[i], runs[i], sets[i]);
+                assert(sizes[i] == Cards_size(hands[i]));
+                assert(points[i] == Cards_points(hands[i]));
+                assert(rc[i] == play.runCenters && re[i] == play.runExtensions);
+                assert(sc[i] == play.setCenters && se[i] == play.setExtensions);
+            }
+            assert(n == N || sizes[n] == -1);
+        }
+
+        // Against the sum of the selected weights, one to four words.
+        int8_t weights[256];
+        for (int i = 0; i < 256; ++i) {
+            weights[i] = (int8_t)(i * 37 - 128);
+        }
+        for (int words = 1; words <= 4; ++words) {
+            uint64_t bits[4];
+            int32_t sum = 0;
+            for (int w = 0; w < words; ++w) {
+                bits[w] = hands[w] ^ (sets[w] << 7);
+                for (int i = 0; i < 64; ++i) {
+                    sum += ((bits[w] >> i) & 1) ? weights[64 * w + i] : 0;
+                }
+            }
+            assert(Kernels_dot(bits, weights, words) == sum);
+        }
+    }
+    Kernels_use(KERNELS_COUNT);  // ignored
+    Kernels_use(best);
+    assert(Kernels_level() == best);
+}
+
+void Suits_test(void) {
+    puts("Testing Suits...");
+    Cards hand = Cards_fromString("aC 3C 4C 5C 7D 7H 7S AS");
+    assert(Cards_suit(hand, 0) == 0x001D && Cards_fromSuit(0x001D, 0) == Cards_fromString("aC 3C 4C 5C"));
+    assert(Cards_valueSuits(hand, 6) == 0xE);
+    assert(Cards_fromValueSuits(0xE, 6) == Cards_fromString("7D 7H 7S"));
+
+    bool bmi2 = Suits_bmi2();
+    Random random;
+    Random_seed(&random, 11);
+    for (int pass = 0; pass < 2; ++pass) {
+        Suits_useBmi2(pass == 0);
+        assert(Cards_pack(Cards_fromString("2C")) == 1);
+        assert(Cards_pack(Cards_fromString("AS")) == 1ULL << 51);
+        assert(Cards_pack(hand) == (0x0EULL | (1ULL << 18) | (1ULL << 31) | (1ULL << 44) | (1ULL << 51)));
+        for (int i = 0; i < 1000; ++i) {
+            Cards cards = randomCards(&random, i % 64) | Cards_fromValueSuits(i & 0xF, 0);
+            assert(Cards_unpack(Cards_pack(cards)) == (cards & FULL_DECK));
+            uint64_t transposed = Cards_transpose(cards);
+            assert(Cards_untranspose(transposed) == cards);
+            for (int value = 0; value < 14; ++value) {
+                assert(((transposed >> (4 * value)) & 0xF) == Cards_valueSuits(cards, value));
+            }
+        }
+    }
+    Suits_useBmi2(bmi2);
+
+    // Renaming the suits of a hand and up-card leaves the canonical form.
+    Cards pair[2] = {hand, Cards_fromString("8H")};
+    uint8_t perm[NUM_SUITS], rename[NUM_SUITS] = {2, 0, 3, 1};
+    Cards_canonicalSuits(pair, 2, perm);
+    Cards canonical = Cards_permuteSuits(hand, perm);
+    Cards renamed[2] = {Cards_permuteSuits(pair[0], rename), Cards_permuteSuits(pair[1], rename)};
+    Cards_canonicalSuits(renamed, 2, perm);
+    assert(Cards_permuteSuits(renamed[0], perm) == canonical);
+    assert(canonical == Cards_fromString("aS 3S 4S 5S 7C 7D 7H AC"));
+}
+
+typedef struct TestNodeStruct {
+    ArenaNode link;
+    int32_t value;
+} TestNode;
+
+// Gives the node branching children, each with its parent's value times
+// ten plus its place, down depth levels.  Returns the nodes made.
+static uint32_t growTree(Arena *arena, ArenaIndex i, int branching, int depth) {
+    TestNode *node = Arena_node(arena, i);
+    node->link.children = ARENA_NULL;
+    node->link.numChildren = 0;
+    if (depth == 0) {
+        return 0;
+    }
+    ArenaIndex first = Arena_alloc(arena, branching);
+    assert(first != ARENA_NULL);
+    node = Arena_node(arena, i);
+    node->link.children = first;
+    node->link.numChildren = branching;
+    uint32_t made = branching;
+    for (int c = 0; c < branching; ++c) {
+        ((TestNode *)Arena_node(arena, first + c))->value = node->value * 10 + c + 1;
+        made += growTree(arena, first + c, branching, depth - 1);
+    }
+    return made;
+}
+
+// Checks the values below the node as growTree() left them.  Returns the
+// nodes found.
+static uint32_t checkTree(const Arena *arena, ArenaIndex i, int branching, int depth) {
+    const TestNode *node = Arena_node(arena, i);
+    assert(node->link.numChildren == (depth > 0 ? (uint32_t)branching : 0));
+    uint32_t found = node->link.numChildren;
+    for (uint32_t c = 0; c < node->link.numChildren; ++c) {
+        ArenaIndex child = node->link.children + c;
+        assert(child < arena->used);
+        assert(((const TestNode *)Arena_node(arena, child))->value == node->value * 10 + (int)c + 1);
+        found += checkTree(arena, child, branching, depth - 1);
+    }
+    return found;
+}
+
+void Arena_test(void) {
+    puts("Testing Arena...");
+    for (int huge = 0; huge <= 1; ++huge) {
+        Arena arena;
+        assert(Arena_init(&arena, sizeof(TestNode), 1 << 16, huge));
+        printf("huge pages asked %d, from the pool %d\n", huge, arena.hugeMapped);
+        assert(arena.used == 1);
+
+        // Four levels of four, then keep the subtree of the root's third
+        // child: its 1 + 4 + 16 + 64 nodes go to the front, in order.
+        ArenaIndex root = Arena_alloc(&arena, 1);
+        assert(root == 1);
+        ((TestNode *)Arena_node(&arena, root))->value = 0;
+        assert(growTree(&arena, root, 4, 4) == 4 + 16 + 64 + 256);
+        assert(checkTree(&arena, root, 4, 4) == 4 + 16 + 64 + 256);
+        ArenaIndex third = ((TestNode *)Arena_node(&arena, root))->link.children + 2;
+        root = Arena_keep(&arena, third);
+        assert(root == 1 && arena.used == 2 + 4 + 16 + 64);
+        assert(((TestNode *)Arena_node(&arena, root))->value == 3);
+        assert(checkTree(&arena, root, 4, 3) == 4 + 16 + 64);
+        assert(((TestNode *)Arena_node(&arena, 2))->value == 31);
+        assert(arena.peak == 2 + 4 + 16 + 64 + 256);
+
+        // The kept tree grows on, and is kept again.
+        ArenaIndex leaf = arena.used - 1;
+        assert(growTree(&arena, leaf, 2, 1) == 2);
+        root = Arena_keep(&arena, ((TestNode *)Arena_node(&arena, root))->link.children + 3);
+        assert(root == 1 && arena.used == 2 + 4 + 16 + 2);
+        assert(((TestNode *)Arena_node(&arena, root))->value == 34);
+
+        // A bulk reset, and a full arena refuses more.
+        Arena_reset(&arena);
+        assert(arena.used == 1);
+        assert(Arena_alloc(&arena, arena.capacity - 1) == 1);
+        assert(Arena_alloc(&arena, 1) == ARENA_NULL);
+        Arena_free(&arena);
+    }
+    Arena arena;
+    assert(!Arena_init(&arena, 2, 100, false));
+}
+
+void TTable_test(void) {
+    puts("Testing TTable...");
+    TTable table;
+    assert(TTable_init(&table, 4, false));
+    assert(table.perBucket == 8 && table.stride == 8);
+    TTable_setValues(&table, 3);
+    assert(table.perBucket == 5 && table.stride == 12);
+    TTable_setValues(&table, 1);
+
+    // Keys that share bucket 5 and differ in their tags.
+    uint64_t keys[10];
+    for (int i = 0; i < 10; ++i) {
+        keys[i] = ((uint64_t)(i + 1) << 48) | 5;
+    }
+    bool found;
+    TTEntry *entry = TTable_probe(&table, keys[0], &found);
+    assert(!found && entry->depth == 0);
+    assert((uint8_t *)entry == TTable_bucket(&table, keys[0]));
+    for (int i = 0; i < 8; ++i) {
+        int value = -i;
+        entry = TTable_probe(&table, keys[i], &found);
+        assert(!found);
+        TTable_store(&table, entry, keys[i], i, 1 + i, BOUND_LOWER, &value);
+    }
+    entry = TTable_probe(&table, keys[3], &found);
+    assert(found && entry->move == 3 && entry->depth == 4 && entry->values[0] == -3);
+    assert(TTEntry_bound(entry) == BOUND_LOWER);
+
+    // A full bucket gives up its shallowest entry, and then an old one
+    // over a fresh one, deeper as the old one may be.
+    entry = TTable_probe(&table, keys[8], &found);
+    assert(!found && entry->move == 0);
+    int value = 8;
+    TTable_store(&table, entry, keys[8], 8, 6, BOUND_EXACT, &value);
+    TTable_probe(&table, keys[0], &found);
+    assert(!found);
+    TTable_newSearch(&table);
+    TTable_newSearch(&table);
+    for (int i = 1; i < 8; ++i) {
+        entry = TTable_probe(&table, keys[i], &found);
+        assert(found);
+        TTable_store(&table, entry, keys[i], i, 1, BOUND_EXACT, &value);
+    }
+    entry = TTable_probe(&table, keys[9], &found);
+    assert(!found && entry->move == 8);
+
+    TTable_clear(&table);
+    TTable_probe(&table, keys[3], &found);
+    assert(!found);
+    TTable_free(&table);
+
+    assert(TTable_init(&table, 10, true));
+    printf("huge pages from the pool %d\n", table.hugeMapped);
+    TTable_free(&table);
 }
 
 int main(void) {
     Cards_test();
     Pile_test();
     Table_test();
+    Play_test();
     Game_test();
+    Eval_test();
+    Potential_test();
+    Search_test();
+    TopTurns_test();
+    Model_test();
+    EvalCache_test();
+    Record_test();
+    Position_test();
+    Analyze_test();
+    Book_test();
+    Plan_test();
+    Endgame_test();
+    Lookahead_test();
+    Protocol_test();
+    Rumbot_test();
+    Trace_test();
+    Histogram_test();
+    Batch_test();
+    Kernels_test();
+    Suits_test();
+    Arena_test();
+    TTable_test();
     printf("All tests passed.\n");
     return 0;
-}
\ No newline at end of file
+}
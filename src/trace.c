@@ -0,0 +1,124 @@
+#include <pthread.h>
+#include <stdlib.h>
+#include "cards.h"
+#include "trace.h"
+
+atomic_int Trace_runLevel = TRACE_OFF;
+_Thread_local TraceRing *Trace_ring = NULL;
+
+static pthread_key_t ringKey;
+static pthread_once_t ringKeyOnce = PTHREAD_ONCE_INIT;
+
+static void freeRing(void *ring) {
+    free(ring);
+}
+
+static void createRingKey(void) {
+    pthread_key_create(&ringKey, freeRing);
+}
+
+// Allocates the calling thread's ring.  The ring is freed when the thread
+// exits.
+TraceRing *Trace_newRing(void) {
+    pthread_once(&ringKeyOnce, createRingKey);
+    TraceRing *ring = malloc(sizeof(TraceRing));
+    if (!ring) {
+        return NULL;
+    }
+    ring->head = 0;
+    ring->flushed = 0;
+    pthread_setspecific(ringKey, ring);
+    Trace_ring = ring;
+    return ring;
+}
+
+void Trace_setLevel(int level) {
+    atomic_store_explicit(&Trace_runLevel, level, memory_order_relaxed);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//    Formatting
+//
+
+typedef enum { ARG_NONE, ARG_CARDS, ARG_INT, ARG_STRING } ArgType;
+
+typedef struct {
+    const char *name;
+    const char *value;  // name of the value field, NULL if unused
+    const char *argNames[4];
+    ArgType argTypes[4];
+} EventFormat;
+
+static const EventFormat kEventFormat[TRACE_EV_COUNT] = {
+    [TRACE_EV_SEARCH_START] = { "search-start", NULL,
+        { "hand", "drawpile", "discardpile", NULL },
+        { ARG_CARDS, ARG_INT, ARG_INT, ARG_NONE } },
+    [TRACE_EV_SEARCH_END] = { "search-end", "eval",
+        { "nodes", "ns", NULL, NULL },
+        { ARG_INT, ARG_INT, ARG_NONE, ARG_NONE } },
+    [TRACE_EV_LEAF] = { "leaf", "eval",
+        { "hand", "runs", "sets", "discard" },
+        { ARG_CARDS, ARG_CARDS, ARG_CARDS, ARG_CARDS } },
+    [TRACE_EV_ANSWER] = { "answer", "eval",
+        { "by", NULL, NULL, NULL },
+        { ARG_STRING, ARG_NONE, ARG_NONE, ARG_NONE } },
+    [TRACE_EV_MESSAGE] = { "message", NULL,
+        { "text", NULL, NULL, NULL },
+        { ARG_STRING, ARG_NONE, ARG_NONE, ARG_NONE } },
+};
+
+static const char *kLevelName[] = { "off", "error", "info", "debug", "leaf" };
+
+static void printCards(FILE *out, Cards cards) {
+    if (cards == 0) {
+        fputc('-', out);
+    }
+    for (Cards c = Cards_low(cards); c != 0; c = Cards_next(cards, c)) {
+        fputs(Card_name(Cards_toCard(c)), out);
+    }
+}
+
+static void printRecord(FILE *out, const TraceRecord *r) {
+    const EventFormat *format = &kEventFormat[r->event];
+    fprintf(out, "trace %s %s", kLevelName[r->level], format->name);
+    for (int i = 0; i < 4 && format->argNames[i]; ++i) {
+        fprintf(out, " %s=", format->argNames[i]);
+        switch (format->argTypes[i]) {
+        case ARG_CARDS:
+            printCards(out, r->args[i]);
+            break;
+        case ARG_INT:
+            fprintf(out, "%llu", (unsigned long long)r->args[i]);
+            break;
+        case ARG_STRING:
+            fputs((const char *)(uintptr_t)r->args[i], out);
+            break;
+        case ARG_NONE:
+            break;
+        }
+    }
+    if (format->value) {
+        fprintf(out, " %s=%d", format->value, r->value);
+    }
+    fputc('\n', out);
+}
+
+// Prints the records written since the last flush, oldest first.  Records
+// overwritten before they could be flushed are reported as dropped.
+void Trace_flush(FILE *out) {
+    TraceRing *ring = Trace_ring;
+    if (!ring) {
+        return;
+    }
+    uint64_t first = ring->flushed;
+    if (ring->head - first > TRACE_RING_SIZE) {
+        first = ring->head - TRACE_RING_SIZE;
+        fprintf(out, "trace dropped %llu\n", (unsigned long long)(first - ring->flushed));
+    }
+    for (uint64_t i = first; i < ring->head; ++i) {
+        printRecord(out, &ring->records[i & (TRACE_RING_SIZE - 1)]);
+    }
+    ring->flushed = ring->head;
+    fflush(out);
+}
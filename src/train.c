@@ -0,0 +1,508 @@
+// Trains and scores the learned evaluation (include/model.h).
+//
+//   train selfplay <games> <samples> [seed]
+//       plays games between hand-tuned players and records, after every
+//       turn, the mover's features and the points they went on to score
+//   train fit <samples> <model>
+//       fits the linear model to the samples by ridge regression and writes
+//       it quantized to int8
+//   train compare <model> <games> [seed]
+//       plays each deal once with the model in every seat against
+//       hand-tuned players, and times both evaluations
+//   train record <games> <records> [seed]
+//       plays games between hand-tuned players and writes them as binary
+//       game records (include/record.h)
+//   train replay <records>
+//       replays every game of a record file and checks it can be played
+//   train book <book> [<deals> [seed]]
+//       solves first turns with one thread per CPU and writes them as an
+//       opening book (include/book.h): every canonical first turn, or only
+//       those of the given number of seeded deals
+//
+// Games follow the batch simulator's ending: a game is over when a player
+// goes out, when the stock is empty at the start of a turn, or when the
+// player to move has no legal turn; every player then loses the points
+// left in hand.
+
+#include <limits.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "book.h"
+#include "eval.h"
+#include "game.h"
+#include "model.h"
+#include "record.h"
+#include "search.h"
+
+#define MAX_TURNS 400
+#define RIDGE 1.0
+#define BOOK_BLOCK 65536   // positions solved between writes
+
+typedef struct SampleStruct {
+    uint64_t features[MODEL_WORDS];
+    int32_t target;   // points the mover scored from here to the end
+    int32_t unused;
+} Sample;
+
+// Plays out a seeded deal with evaluators[p] in seat p and returns the
+// number of turns played.  If samples is not NULL, one sample per turn is
+// written there, targets included; if writer is not NULL, the game is
+// recorded.
+static int playGame(uint64_t seed, const Evaluator *evaluators[MAX_PLAYERS],
+                    Search *search, Sample *samples, RecordWriter *writer,
+                    int finalScores[MAX_PLAYERS]) {
+    Game game;
+    SearchLimits limits;
+    SearchLimits_init(&limits);
+    Game_initSeeded(&game, seed);
+    int movers[MAX_TURNS], turns = 0;
+    if (writer) {
+        RecordWriter_game(writer, seed, game.numPlayers, limits.nodes);
+    }
+
+    while (turns < MAX_TURNS && Pile_size(&game.drawPile) > 0) {
+        int mover = game.currentPlayer;
+        search->evaluator = evaluators[mover];
+        Search_start(search, &game, &limits);
+        Search_run(search);
+        if (search->best.eval == INT_MIN) {
+            break;
+        }
+        Game_play(&game, &search->best);
+        if (writer) {
+            RecordWriter_turn(writer, mover, &game.players[mover].turn);
+        }
+        if (samples) {
+            Model_features(&game, mover, samples[turns].features);
+            samples[turns].target = -game.players[mover].score;
+        }
+        movers[turns++] = mover;
+        if (game.players[mover].hand == 0) {
+            break;
+        }
+    }
+
+    for (int p = 0; p < game.numPlayers; ++p) {
+        finalScores[p] = game.players[p].score - Cards_points(game.players[p].hand);
+    }
+    for (int t = 0; samples && t < turns; ++t) {
+        samples[t].target += finalScores[movers[t]];
+    }
+    return turns;
+}
+
+static int selfPlay(int games, const char *path, uint64_t seed) {
+    FILE *out = fopen(path, "wb");
+    if (!out) {
+        perror(path);
+        return 1;
+    }
+    const Evaluator *evaluators[MAX_PLAYERS];
+    for (int p = 0; p < DEFAULT_PLAYERS; ++p) {
+        evaluators[p] = &Eval_handTuned;
+    }
+    Search search;
+    Search_init(&search);
+    Sample samples[MAX_TURNS];
+    int scores[MAX_PLAYERS];
+    long total = 0;
+    for (int g = 0; g < games; ++g) {
+        int turns = playGame(seed + g, evaluators, &search, samples, NULL, scores);
+        fwrite(samples, sizeof(Sample), turns, out);
+        total += turns;
+    }
+    fclose(out);
+    printf("%d games, %ld samples\n", games, total);
+    return 0;
+}
+
+// Solves a x = b for symmetric positive definite a (n by n), in place.
+static bool cholesky(double *a, double *b, int n) {
+    for (int j = 0; j < n; ++j) {
+        double d = a[j * n + j];
+        for (int k = 0; k < j; ++k) {
+            d -= a[j * n + k] * a[j * n + k];
+        }
+        if (d <= 0) {
+            return false;
+        }
+        a[j * n + j] = sqrt(d);
+        for (int i = j + 1; i < n; ++i) {
+            double s = a[i * n + j];
+            for (int k = 0; k < j; ++k) {
+                s -= a[i * n + k] * a[j * n + k];
+            }
+            a[i * n + j] = s / a[j * n + j];
+        }
+    }
+    for (int i = 0; i < n; ++i) {
+        for (int k = 0; k < i; ++k) {
+            b[i] -= a[i * n + k] * b[k];
+        }
+        b[i] /= a[i * n + i];
+    }
+    for (int i = n - 1; i >= 0; --i) {
+        for (int k = i + 1; k < n; ++k) {
+            b[i] -= a[k * n + i] * b[k];
+        }
+        b[i] /= a[i * n + i];
+    }
+    return true;
+}
+
+static int fit(const char *samplesPath, const char *modelPath) {
+    FILE *in = fopen(samplesPath, "rb");
+    if (!in) {
+        perror(samplesPath);
+        return 1;
+    }
+    const int n = MODEL_INPUTS + 1;   // the last unknown is the bias
+    double *a = calloc((size_t)n * n, sizeof(double));
+    double *b = calloc(n, sizeof(double));
+    if (!a || !b) {
+        fprintf(stderr, "train: out of memory\n");
+        return 1;
+    }
+
+    Sample sample;
+    long count = 0;
+    double sumSquares = 0;
+    while (fread(&sample, sizeof(sample), 1, in) == 1) {
+        int active[MODEL_INPUTS + 1], numActive = 0;
+        for (int w = 0; w < MODEL_WORDS; ++w) {
+            for (uint64_t bits = sample.features[w]; bits != 0; bits &= bits - 1) {
+                active[numActive++] = 64 * w + __builtin_ctzll(bits);
+            }
+        }
+        active[numActive++] = MODEL_INPUTS;
+        for (int i = 0; i < numActive; ++i) {
+            b[active[i]] += sample.target;
+            for (int j = 0; j < numActive; ++j) {
+                a[active[i] * n + active[j]] += 1;
+            }
+        }
+        sumSquares += (double)sample.target * sample.target;
+        count++;
+    }
+    fclose(in);
+    for (int i = 0; i < n; ++i) {
+        a[i * n + i] += RIDGE;
+    }
+    if (count == 0 || !cholesky(a, b, n)) {
+        fprintf(stderr, "train: cannot fit %ld samples\n", count);
+        return 1;
+    }
+
+    // Quantize: the largest weight maps to 127.
+    double largest = 0;
+    for (int i = 0; i < MODEL_INPUTS; ++i) {
+        largest = fmax(largest, fabs(b[i]));
+    }
+    double step = largest > 0 ? largest / 127 : 1;
+    Model model;
+    for (int i = 0; i < MODEL_INPUTS; ++i) {
+        model.weights[i] = (int8_t)lround(b[i] / step);
+    }
+    model.bias = (int32_t)lround(b[MODEL_INPUTS] / step);
+    model.scale = (int32_t)fmax(1, lround(step * (1 << MODEL_SCALE_BITS)));
+
+    FILE *out = fopen(modelPath, "w");
+    if (!out) {
+        perror(modelPath);
+        return 1;
+    }
+    Model_save(&model, out);
+    fclose(out);
+    printf("%ld samples, rms target %.2f, step %.4f\n", count, sqrt(sumSquares / count), step);
+    free(a);
+    free(b);
+    return 0;
+}
+
+// Nanoseconds per call of evaluator->discards over positions from fresh
+// deals, the first player to move holding eight cards.
+static double nsPerEval(const Evaluator *evaluator, uint64_t seed) {
+    enum { POSITIONS = 256, ROUNDS = 2000 };
+    static Game games[POSITIONS];
+    for (int i = 0; i < POSITIONS; ++i) {
+        Game_initSeeded(&games[i], seed + i);
+        Player_draw(Game_currentPlayer(&games[i]));
+    }
+    Discard best;
+    int64_t check = 0;
+    uint64_t start = Search_nowNs();
+    for (int r = 0; r < ROUNDS; ++r) {
+        for (int i = 0; i < POSITIONS; ++i) {
+            evaluator->discards(evaluator, &games[i], &best, 1);
+            check += best.eval;
+        }
+    }
+    uint64_t elapsed = Search_nowNs() - start;
+    if (check == INT64_MIN) {
+        printf("\n");   // keeps the calls from being optimized away
+    }
+    return (double)elapsed / ((double)POSITIONS * ROUNDS);
+}
+
+static int compare(const char *modelPath, int games, uint64_t seed) {
+    FILE *in = fopen(modelPath, "r");
+    Model model;
+    if (!in || !Model_load(&model, in)) {
+        fprintf(stderr, "train: cannot load model %s\n", modelPath);
+        return 1;
+    }
+    fclose(in);
+    Evaluator learned;
+    Model_evaluator(&model, &learned);
+
+    Search search;
+    Search_init(&search);
+    long modelPoints = 0, handTunedPoints = 0;
+    int modelWins = 0;
+    for (int g = 0; g < games; ++g) {
+        for (int seat = 0; seat < DEFAULT_PLAYERS; ++seat) {
+            const Evaluator *evaluators[MAX_PLAYERS];
+            int scores[MAX_PLAYERS];
+            for (int p = 0; p < DEFAULT_PLAYERS; ++p) {
+                evaluators[p] = p == seat ? &learned : &Eval_handTuned;
+            }
+            playGame(seed + g, evaluators, &search, NULL, NULL, scores);
+            bool best = true;
+            for (int p = 0; p < DEFAULT_PLAYERS; ++p) {
+                if (p == seat) {
+                    modelPoints += scores[p];
+                } else {
+                    handTunedPoints += scores[p];
+                    best &= scores[seat] > scores[p];
+                }
+            }
+            modelWins += best;
+        }
+    }
+    int seats = games * DEFAULT_PLAYERS;
+    printf("strength: model %.2f points/game, handtuned %.2f points/game, model wins %.1f%%\n",
+           (double)modelPoints / seats, (double)handTunedPoints / (seats * (DEFAULT_PLAYERS - 1)),
+           100.0 * modelWins / seats);
+    printf("speed: model %.1f ns/eval, handtuned %.1f ns/eval\n",
+           nsPerEval(&learned, seed), nsPerEval(&Eval_handTuned, seed));
+    return 0;
+}
+
+static int record(int games, const char *path, uint64_t seed) {
+    FILE *out = fopen(path, "wb");
+    if (!out) {
+        perror(path);
+        return 1;
+    }
+    const Evaluator *evaluators[MAX_PLAYERS];
+    for (int p = 0; p < DEFAULT_PLAYERS; ++p) {
+        evaluators[p] = &Eval_handTuned;
+    }
+    static RecordWriter writer;
+    RecordWriter_init(&writer, out);
+    Search search;
+    Search_init(&search);
+    int scores[MAX_PLAYERS];
+    for (int g = 0; g < games; ++g) {
+        playGame(seed + g, evaluators, &search, NULL, &writer, scores);
+    }
+    bool ok = RecordWriter_flush(&writer);
+    if (fclose(out) != 0 || !ok) {
+        fprintf(stderr, "train: cannot write %s\n", path);
+        return 1;
+    }
+    printf("%llu games, %llu turns\n", (unsigned long long)writer.games,
+           (unsigned long long)writer.turns);
+    return 0;
+}
+
+static int replay(const char *path) {
+    RecordReader reader;
+    const char *error = RecordReader_open(&reader, path);
+    if (error) {
+        fprintf(stderr, "train: %s: %s\n", path, error);
+        return 1;
+    }
+    RecordGame record;
+    Game game;
+    long games = 0, turns = 0, bad = 0;
+    uint64_t start = Search_nowNs();
+    while (RecordReader_nextGame(&reader, &record)) {
+        error = Record_replay(&record, &game);
+        if (error) {
+            fprintf(stderr, "train: game %ld: %s\n", games, error);
+            bad++;
+        }
+        games++;
+        turns += record.numTurns;
+    }
+    double seconds = (double)(Search_nowNs() - start) / 1e9;
+    RecordReader_close(&reader);
+    printf("%ld games, %ld turns replayed in %.3f s (%.0f turns/s), %ld bad\n",
+           games, turns, seconds, turns / seconds, bad);
+    return bad == 0 ? 0 : 1;
+}
+
+typedef struct BookJobStruct {
+    const uint64_t *keys;
+    BookEntry *entries;
+    int count;
+    atomic_int next;
+} BookJob;
+
+static void *solveThread(void *arg) {
+    BookJob *job = arg;
+    Search search;
+    Game game;
+    Search_init(&search);
+    for (int i; (i = atomic_fetch_add(&job->next, 1)) < job->count;) {
+        Book_solve(&search, &game, DEFAULT_PLAYERS, job->keys[i], &job->entries[i]);
+    }
+    return NULL;
+}
+
+static void solveBlock(BookJob *job, int threads) {
+    pthread_t workers[threads];
+    int started = 0;
+    atomic_store(&job->next, 0);
+    while (started < threads && pthread_create(&workers[started], NULL, solveThread, job) == 0) {
+        started++;
+    }
+    if (started == 0) {
+        solveThread(job);
+    }
+    for (int i = 0; i < started; ++i) {
+        pthread_join(workers[i], NULL);
+    }
+}
+
+static int compareKeys(const void *a, const void *b) {
+    uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+    return x < y ? -1 : x > y;
+}
+
+// The keys of the first turns of seeded deals, sorted, without repeats.
+static uint64_t *dealKeys(int deals, uint64_t seed, int *count) {
+    uint64_t *keys = malloc((deals > 0 ? deals : 1) * sizeof(uint64_t));
+    Game game;
+    uint8_t perm[NUM_SUITS];
+    int n = 0;
+    for (int g = 0; keys && g < deals; ++g) {
+        Game_initSeeded(&game, seed + g);
+        n += Book_key(&game, &keys[n], perm);
+    }
+    if (keys && n > 0) {
+        qsort(keys, n, sizeof(uint64_t), compareKeys);
+        int unique = 1;
+        for (int i = 1; i < n; ++i) {
+            if (keys[i] != keys[unique - 1]) {
+                keys[unique++] = keys[i];
+            }
+        }
+        n = unique;
+    }
+    *count = n;
+    return keys;
+}
+
+// The next key to solve: from the deals if there are any, else from the
+// cursor over every canonical first turn.
+static bool nextKey(BookCursor *cursor, const uint64_t *dealt, int numDealt, int *used,
+                    uint64_t *key) {
+    if (!dealt) {
+        return BookCursor_next(cursor, key);
+    }
+    if (*used == numDealt) {
+        return false;
+    }
+    *key = dealt[(*used)++];
+    return true;
+}
+
+static int book(const char *path, int deals, uint64_t seed) {
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    int threads = cpus > 0 ? (int)cpus : 1;
+    int numDealt = 0, used = 0;
+    uint64_t *dealt = deals > 0 ? dealKeys(deals, seed, &numDealt) : NULL;
+    static uint64_t keys[BOOK_BLOCK];
+    static BookEntry entries[BOOK_BLOCK];
+    FILE *out = fopen(path, "wb");
+    if (!out || (deals > 0 && !dealt)) {
+        perror(path);
+        return 1;
+    }
+
+    // The header is written again at the end, with the count.
+    BookHeader header;
+    BookHeader_init(&header, DEFAULT_PLAYERS, 0);
+    bool ok = fwrite(&header, sizeof(header), 1, out) == 1;
+    BookCursor cursor;
+    BookCursor_init(&cursor);
+    uint64_t count = 0;
+    uint64_t start = Search_nowNs();
+    while (ok) {
+        BookJob job = { .keys = keys, .entries = entries, .count = 0 };
+        while (job.count < BOOK_BLOCK &&
+               nextKey(&cursor, dealt, numDealt, &used, &keys[job.count])) {
+            job.count++;
+        }
+        if (job.count == 0) {
+            break;
+        }
+        solveBlock(&job, threads);
+        ok = fwrite(entries, sizeof(BookEntry), job.count, out) == (size_t)job.count;
+        count += job.count;
+        if (count % (64 * BOOK_BLOCK) == 0) {
+            fprintf(stderr, "%llu positions\n", (unsigned long long)count);
+        }
+    }
+    BookHeader_init(&header, DEFAULT_PLAYERS, count);
+    ok = ok && fseek(out, 0, SEEK_SET) == 0 && fwrite(&header, sizeof(header), 1, out) == 1;
+    if (fclose(out) != 0 || !ok) {
+        fprintf(stderr, "train: cannot write %s\n", path);
+        return 1;
+    }
+    free(dealt);
+    double seconds = (double)(Search_nowNs() - start) / 1e9;
+    printf("%llu positions in %.3f s: %.0f positions/s (%d threads)\n",
+           (unsigned long long)count, seconds, count / seconds, threads);
+    return 0;
+}
+
+static int usage(void) {
+    fprintf(stderr,
+            "usage: train selfplay <games> <samples> [seed]\n"
+            "       train fit <samples> <model>\n"
+            "       train compare <model> <games> [seed]\n"
+            "       train record <games> <records> [seed]\n"
+            "       train replay <records>\n"
+            "       train book <book> [<deals> [seed]]\n");
+    return 2;
+}
+
+int main(int argc, char **argv) {
+    if (argc >= 4 && strcmp(argv[1], "selfplay") == 0) {
+        uint64_t seed = argc > 4 ? strtoull(argv[4], NULL, 10) : 1;
+        return selfPlay(atoi(argv[2]), argv[3], seed);
+    } else if (argc == 4 && strcmp(argv[1], "fit") == 0) {
+        return fit(argv[2], argv[3]);
+    } else if (argc >= 4 && strcmp(argv[1], "compare") == 0) {
+        uint64_t seed = argc > 4 ? strtoull(argv[4], NULL, 10) : 1000000;
+        return compare(argv[2], atoi(argv[3]), seed);
+    } else if (argc >= 4 && strcmp(argv[1], "record") == 0) {
+        uint64_t seed = argc > 4 ? strtoull(argv[4], NULL, 10) : 1;
+        return record(atoi(argv[2]), argv[3], seed);
+    } else if (argc == 3 && strcmp(argv[1], "replay") == 0) {
+        return replay(argv[2]);
+    } else if (argc >= 3 && strcmp(argv[1], "book") == 0) {
+        uint64_t seed = argc > 4 ? strtoull(argv[4], NULL, 10) : 1;
+        return book(argv[2], argc > 3 ? atoi(argv[3]) : 0, seed);
+    }
+    return usage();
+}
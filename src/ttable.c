@@ -0,0 +1,68 @@
+#include <string.h>
+#include "pages.h"
+#include "ttable.h"
+
+bool TTable_init(TTable *table, int bits, bool hugePages) {
+    memset(table, 0, sizeof(*table));
+    table->bits = bits;
+    table->hugePages = hugePages;
+    table->size = (size_t)TTABLE_BUCKET << bits;
+    if (hugePages) {
+        table->size = (table->size + PAGES_HUGE - 1) & ~(PAGES_HUGE - 1);
+    }
+    table->buckets = Pages_map(table->size, hugePages, &table->hugeMapped);
+    // The mapping is zeroed, and so empty, already.
+    table->numValues = 1;
+    table->stride = (int)sizeof(TTEntry) + (int)sizeof(int16_t);
+    table->perBucket = TTABLE_BUCKET / table->stride;
+    return table->buckets != NULL;
+}
+
+void TTable_free(TTable *table) {
+    Pages_unmap(table->buckets, table->size);
+    table->buckets = NULL;
+}
+
+void TTable_clear(TTable *table) {
+    if (table->buckets) {
+        memset(table->buckets, 0, table->size);
+    }
+}
+
+void TTable_setValues(TTable *table, int numValues) {
+    if (numValues == table->numValues) {
+        return;
+    }
+    table->numValues = numValues;
+    table->stride = (int)sizeof(TTEntry) + numValues * (int)sizeof(int16_t);
+    table->perBucket = TTABLE_BUCKET / table->stride;
+    TTable_clear(table);
+}
+
+// Entries are only emptied all at once, and fill in order, so the first
+// empty entry ends the bucket.
+TTEntry *TTable_probe(TTable *table, uint64_t key, bool *found) {
+    uint8_t *bucket = TTable_bucket(table, key);
+    uint16_t tag = (uint16_t)(key >> 48);
+    TTEntry *replace = NULL;
+    int worth = 0;
+    for (int i = 0; i < table->perBucket; ++i) {
+        TTEntry *entry = (TTEntry *)(bucket + i * table->stride);
+        if (entry->depth == 0) {
+            *found = false;
+            return entry;
+        }
+        if (entry->tag == tag) {
+            *found = true;
+            return entry;
+        }
+        int age = (table->age - (entry->ageBound >> 2)) & 63;
+        int value = entry->depth - TTABLE_AGE_WEIGHT * age;
+        if (!replace || value < worth) {
+            replace = entry;
+            worth = value;
+        }
+    }
+    *found = false;
+    return replace;
+}
@@ -17,6 +17,105 @@ int Turn_max(Turn *best, Turn *scratch) {
     return best->eval;
 }
 
+int Turn_format(const Turn *turn, char *buf) {
+    char *out = buf;
+    if (turn->taken.size == 0) {
+        out += sprintf(out, "draw");
+    } else {
+        out += sprintf(out, "take %d", turn->taken.size);
+    }
+    out += sprintf(out, " runs ");
+    out = Cards_write(turn->meld.runs, out);
+    out += sprintf(out, " sets ");
+    out = Cards_write(turn->meld.sets, out);
+    out += sprintf(out, " discard ");
+    out = Cards_write(turn->discard, out);
+    out += sprintf(out, " eval %d", turn->eval);
+    return (int)(out - buf);
+}
+
+void TopTurns_init(TopTurns *top, int k) {
+    top->k = k < 1 ? 1 : k > TURN_MAX_TOP ? TURN_MAX_TOP : k;
+    top->size = 0;
+    top->offered = 0;
+}
+
+// Whether the turn in slot i ranks below the one in slot j.
+static bool worse(const TopTurns *top, int i, int j) {
+    const TopTurn *a = &top->turns[i], *b = &top->turns[j];
+    return a->eval < b->eval || (a->eval == b->eval && a->order > b->order);
+}
+
+// The heap holds slot numbers, so that sifting moves no turns.
+void TopTurns_add(TopTurns *top, const Turn *turn) {
+    if (!TopTurns_admits(top, turn->eval)) {
+        return;
+    }
+    // The same turn is evaluated the same.
+    int taken = turn->taken.size;
+    for (int i = 0; i < top->size; ++i) {
+        const TopTurn *kept = &top->turns[i];
+        if (kept->eval == turn->eval && kept->discard == turn->discard && kept->runs == turn->meld.runs &&
+            kept->sets == turn->meld.sets && kept->taken == taken) {
+            return;
+        }
+    }
+    uint64_t order = top->offered++;
+    // A free slot, or the worst turn's.
+    uint8_t *heap = top->heap;
+    bool full = top->size == top->k;
+    int slot = full ? heap[0] : top->size++;
+    top->turns[slot] = (TopTurn){ turn->meld.runs, turn->meld.sets, turn->draw, turn->discard,
+                                  taken, turn->eval, order };
+    int i;
+    if (!full) {
+        for (i = slot; i > 0 && worse(top, slot, heap[(i - 1) / 2]); i = (i - 1) / 2) {
+            heap[i] = heap[(i - 1) / 2];
+        }
+    } else {
+        for (i = 0;;) {
+            int child = 2 * i + 1;
+            if (child >= top->size) {
+                break;
+            }
+            if (child + 1 < top->size && worse(top, heap[child + 1], heap[child])) {
+                child++;
+            }
+            if (!worse(top, heap[child], slot)) {
+                break;
+            }
+            heap[i] = heap[child];
+            i = child;
+        }
+    }
+    heap[i] = (uint8_t)slot;
+}
+
+int TopTurns_sorted(const TopTurns *top, const Pile *discardPile, Turn *out) {
+    int index[TURN_MAX_TOP];
+    for (int i = 0; i < top->size; ++i) {
+        int j = i;
+        for (; j > 0 && worse(top, index[j - 1], i); --j) {
+            index[j] = index[j - 1];
+        }
+        index[j] = i;
+    }
+    for (int i = 0; i < top->size; ++i) {
+        const TopTurn *kept = &top->turns[index[i]];
+        Turn *turn = &out[i];
+        Turn_init(turn);
+        for (int t = 0; t < kept->taken; ++t) {
+            Pile_push(&turn->taken, discardPile->cards[discardPile->size - 1 - t]);
+        }
+        turn->draw = kept->draw;
+        turn->meld.runs = kept->runs;
+        turn->meld.sets = kept->sets;
+        turn->discard = kept->discard;
+        turn->eval = kept->eval;
+    }
+    return top->size;
+}
+
 void Turn_print(Turn *turn) {
     printf("Taken: ");
     Pile_print(&turn->taken);
@@ -24,6 +123,7 @@ void Turn_print(Turn *turn) {
     Cards_print(turn->draw);
     printf("\nDiscard: ");
     Cards_print(turn->discard);
+    printf("\n");
     Table_print(&turn->meld);
     printf("Eval: %d\n", turn->eval);
 }